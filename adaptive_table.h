@@ -0,0 +1,367 @@
+#ifndef ADAPTIVE_TABLE
+#define ADAPTIVE_TABLE
+
+#include <vector>
+#include <iostream>
+#include <cstdint>
+
+#include "functions.h"
+#include "hash_functions.h"
+#include "hash_tables.h"
+
+using namespace std;
+
+/*
+Tabla hash cerrada por userId que elige sola su secuencia de prueba.
+
+linear_probing con h1 es la más rápida cuando los userId están repartidos al azar, pero los ids snowflake de un
+mismo milisegundo son números seguidos y caen en espacios seguidos: las rachas se juntan en clusters largos y
+cada busqueda recorre muchos espacios. La tabla compara los intentos que hace cada operación con los que haría
+con un hash aleatorio al mismo factor de carga (Knuth), y si durante una ventana de operaciones hace más de
+ADAPTIVE_THRESHOLD veces lo esperado pasa a la siguiente estrategia de ADAPTIVE_STRATEGIES.
+
+El cambio se hace de a poco, sin detener la tabla: se crea un arreglo nuevo con la estrategia nueva y cada
+operación mueve ADAPTIVE_MIGRATION_STEP espacios del arreglo antiguo al nuevo. Mientras tanto los inserts van al
+arreglo nuevo y las busquedas revisan el nuevo y después el antiguo.
+*/
+
+/**
+ * @brief Estrategia de prueba de AdaptiveHashTableUserId.
+ */
+struct ProbeStrategy
+{
+    const char *name;                                    ///< Nombre para los tests.
+    int (*hashing_method)(unsigned long long, int, int); ///< Función de hash (intento i).
+};
+
+/// Estrategias en el orden en que se prueban: la primera es la más rápida con claves al azar, las siguientes
+/// rompen los clusters de claves seguidas (double hashing con h1, y linear probing sobre mix64).
+const vector<ProbeStrategy> ADAPTIVE_STRATEGIES = {
+    {"linear", linear_probing}, {"double", double_hashing}, {"mixed linear", mixed_linear_probing}};
+
+const int ADAPTIVE_WINDOW = 4096;        ///< Operaciones que se miran antes de decidir si cambiar de estrategia.
+const double ADAPTIVE_THRESHOLD = 2.0;   ///< Se cambia con más de este múltiplo de los intentos esperados.
+const int ADAPTIVE_MIGRATION_STEP = 64;  ///< Espacios del arreglo antiguo que se mueven en cada operación.
+
+/**
+ * @brief Tabla hash cerrada por userId que cambia de estrategia de prueba cuando sus claves forman clusters.
+ *
+ * Igual que ProbingHashTable, cada espacio guarda la posición (32 bits) del usuario en rows.
+ *
+ * @note La tabla no copia los usuarios: guarda su posición en el vector rows, que debe vivir más que la tabla.
+ */
+class AdaptiveHashTableUserId
+{
+public:
+    static constexpr uint32_t EMPTY = 0xffffffff;   ///< Espacio que nunca se ha usado.
+    static constexpr uint32_t DELETED = 0xfffffffe; ///< Espacio de un usuario eliminado.
+
+    int max_size;            ///< Tamaño de la tabla hash (de cada arreglo).
+    int size = 0;            ///< Cantidad de usuarios en la tabla.
+    int totalCollisions = 0; ///< Espacios ocupados que se saltaron al insertar.
+    int tombstones = 0;      ///< Eliminados en el arreglo actual.
+    size_t strategy;         ///< Estrategia actual (posición en ADAPTIVE_STRATEGIES).
+    bool adaptive;           ///< Si cambia de estrategia sola, con false se comporta como una tabla fija.
+    int switches = 0;        ///< Veces que cambió de estrategia.
+    long long probes = 0;    ///< Espacios revisados por todas las operaciones.
+    long long operations = 0; ///< Operaciones hechas (insert, search y remove).
+    vector<User> *rows;      ///< Usuarios a los que apuntan los espacios.
+    HugePageVector<uint32_t> slots; ///< Posición del usuario en rows, EMPTY o DELETED.
+
+    /**
+     * @brief Constructor de la tabla.
+     * @param size Tamaño de la tabla hash.
+     * @param rows Vector con los usuarios, insert recibe posiciones de este vector.
+     * @param strategy Estrategia inicial (posición en ADAPTIVE_STRATEGIES).
+     * @param adaptive Si cambia de estrategia sola.
+     */
+    AdaptiveHashTableUserId(int size, vector<User> &rows, size_t strategy = 0, bool adaptive = true)
+        : max_size(size), strategy(strategy), adaptive(adaptive), rows(&rows), slots(size, EMPTY) {}
+
+    /**
+     * @brief Inserta un usuario en el primer espacio vacío o eliminado de su secuencia de prueba.
+     * @param key userId del usuario.
+     * @param row Posición del usuario en rows.
+     */
+    void insert(unsigned long long key, uint32_t row)
+    {
+        TRACE_OPERATION("AdaptiveHashTableUserId::insert");
+        migrate_step();
+        double expected = expected_miss_probes();
+        int (*hashing_method)(unsigned long long, int, int) = ADAPTIVE_STRATEGIES[strategy].hashing_method;
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int index = TRACED("hash", hashing_method(key, max_size, i));
+            if (slots[index] >= DELETED)
+            {
+                if (slots[index] == DELETED)
+                    tombstones--;
+                slots[index] = row;
+                size++;
+                totalCollisions += i;
+                record(i + 1, expected);
+                return;
+            }
+        }
+        record(MAX_ATTEMPTS, expected);
+        cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+    }
+
+    /**
+     *@brief Devuelve el numero total de colisiones que hubo en la tabla.
+     */
+    int getCollision()
+    {
+        return totalCollisions;
+    }
+
+    /**
+     * @brief Busca un usuario en la tabla hash por su ID.
+     * @return Puntero al usuario dentro de rows, nullptr si no se encontró.
+     */
+    User *search(unsigned long long userId)
+    {
+        TRACE_OPERATION("AdaptiveHashTableUserId::search");
+        migrate_step();
+        int index = locate(userId);
+        if (index >= 0)
+            return &(*rows)[slots[index]];
+        index = locate_old(userId);
+        return index >= 0 ? &(*rows)[old_slots[index]] : nullptr;
+    }
+
+    /**
+     * @brief Elimina un usuario de la tabla por su ID, si no existe no hace nada.
+     */
+    void remove(unsigned long long userId)
+    {
+        TRACE_OPERATION("AdaptiveHashTableUserId::remove");
+        migrate_step();
+        int index = locate(userId);
+        if (index >= 0)
+        {
+            slots[index] = DELETED;
+            tombstones++;
+            size--;
+            return;
+        }
+        index = locate_old(userId);
+        if (index >= 0)
+        {
+            old_slots[index] = DELETED;
+            size--;
+        }
+    }
+
+    /**
+     * @brief Si todavía hay usuarios en el arreglo de la estrategia anterior.
+     */
+    bool migrating() const
+    {
+        return old_method != nullptr;
+    }
+
+    /**
+     * @brief Nombre de la estrategia actual.
+     */
+    const char *strategy_name() const
+    {
+        return ADAPTIVE_STRATEGIES[strategy].name;
+    }
+
+    /**
+     * @brief Espacios revisados por operación, desde que se creó la tabla.
+     */
+    double average_probes() const
+    {
+        return operations ? (double)probes / operations : 0;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por la estructura de datos en bytes.
+     */
+    size_t get_memory_usage()
+    {
+        size_t count = 0;
+        // considerando el tamaño promedio de un usuario en memoria de 70 bytes
+        int user_size = 70;
+
+        count += (slots.size() + old_slots.size()) * sizeof(uint32_t);
+        count += size * user_size;
+        // espacio usado por el resto de variables
+        count += sizeof(max_size);
+        count += sizeof(size);
+
+        return count;
+    }
+
+private:
+    HugePageVector<uint32_t> old_slots;                               ///< Arreglo de la estrategia anterior.
+    int (*old_method)(unsigned long long, int, int) = nullptr;        ///< Función de old_slots, nullptr si no hay.
+    size_t migrated = 0;     ///< Espacios de old_slots ya movidos.
+    int stranded = 0;        ///< Usuarios que no cupieron en el arreglo actual y siguen en old_slots.
+    size_t pending_strategy = 0; ///< Estrategia a la que se cambia en la siguiente operación, 0 si no hay cambio.
+    int window_operations = 0;
+    double window_probes = 0;   ///< Intentos de las operaciones de la ventana.
+    double window_expected = 0; ///< Intentos que habrían hecho con un hash aleatorio.
+
+    /**
+     * @brief Intentos esperados de un insert o una busqueda fallida con un hash aleatorio al factor de carga
+     * actual (contando los eliminados): (1 + 1 / (1 - a)^2) / 2.
+     */
+    double expected_miss_probes() const
+    {
+        double load = min(0.99, (double)(size + tombstones) / max_size);
+        return (1 + 1 / ((1 - load) * (1 - load))) / 2;
+    }
+
+    /**
+     * @brief Intentos esperados de una busqueda exitosa con un hash aleatorio: (1 + 1 / (1 - a)) / 2.
+     */
+    double expected_hit_probes() const
+    {
+        double load = min(0.99, (double)(size + tombstones) / max_size);
+        return (1 + 1 / (1 - load)) / 2;
+    }
+
+    /**
+     * @brief Posición de key en slots, -1 si no está. Registra los intentos para decidir si cambiar de estrategia.
+     */
+    int locate(unsigned long long key)
+    {
+        int (*hashing_method)(unsigned long long, int, int) = ADAPTIVE_STRATEGIES[strategy].hashing_method;
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int index = TRACED("hash", hashing_method(key, max_size, i));
+            uint32_t row = slots[index];
+            if (row == EMPTY)
+            {
+                record(i + 1, expected_miss_probes());
+                return -1;
+            }
+            if (row != DELETED && TRACED("compare", (*rows)[row].userId == key))
+            {
+                record(i + 1, expected_hit_probes());
+                return index;
+            }
+        }
+        record(MAX_ATTEMPTS, expected_miss_probes());
+        return -1;
+    }
+
+    /**
+     * @brief Posición de key en old_slots, -1 si no está o si no hay migración en curso.
+     */
+    int locate_old(unsigned long long key)
+    {
+        if (!old_method)
+            return -1;
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int index = TRACED("hash", old_method(key, max_size, i));
+            uint32_t row = old_slots[index];
+            if (row == EMPTY)
+                return -1;
+            if (row != DELETED && TRACED("compare", (*rows)[row].userId == key))
+                return index;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Suma los intentos de una operación a la ventana y, al completarla, deja pendiente el cambio de
+     * estrategia si la tabla hizo más de ADAPTIVE_THRESHOLD veces los intentos esperados. El cambio se hace al
+     * inicio de la siguiente operación (migrate_step), porque la operación actual todavía usa su espacio en slots.
+     */
+    void record(int attempts, double expected)
+    {
+        probes += attempts;
+        operations++;
+        // durante una migración los intentos mezclan dos arreglos, no sirven para juzgar la estrategia nueva
+        if (!adaptive || migrating() || pending_strategy || strategy + 1 >= ADAPTIVE_STRATEGIES.size())
+            return;
+        window_probes += attempts;
+        window_expected += expected;
+        if (++window_operations < ADAPTIVE_WINDOW)
+            return;
+        if (window_probes > ADAPTIVE_THRESHOLD * window_expected)
+            pending_strategy = strategy + 1;
+        window_operations = 0;
+        window_probes = window_expected = 0;
+    }
+
+    /**
+     * @brief Empieza a mover los usuarios a un arreglo nuevo que usa la estrategia next.
+     */
+    void start_migration(size_t next)
+    {
+        TRACE_SPAN("start_migration");
+        old_method = ADAPTIVE_STRATEGIES[strategy].hashing_method;
+        // mismo allocator, así el arreglo nuevo usa las mismas páginas que el anterior
+        HugePageVector<uint32_t> fresh(max_size, EMPTY, slots.get_allocator());
+        old_slots.swap(slots);
+        slots.swap(fresh);
+        strategy = next;
+        tombstones = 0;
+        migrated = 0;
+        stranded = 0;
+        switches++;
+    }
+
+    /**
+     * @brief Mueve los siguientes ADAPTIVE_MIGRATION_STEP espacios de old_slots al arreglo actual. Los movidos
+     * quedan como eliminados para no cortar las secuencias de prueba de los que faltan. Antes empieza la
+     * migración pendiente, si record() dejó una.
+     *
+     * Un usuario que no cabe en MAX_ATTEMPTS intentos en el arreglo actual se queda en old_slots (search y remove
+     * lo siguen encontrando ahí). Si al terminar quedó alguno, old_slots no se libera y la tabla deja de cambiar
+     * de estrategia.
+     */
+    void migrate_step()
+    {
+        if (pending_strategy)
+        {
+            start_migration(pending_strategy);
+            pending_strategy = 0;
+        }
+        if (!old_method || migrated == (size_t)max_size)
+            return;
+        TRACE_SPAN("migrate_step");
+        int (*hashing_method)(unsigned long long, int, int) = ADAPTIVE_STRATEGIES[strategy].hashing_method;
+        size_t end = min<size_t>(migrated + ADAPTIVE_MIGRATION_STEP, max_size);
+        for (; migrated < end; migrated++)
+        {
+            uint32_t row = old_slots[migrated];
+            if (row >= DELETED)
+                continue;
+            unsigned long long key = (*rows)[row].userId;
+            int i = 0;
+            for (; i < MAX_ATTEMPTS; i++)
+            {
+                int index = hashing_method(key, max_size, i);
+                if (slots[index] >= DELETED)
+                {
+                    if (slots[index] == DELETED)
+                        tombstones--;
+                    slots[index] = row;
+                    // solo se saca de old_slots cuando ya tiene su espacio en el arreglo actual
+                    old_slots[migrated] = DELETED;
+                    break;
+                }
+            }
+            if (i == MAX_ATTEMPTS)
+                stranded++;
+        }
+        if (migrated < (size_t)max_size)
+            return;
+        if (stranded == 0)
+        {
+            HugePageVector<uint32_t>(0, EMPTY, slots.get_allocator()).swap(old_slots);
+            old_method = nullptr;
+        }
+        else
+            cout << stranded << " usuarios no cupieron en la estrategia nueva, se quedan en el arreglo anterior." << endl;
+    }
+};
+
+#endif
@@ -0,0 +1,63 @@
+#ifndef ALLOC_COUNTER
+#define ALLOC_COUNTER
+
+#include <cstdlib>
+#include <new>
+#include <atomic>
+
+using namespace std;
+
+/*
+Contador de reservas de memoria (llamadas a operator new), para medir cuántas reservas hace cada forma de insertar.
+Solo se activa compilando con -DCOUNT_ALLOCATIONS, ya que reemplaza el operator new global de todo el programa.
+*/
+
+#ifdef COUNT_ALLOCATIONS
+atomic<size_t> allocation_count(0); ///< Reservas hechas desde que empezó el programa.
+
+// noinline en new y delete: si el compilador ve el malloc y el free adentro, avisa (sin razón) que no se corresponden
+__attribute__((noinline)) void *operator new(size_t size)
+{
+    allocation_count.fetch_add(1, memory_order_relaxed);
+    void *pointer = malloc(size ? size : 1);
+    if (!pointer)
+        throw bad_alloc();
+    return pointer;
+}
+
+__attribute__((noinline)) void operator delete(void *pointer) noexcept
+{
+    free(pointer);
+}
+
+__attribute__((noinline)) void operator delete(void *pointer, size_t) noexcept
+{
+    free(pointer);
+}
+#endif
+
+/**
+ * @brief Si el programa se compiló contando reservas de memoria.
+ */
+bool counting_allocations()
+{
+#ifdef COUNT_ALLOCATIONS
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Reservas de memoria hechas hasta ahora, siempre 0 si no se compiló con -DCOUNT_ALLOCATIONS.
+ */
+size_t allocations()
+{
+#ifdef COUNT_ALLOCATIONS
+    return allocation_count.load(memory_order_relaxed);
+#else
+    return 0;
+#endif
+}
+
+#endif
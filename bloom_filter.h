@@ -0,0 +1,218 @@
+#ifndef BLOOM_FILTER
+#define BLOOM_FILTER
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+#include "functions.h"
+#include "hash_functions.h"
+#include "hash_tables.h"
+
+using namespace std;
+
+/**
+ * @brief Filtro de Bloom con contadores de 4 bits, dividido en bloques de 64 bytes (una linea de cache).
+ *
+ * Cada clave elige un solo bloque con su hash y marca BLOOM_HASHES contadores dentro de él, por lo que
+ * responder si una clave "puede estar" lee una sola linea de cache. Al ser contadores (y no bits) se pueden
+ * eliminar claves; un contador que llega a 15 queda saturado y ya no se decrementa, para no generar falsos negativos.
+ */
+class CountingBloomFilter
+{
+public:
+    static constexpr int COUNTERS_PER_BLOCK = 128; ///< 128 contadores de 4 bits = 64 bytes.
+    static constexpr int BLOOM_HASHES = 6;         ///< Contadores que marca cada clave.
+
+    /**
+     * @brief Bloque del filtro, alineado para que ocupe exactamente una linea de cache.
+     */
+    struct alignas(64) Block
+    {
+        uint8_t counters[COUNTERS_PER_BLOCK / 2]; ///< Dos contadores de 4 bits por byte.
+    };
+
+    size_t n_blocks;     ///< Cantidad de bloques.
+    vector<Block> blocks; ///< Bloques del filtro.
+
+    /**
+     * @brief Constructor del filtro.
+     * @param expected_keys Cantidad de claves que se espera guardar.
+     * @param counters_per_key Contadores por clave, con 12 se tiene cerca de 1% de falsos positivos.
+     */
+    CountingBloomFilter(size_t expected_keys, int counters_per_key = 12)
+        : n_blocks(max((size_t)1, expected_keys * counters_per_key / COUNTERS_PER_BLOCK + 1)), blocks(n_blocks)
+    {
+        memset(blocks.data(), 0, n_blocks * sizeof(Block));
+    }
+
+    /**
+     * @brief Agrega una clave al filtro.
+     * @param hash Hash de 64 bits de la clave (UserKey<Key>::hash).
+     */
+    void add(unsigned long long hash)
+    {
+        Block &block = blocks[block_of(hash)];
+        unsigned long long positions = positions_of(hash);
+        for (int j = 0; j < BLOOM_HASHES; j++)
+        {
+            int counter = (positions >> (7 * j)) & (COUNTERS_PER_BLOCK - 1);
+            int value = get(block, counter);
+            if (value < 15)
+                set(block, counter, value + 1);
+        }
+    }
+
+    /**
+     * @brief Quita una clave del filtro, solo se debe llamar con claves que fueron agregadas.
+     * @param hash Hash de 64 bits de la clave.
+     */
+    void remove(unsigned long long hash)
+    {
+        Block &block = blocks[block_of(hash)];
+        unsigned long long positions = positions_of(hash);
+        for (int j = 0; j < BLOOM_HASHES; j++)
+        {
+            int counter = (positions >> (7 * j)) & (COUNTERS_PER_BLOCK - 1);
+            int value = get(block, counter);
+            if (value > 0 && value < 15)
+                set(block, counter, value - 1);
+        }
+    }
+
+    /**
+     * @brief Revisa si la clave puede estar en el filtro.
+     * @param hash Hash de 64 bits de la clave.
+     * @return false si la clave seguro no esta, true si puede estar (con probabilidad de falso positivo).
+     */
+    bool may_contain(unsigned long long hash) const
+    {
+        const Block &block = blocks[block_of(hash)];
+        unsigned long long positions = positions_of(hash);
+        for (int j = 0; j < BLOOM_HASHES; j++)
+        {
+            int counter = (positions >> (7 * j)) & (COUNTERS_PER_BLOCK - 1);
+            if (get(block, counter) == 0)
+                return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por el filtro en bytes.
+     */
+    size_t get_memory_usage()
+    {
+        return n_blocks * sizeof(Block) + sizeof(n_blocks);
+    }
+
+private:
+    /// Bloque de la clave, se usa la multiplicación en vez del módulo para llevar los 32 bits altos a [0, n_blocks).
+    size_t block_of(unsigned long long hash) const
+    {
+        return (size_t)(((hash >> 32) * n_blocks) >> 32);
+    }
+
+    /// Los 32 bits bajos se vuelven a mezclar para sacar 7 bits por cada contador.
+    static unsigned long long positions_of(unsigned long long hash)
+    {
+        return mix64(hash & 0xffffffffULL);
+    }
+
+    static int get(const Block &block, int counter)
+    {
+        return (block.counters[counter >> 1] >> ((counter & 1) * 4)) & 0xf;
+    }
+
+    static void set(Block &block, int counter, int value)
+    {
+        int shift = (counter & 1) * 4;
+        block.counters[counter >> 1] = (block.counters[counter >> 1] & ~(0xf << shift)) | (value << shift);
+    }
+};
+
+/**
+ * @brief Pone un CountingBloomFilter delante de cualquier tabla hash de usuarios.
+ *
+ * Las busquedas de claves que no estan se rechazan en el filtro (una lectura de memoria) sin tocar la tabla.
+ * El filtro se mantiene sincronizado con insert y remove.
+ *
+ * @tparam Table Tabla hash con insert(key, User *), search(key) y remove(key), por ejemplo CloseHashTableUserId.
+ * @tparam Key unsigned long long para tablas por userId, string para tablas por userName.
+ */
+template <typename Table, typename Key>
+class BloomFilteredTable
+{
+public:
+    Table table;                ///< Tabla hash que esta detrás del filtro.
+    CountingBloomFilter filter; ///< Filtro de claves insertadas.
+    size_t rejected = 0;        ///< Busquedas que el filtro respondio sin tocar la tabla.
+    size_t false_positives = 0; ///< Busquedas que pasaron el filtro y no estaban en la tabla.
+
+    /**
+     * @brief Constructor, los parametros despues de expected_keys se le pasan al constructor de la tabla.
+     * @param expected_keys Cantidad de claves que se espera guardar, se usa para el tamaño del filtro.
+     */
+    template <typename... TableArgs>
+    BloomFilteredTable(size_t expected_keys, TableArgs &&...table_args)
+        : table(forward<TableArgs>(table_args)...), filter(expected_keys) {}
+
+    /**
+     * @brief Inserta un usuario en la tabla y su clave en el filtro.
+     */
+    void insert(const Key &key, User *user_data)
+    {
+        table.insert(key, user_data);
+        filter.add(UserKey<Key>::hash(key));
+    }
+
+    /**
+     * @brief Busca un usuario, si el filtro dice que no esta no se revisa la tabla.
+     * @return Puntero al usuario, nullptr si no se encontro.
+     */
+    User *search(const Key &key)
+    {
+        if (!filter.may_contain(UserKey<Key>::hash(key)))
+        {
+            rejected++;
+            return nullptr;
+        }
+        User *user = table.search(key);
+        if (!user)
+            false_positives++;
+        return user;
+    }
+
+    /**
+     * @brief Elimina un usuario de la tabla y su clave del filtro, si no existe no hace nada.
+     */
+    void remove(const Key &key)
+    {
+        if (table.search(key))
+        {
+            Key copy = key;
+            table.remove(copy);
+            filter.remove(UserKey<Key>::hash(key));
+        }
+    }
+
+    /**
+     * @brief Proporción de busquedas de claves inexistentes que el filtro no logró rechazar.
+     */
+    double false_positive_rate()
+    {
+        size_t negatives = rejected + false_positives;
+        return negatives == 0 ? 0.0 : (double)false_positives / negatives;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por la tabla y el filtro en bytes.
+     */
+    size_t get_memory_usage()
+    {
+        return table.get_memory_usage() + filter.get_memory_usage();
+    }
+};
+
+#endif
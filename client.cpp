@@ -0,0 +1,227 @@
+#include <vector>
+#include <string>
+#include <thread>
+#include <chrono>
+#include <random>
+#include <algorithm>
+#include <fstream>
+
+#include "functions.h"
+#include "protocol.h"
+
+using namespace std;
+
+/*
+Generador de carga para server.cpp: abre varias conexiones (un hilo cada una) y en cada una manda los pedidos
+de a grupos de pipeline pedidos sin esperar respuesta. La latencia de un pedido es el tiempo entre que se
+envió su grupo y que llegó su respuesta. Al final muestra pedidos por segundo y percentiles de latencia, y
+agrega una fila a tests/test_servidor.csv.
+
+Pedidos: de las lecturas, 40% GET por userId, 40% GET por userName, 10% GET de un userId que no existe y
+10% MGET de 16 userId. De las escrituras, la mitad son PUT (el usuario con un tweet más) y la mitad DEL.
+
+Compilación: g++ client.cpp -O2 -pthread -o client
+Uso: ./client [direccion] [conexiones] [pipeline] [pedidos por conexión] [porcentaje de escrituras]
+    por defecto: unix:/tmp/entregable2.sock 4 16 200000 5
+*/
+
+const int MGET_KEYS = 16; ///< Claves por MGET.
+
+/**
+ * @brief Resultados de una conexión.
+ */
+struct ClientResult
+{
+    vector<double> latencies_us; ///< Latencia de cada pedido.
+    size_t found = 0;            ///< Respuestas STATUS_OK.
+    size_t not_found = 0;        ///< Respuestas STATUS_NOT_FOUND.
+    size_t errors = 0;           ///< Otras respuestas.
+    bool failed = false;         ///< Si se cortó la conexión antes de terminar.
+};
+
+/**
+ * @brief Agrega al final de out un pedido elegido al azar.
+ */
+void random_request(string &out, mt19937_64 &rng, const vector<User> &users, const vector<User> &missing,
+                    int write_percent)
+{
+    size_t frame = begin_frame(out);
+    const User &user = users[rng() % users.size()];
+    int kind = rng() % 100;
+    if (kind < write_percent)
+    {
+        if (kind % 2 == 0)
+        {
+            User updated = user;
+            updated.numberTweets++;
+            put_value<uint8_t>(out, OP_PUT);
+            put_user(out, updated);
+        }
+        else
+        {
+            put_value<uint8_t>(out, OP_DEL);
+            put_key(out, {KEY_ID, user.userId, ""});
+        }
+    }
+    else
+    {
+        kind = rng() % 10;
+        if (kind < 4)
+        {
+            put_value<uint8_t>(out, OP_GET);
+            put_key(out, {KEY_ID, user.userId, ""});
+        }
+        else if (kind < 8)
+        {
+            put_value<uint8_t>(out, OP_GET);
+            put_key(out, {KEY_NAME, 0, user.userName});
+        }
+        else if (kind < 9)
+        {
+            put_value<uint8_t>(out, OP_GET);
+            put_key(out, {KEY_ID, missing[rng() % missing.size()].userId, ""});
+        }
+        else
+        {
+            put_value<uint8_t>(out, OP_MGET);
+            put_value<uint32_t>(out, MGET_KEYS);
+            for (int i = 0; i < MGET_KEYS; i++)
+                put_key(out, {KEY_ID, users[rng() % users.size()].userId, ""});
+        }
+    }
+    end_frame(out, frame);
+}
+
+/**
+ * @brief Una conexión: manda n_requests pedidos de a pipeline y espera cada grupo de respuestas.
+ */
+void run_connection(const string &address, int n_requests, int pipeline, int write_percent, unsigned seed,
+                    const vector<User> &users, const vector<User> &missing, ClientResult &result)
+{
+    int fd = connect_to(address);
+    if (fd < 0)
+    {
+        result.failed = true;
+        return;
+    }
+    mt19937_64 rng(seed);
+    result.latencies_us.reserve(n_requests);
+    string requests, input;
+    vector<char> chunk(64 << 10);
+
+    for (int done = 0; done < n_requests && !result.failed;)
+    {
+        int batch = min(pipeline, n_requests - done);
+        requests.clear();
+        for (int i = 0; i < batch; i++)
+            random_request(requests, rng, users, missing, write_percent);
+
+        auto sent = chrono::steady_clock::now();
+        if (!write_all(fd, requests.data(), requests.size()))
+        {
+            result.failed = true;
+            break;
+        }
+
+        int answered = 0;
+        size_t pos = 0;
+        while (answered < batch)
+        {
+            const char *body;
+            uint32_t length;
+            int frame = next_frame(input, pos, body, length);
+            if (frame == 1)
+            {
+                uint8_t status = length > 0 ? body[0] : (uint8_t)STATUS_BAD_REQUEST;
+                result.found += status == STATUS_OK;
+                result.not_found += status == STATUS_NOT_FOUND;
+                result.errors += status != STATUS_OK && status != STATUS_NOT_FOUND;
+                result.latencies_us.push_back(
+                    chrono::duration<double, micro>(chrono::steady_clock::now() - sent).count());
+                answered++;
+                continue;
+            }
+            ssize_t received = frame < 0 ? -1 : recv(fd, chunk.data(), chunk.size(), 0);
+            if (received <= 0)
+            {
+                result.failed = true;
+                break;
+            }
+            input.erase(0, pos);
+            pos = 0;
+            input.append(chunk.data(), received);
+        }
+        input.erase(0, pos);
+        done += batch;
+    }
+    close(fd);
+}
+
+/**
+ * @brief Valor en el percentil p (entre 0 y 1) de un vector ordenado.
+ */
+double percentile(const vector<double> &sorted, double p)
+{
+    if (sorted.empty())
+        return 0;
+    return sorted[min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+}
+
+int main(int argc, char *argv[])
+{
+  string address = argc > 1 ? argv[1] : "unix:/tmp/entregable2.sock";
+  int n_connections = argc > 2 ? stoi(argv[2]) : 4;
+  int pipeline = argc > 3 ? stoi(argv[3]) : 16;
+  int n_requests = argc > 4 ? stoi(argv[4]) : 200000;
+  int write_percent = argc > 5 ? stoi(argv[5]) : 5;
+
+  // los mismos archivos que usa main.cpp: usuarios que están en el servidor y usuarios que no
+  vector<User> users = readCSV("universities_followers_without_duplicates.csv");
+  vector<User> missing = readCSV("fake_data.csv");
+  if (users.empty() || missing.empty())
+    return 1;
+
+  vector<ClientResult> results(n_connections);
+  vector<thread> threads;
+  auto start = chrono::steady_clock::now();
+  for (int c = 0; c < n_connections; c++)
+  {
+    threads.emplace_back(run_connection, cref(address), n_requests, pipeline, write_percent, 1000 + c, cref(users),
+                         cref(missing), ref(results[c]));
+  }
+  for (thread &th : threads)
+    th.join();
+  double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+  vector<double> latencies;
+  size_t found = 0, not_found = 0, errors = 0;
+  bool failed = false;
+  for (ClientResult &result : results)
+  {
+    latencies.insert(latencies.end(), result.latencies_us.begin(), result.latencies_us.end());
+    found += result.found;
+    not_found += result.not_found;
+    errors += result.errors;
+    failed = failed || result.failed;
+  }
+  sort(latencies.begin(), latencies.end());
+  double qps = latencies.size() / seconds;
+
+  cout << "Pedidos: " << latencies.size() << " en " << seconds << " s (" << qps << " por segundo)" << endl;
+  cout << "Encontrados: " << found << ", no encontrados: " << not_found << ", errores: " << errors << endl;
+  cout << "Latencia (us) p50: " << percentile(latencies, 0.5) << ", p90: " << percentile(latencies, 0.9)
+       << ", p99: " << percentile(latencies, 0.99) << ", p99.9: " << percentile(latencies, 0.999)
+       << ", max: " << (latencies.empty() ? 0 : latencies.back()) << endl;
+  if (failed)
+    cout << "Alguna conexión se cortó antes de terminar." << endl;
+
+  ofstream file_out("tests/test_servidor.csv", ios::app);
+  file_out << "Dirección,Conexiones,Pipeline,Escrituras(%),Pedidos,Pedidos por segundo,p50(us),p90(us),p99(us),"
+              "p99.9(us)"
+           << endl;
+  file_out << address << "," << n_connections << "," << pipeline << "," << write_percent << "," << latencies.size()
+           << "," << qps << "," << percentile(latencies, 0.5) << "," << percentile(latencies, 0.9) << ","
+           << percentile(latencies, 0.99) << "," << percentile(latencies, 0.999) << endl;
+  file_out.close();
+  return failed ? 1 : 0;
+}
@@ -0,0 +1,406 @@
+#ifndef CONCURRENT_TABLE
+#define CONCURRENT_TABLE
+
+#include <vector>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <cstdint>
+#include <climits>
+#include <stdexcept>
+
+#include "functions.h"
+#include "hash_functions.h"
+#include "hash_tables.h"
+
+using namespace std;
+
+/*
+Tabla cerrada por userId que se puede usar desde varios hilos a la vez sin locks (LockFreeHashTableUserId), y la
+misma tabla cerrada de siempre protegida con un mutex (LockedHashTableUserId) para comparar.
+
+Cada espacio tiene una clave y un puntero, los dos atómicos. Un insert reclama un espacio vacío con CAS sobre la
+clave (EMPTY_KEY -> key) y después publica el usuario con CAS sobre el puntero (nullptr -> usuario). Una vez que un
+espacio tiene clave no la cambia nunca, por lo que las secuencias de prueba no se rompen y una busqueda solo lee:
+no toma locks ni reintenta, termina en a lo más MAX_ATTEMPTS intentos (wait-free).
+
+Eliminar deja la clave en su espacio y cambia el puntero a nullptr (el eliminado), y si la clave se vuelve a
+insertar usa el mismo espacio. Los eliminados no se compactan: si la tabla se llena de claves eliminadas hay que
+reconstruirla cuando nadie la esté usando.
+
+El usuario eliminado no se puede liberar de inmediato porque otro hilo puede estar leyéndolo. Se usa reclamación
+por épocas: cada operación anuncia la época global en el registro de su hilo mientras dura (EpochGuard), y el
+usuario eliminado se guarda con la época en que se eliminó. La época global solo avanza cuando todos los hilos
+dentro de una operación anunciaron la actual, así que un usuario eliminado en la época e se libera cuando la
+global llega a e + 2: ningún hilo puede seguir en una operación que empezó antes de eliminarlo.
+*/
+
+/**
+ * @brief Cantidad máxima de hilos usando tablas sin locks al mismo tiempo.
+ */
+const int EPOCH_MAX_THREADS = 256;
+
+/**
+ * @brief Cada cuantos usuarios eliminados por un hilo se intenta avanzar la época y liberar.
+ */
+const size_t EPOCH_COLLECT_EVERY = 64;
+
+/**
+ * @brief Número de registro de cada hilo vivo (en [0, EPOCH_MAX_THREADS)), se reutiliza cuando el hilo termina.
+ */
+atomic<bool> epoch_thread_used[EPOCH_MAX_THREADS];
+
+/**
+ * @brief Reserva el número del hilo la primera vez que lo pide y lo libera cuando el hilo termina.
+ */
+struct EpochThreadId
+{
+    int id = -1;
+
+    int get()
+    {
+        if (id < 0)
+        {
+            for (int i = 0; i < EPOCH_MAX_THREADS && id < 0; i++)
+            {
+                bool expected = false;
+                if (epoch_thread_used[i].compare_exchange_strong(expected, true, memory_order_acquire))
+                    id = i;
+            }
+            if (id < 0)
+                throw runtime_error("Hay más de EPOCH_MAX_THREADS hilos usando tablas sin locks.");
+        }
+        return id;
+    }
+
+    ~EpochThreadId()
+    {
+        if (id >= 0)
+            epoch_thread_used[id].store(false, memory_order_release);
+    }
+};
+
+thread_local EpochThreadId epoch_thread_id;
+
+/**
+ * @brief Épocas de una tabla sin locks: la época global y un registro por número de hilo.
+ */
+class EpochDomain
+{
+public:
+    /**
+     * @brief Registro de un hilo, en su propia linea de cache para que anunciar no invalide la de otros hilos.
+     * Solo su hilo escribe depth y retired (el siguiente hilo con el mismo número los hereda).
+     */
+    struct alignas(64) Record
+    {
+        atomic<uint64_t> announced{0};           ///< (época << 1) | 1 dentro de una operación, 0 fuera.
+        int depth = 0;                           ///< EpochGuard abiertos (se pueden anidar).
+        vector<pair<uint64_t, User *>> retired;  ///< Usuarios eliminados y la época en que se eliminaron.
+    };
+
+    atomic<uint64_t> epoch{1}; ///< Época global.
+    unique_ptr<Record[]> records = unique_ptr<Record[]>(new Record[EPOCH_MAX_THREADS]);
+
+    /**
+     * @brief Libera todos los usuarios eliminados, llamar solo cuando ningún hilo esté usando la tabla.
+     */
+    ~EpochDomain()
+    {
+        for (int i = 0; i < EPOCH_MAX_THREADS; i++)
+        {
+            for (auto &entry : records[i].retired)
+                delete entry.second;
+        }
+    }
+
+    /**
+     * @brief Anuncia la época actual en el registro del hilo (solo el EpochGuard más externo).
+     */
+    Record &enter()
+    {
+        Record &record = records[epoch_thread_id.get()];
+        if (record.depth++ == 0)
+        {
+            // release: quien vea este anuncio ya ve terminadas las lecturas de la operación anterior del hilo
+            record.announced.store(epoch.load(memory_order_relaxed) << 1 | 1, memory_order_release);
+            // el anuncio debe ser visible antes de leer la tabla
+            atomic_thread_fence(memory_order_seq_cst);
+        }
+        return record;
+    }
+
+    /**
+     * @brief Sale de la operación (solo el EpochGuard más externo la termina).
+     */
+    void exit(Record &record)
+    {
+        if (--record.depth == 0)
+            record.announced.store(0, memory_order_release);
+    }
+
+    /**
+     * @brief Guarda un usuario ya sacado de la tabla para liberarlo cuando ningún hilo pueda estar leyéndolo.
+     * Se llama dentro de un EpochGuard.
+     */
+    void retire(Record &record, User *user)
+    {
+        // seq_cst: la época leída no puede ser anterior al CAS que sacó al usuario de la tabla; si lo fuera, un
+        // lector que entró en la época siguiente y todavía lo ve quedaría protegido una época menos de lo necesario
+        atomic_thread_fence(memory_order_seq_cst);
+        record.retired.push_back({epoch.load(memory_order_seq_cst), user});
+        if (record.retired.size() % EPOCH_COLLECT_EVERY == 0)
+            collect(record);
+    }
+
+    /**
+     * @brief Intenta avanzar la época y libera los usuarios del hilo eliminados al menos dos épocas atrás.
+     */
+    void collect(Record &record)
+    {
+        try_advance();
+        uint64_t current = epoch.load(memory_order_acquire);
+        size_t kept = 0;
+        for (auto &entry : record.retired)
+        {
+            if (entry.first + 2 <= current)
+                delete entry.second;
+            else
+                record.retired[kept++] = entry;
+        }
+        record.retired.resize(kept);
+    }
+
+    /**
+     * @brief Avanza la época global si todos los hilos dentro de una operación anunciaron la actual.
+     */
+    void try_advance()
+    {
+        uint64_t current = epoch.load(memory_order_relaxed);
+        atomic_thread_fence(memory_order_seq_cst);
+        for (int i = 0; i < EPOCH_MAX_THREADS; i++)
+        {
+            // acquire: las lecturas de los hilos que ya salieron de su operación terminan antes de liberar
+            uint64_t announced = records[i].announced.load(memory_order_acquire);
+            if ((announced & 1) && (announced >> 1) != current)
+                return;
+        }
+        epoch.compare_exchange_strong(current, current + 1, memory_order_acq_rel, memory_order_relaxed);
+    }
+};
+
+/**
+ * @brief Marca que el hilo está dentro de una operación de la tabla mientras exista (RAII). Los punteros que
+ * devuelve search() siguen siendo válidos mientras el EpochGuard que recibió siga abierto.
+ */
+class EpochGuard
+{
+public:
+    EpochDomain &domain;
+    EpochDomain::Record &record;
+
+    EpochGuard(EpochDomain &domain) : domain(domain), record(domain.enter()) {}
+    EpochGuard(const EpochGuard &) = delete;
+    EpochGuard &operator=(const EpochGuard &) = delete;
+    ~EpochGuard() { domain.exit(record); }
+};
+
+/**
+ * @brief Tabla cerrada por userId para insertar, buscar y eliminar desde varios hilos sin locks.
+ * A diferencia de CloseHashTableUserId, una clave se guarda una sola vez (insert no reemplaza ni duplica).
+ */
+class LockFreeHashTableUserId
+{
+public:
+    /// Clave de un espacio que nunca se ha usado, no se puede usar como userId.
+    static constexpr unsigned long long EMPTY_KEY = ULLONG_MAX;
+
+    /**
+     * @brief Espacio de la tabla. Con clave y puntero nullptr es un eliminado.
+     */
+    struct Slot
+    {
+        atomic<unsigned long long> key{EMPTY_KEY};
+        atomic<User *> user{nullptr};
+    };
+
+    int max_size;                                        ///< Tamaño de la tabla hash.
+    int (*hashing_method)(unsigned long long, int, int); ///< Puntero a la función de hash.
+    unique_ptr<Slot[]> table;                            ///< Espacios de la tabla.
+    EpochDomain epochs;                                  ///< Épocas para liberar los usuarios eliminados.
+
+    /**
+     * @brief Constructor de la tabla.
+     * @param size Tamaño de la tabla hash.
+     * @param hashing_method Puntero a la función de hash que se usará.
+     */
+    LockFreeHashTableUserId(int size, int (*hashing_method)(unsigned long long, int, int) = linear_probing)
+        : max_size(size), hashing_method(hashing_method), table(new Slot[size]) {}
+
+    /**
+     * @brief Libera los usuarios de la tabla, ningún hilo debe estar usándola.
+     */
+    ~LockFreeHashTableUserId()
+    {
+        for (int i = 0; i < max_size; i++)
+            delete table[i].user.load(memory_order_relaxed);
+    }
+
+    /**
+     * @brief Abre un EpochGuard, para usar los punteros de varias busquedas sin que se liberen.
+     */
+    EpochGuard pin()
+    {
+        return EpochGuard(epochs);
+    }
+
+    /**
+     * @brief Inserta una copia del usuario si key no está en la tabla.
+     * @return true si se insertó, false si key ya estaba o no se encontró espacio en MAX_ATTEMPTS intentos.
+     */
+    bool insert(unsigned long long key, const User *user_data)
+    {
+        EpochGuard guard(epochs);
+        Slot *slot = claim(key);
+        if (!slot)
+            return false;
+        User *copy = new User(*user_data);
+        User *expected = nullptr;
+        if (slot->user.compare_exchange_strong(expected, copy, memory_order_release, memory_order_relaxed))
+            return true;
+        delete copy;
+        return false;
+    }
+
+    /**
+     * @brief Busca un usuario por su userId, sin locks ni reintentos.
+     * @param guard EpochGuard de esta tabla (pin()) que el llamador mantiene abierto mientras use el puntero.
+     * @return Puntero al usuario, nullptr si no está. Es válido mientras guard siga abierto.
+     */
+    User *search(unsigned long long key, const EpochGuard &guard)
+    {
+        (void)guard;
+        Slot *slot = find(key);
+        return slot ? slot->user.load(memory_order_acquire) : nullptr;
+    }
+
+    /**
+     * @brief Si hay un usuario con ese userId, sin devolver el puntero (que se podría liberar al salir).
+     */
+    bool contains(unsigned long long key)
+    {
+        EpochGuard guard(epochs);
+        return search(key, guard) != nullptr;
+    }
+
+    /**
+     * @brief Elimina el usuario con ese userId, se libera cuando ningún hilo pueda estar leyéndolo.
+     * @return true si estaba.
+     */
+    bool remove(unsigned long long key)
+    {
+        EpochGuard guard(epochs);
+        Slot *slot = find(key);
+        if (!slot)
+            return false;
+        User *old = slot->user.exchange(nullptr, memory_order_acq_rel);
+        if (!old)
+            return false;
+        epochs.retire(guard.record, old);
+        return true;
+    }
+
+    /**
+     * @brief Cantidad de usuarios en la tabla (recorre la tabla, es exacta solo si nadie está insertando o eliminando).
+     */
+    int size()
+    {
+        int count = 0;
+        for (int i = 0; i < max_size; i++)
+            count += table[i].user.load(memory_order_relaxed) != nullptr;
+        return count;
+    }
+
+    /**
+     * @brief Memoria usada por la tabla en bytes, sin contar los usuarios eliminados que esperan ser liberados.
+     */
+    size_t get_memory_usage()
+    {
+        size_t count = sizeof(*this) + sizeof(EpochDomain::Record) * EPOCH_MAX_THREADS + sizeof(Slot) * max_size;
+        return count + (sizeof(User) + 16) * size();
+    }
+
+private:
+    /**
+     * @brief Espacio con clave key, nullptr si se encuentra un espacio vacío antes o se acaban los intentos.
+     */
+    Slot *find(unsigned long long key)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            Slot &slot = table[hashing_method(key, max_size, i)];
+            unsigned long long current = slot.key.load(memory_order_acquire);
+            if (current == key)
+                return &slot;
+            if (current == EMPTY_KEY)
+                return nullptr;
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Espacio con clave key, si no está reclama el primer espacio vacío con CAS.
+     * @return nullptr si no hay espacio en MAX_ATTEMPTS intentos.
+     */
+    Slot *claim(unsigned long long key)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            Slot &slot = table[hashing_method(key, max_size, i)];
+            unsigned long long current = slot.key.load(memory_order_acquire);
+            // si otro hilo reclama el espacio primero, current queda con su clave (que puede ser la misma)
+            if (current == EMPTY_KEY &&
+                slot.key.compare_exchange_strong(current, key, memory_order_acq_rel, memory_order_acquire))
+                return &slot;
+            if (current == key)
+                return &slot;
+        }
+        return nullptr;
+    }
+};
+
+/**
+ * @brief CloseHashTableUserId protegida con un mutex, para comparar con LockFreeHashTableUserId.
+ * Igual que esta, una clave se guarda una sola vez.
+ */
+class LockedHashTableUserId
+{
+public:
+    mutex table_mutex;
+    CloseHashTableUserId table;
+
+    LockedHashTableUserId(int size, int (*hashing_method)(unsigned long long, int, int) = linear_probing)
+        : table(size, hashing_method) {}
+
+    bool insert(unsigned long long key, const User *user_data)
+    {
+        lock_guard<mutex> lock(table_mutex);
+        return table.try_emplace(key, *user_data).second;
+    }
+
+    bool contains(unsigned long long key)
+    {
+        lock_guard<mutex> lock(table_mutex);
+        return table.search(key) != nullptr;
+    }
+
+    bool remove(unsigned long long key)
+    {
+        lock_guard<mutex> lock(table_mutex);
+        int before = table.size;
+        table.remove(key);
+        return table.size < before;
+    }
+};
+
+#endif
@@ -0,0 +1,206 @@
+#ifndef DATA_GENERATOR
+#define DATA_GENERATOR
+
+#include <random>
+#include <string>
+#include <vector>
+#include <ctime>
+#include <cstdint>
+
+#include "functions.h"
+
+using namespace std;
+
+/*
+Generador nativo de usuarios sintéticos. Reemplaza a create_data.py cuando se necesitan
+millones de usuarios, las distribuciones fueron sacadas de universities_followers_without_duplicates.csv:
+  - ~32% de los userId son "snowflake" (> 10^15), el resto son ids antiguos (< 2^32).
+  - el largo de los userName va de 3 a 15 caracteres, con moda en 15 (maximo de twitter).
+  - pucv_cl tiene ~55% de los usuarios, el resto se reparte casi uniforme entre 10 universidades.
+  - las cuentas se crearon entre 2006 y 2020, con peaks en 2010 y 2019.
+*/
+
+// Universidades del dataset real, la primera es la que concentra la mayoria de los seguidores
+const vector<string> GENERATOR_UNIVERSITIES = {
+    "pucv_cl", "usach", "ucatolica_chile", "ubbchile", "uchile", "userena",
+    "udeconcepcion", "uvalpochile", "UFrontera", "usantamaria", "ucscconcepcion"};
+
+// Peso (en usuarios) de cada universidad en el dataset real, mismo orden que GENERATOR_UNIVERSITIES
+const vector<double> GENERATOR_UNIVERSITY_WEIGHTS = {11055, 960, 934, 922, 920, 888, 861, 860, 860, 834, 814};
+
+// Frecuencia del largo de userName en el dataset real, el indice es el largo (0 a 15)
+const vector<double> GENERATOR_NAME_LENGTH_WEIGHTS = {0, 0, 0, 2, 27, 127, 468, 1155, 1729, 2069, 2241, 2313, 2257, 2228, 2037, 3255};
+
+// Cantidad de cuentas creadas por año desde 2006 a 2020 en el dataset real
+const vector<double> GENERATOR_YEAR_WEIGHTS = {3, 23, 101, 2032, 3072, 2681, 1840, 1511, 1212, 987, 820, 824, 795, 2095, 1912};
+
+/**
+ * @brief Transforma un número a base 36 (0-9a-z), se usa como sufijo para que los userName sean únicos.
+ * @param n: número a transformar.
+ */
+string to_base36(unsigned long long n)
+{
+    const char *digits = "0123456789abcdefghijklmnopqrstuvwxyz";
+    string out;
+    do
+    {
+        out.insert(out.begin(), digits[n % 36]);
+        n /= 36;
+    } while (n > 0);
+    return out;
+}
+
+/**
+ * @brief Da formato de twitter a una fecha en epoch, por ejemplo "Thu Jul 28 07:16:49 +0000 2016".
+ * @param epoch: segundos desde 1970 en UTC.
+ */
+string format_created_at(long long epoch)
+{
+    time_t t = (time_t)epoch;
+    tm date;
+    gmtime_r(&t, &date);
+    char buffer[32];
+    strftime(buffer, sizeof(buffer), "%a %b %d %H:%M:%S +0000 %Y", &date);
+    return string(buffer);
+}
+
+// Cantidad de ids antiguos de cada carril: [10000, 2^32) partido en dos mitades
+const unsigned long long GENERATOR_OLD_ID_LANE = (4294967296ULL - 10000) / 2;
+
+/**
+ * @brief Permutación de [0, GENERATOR_OLD_ID_LANE) que depende de la semilla: red de Feistel de 4 rondas sobre
+ * 32 bits, repetida mientras el resultado quede fuera del rango (cycle walking, en promedio 2 veces).
+ * Al ser biyectiva, índices distintos dan ids distintos.
+ */
+unsigned long long permute_old_id(unsigned long long index, unsigned long long seed)
+{
+    do
+    {
+        uint32_t left = index >> 16, right = index & 0xffff;
+        for (unsigned long long round = 0; round < 4; round++)
+        {
+            unsigned long long mixed = (right ^ (seed << 8) ^ round) * 0x9e3779b97f4a7c15ULL;
+            uint32_t next = left ^ ((mixed >> 40) & 0xffff);
+            left = right;
+            right = next;
+        }
+        index = (unsigned long long)left << 16 | right;
+    } while (index >= GENERATOR_OLD_ID_LANE);
+    return index;
+}
+
+/**
+ * @brief Genera usuarios sintéticos que imitan la distribución del dataset real.
+ *
+ * Los userName son únicos (llevan como sufijo el indice del usuario en base 36). Los userId también, por
+ * construcción: los antiguos son el índice pasado por permute_old_id, y los snowflake llevan los 22 bits bajos
+ * del índice como secuencia y los 9 siguientes en los milisegundos. Cada carril usa ids distintos, así los
+ * usuarios del carril 1 (generate_missing_users) nunca están entre los del carril 0.
+ *
+ * @param n_users: cantidad de usuarios a generar (probado desde 10^4 hasta 10^8, a lo más 2^31).
+ * @param seed: semilla del generador, con la misma semilla se generan los mismos usuarios.
+ * @param lane: carril de los userId, 0 o 1.
+ * @return Vector con los usuarios generados.
+ */
+vector<User> generate_users(size_t n_users, unsigned long long seed = 42, unsigned lane = 0)
+{
+    mt19937_64 rng(seed);
+    discrete_distribution<int> university_dist(GENERATOR_UNIVERSITY_WEIGHTS.begin(), GENERATOR_UNIVERSITY_WEIGHTS.end());
+    discrete_distribution<int> length_dist(GENERATOR_NAME_LENGTH_WEIGHTS.begin(), GENERATOR_NAME_LENGTH_WEIGHTS.end());
+    discrete_distribution<int> year_dist(GENERATOR_YEAR_WEIGHTS.begin(), GENERATOR_YEAR_WEIGHTS.end());
+    bernoulli_distribution snowflake_dist(0.32);
+    uniform_int_distribution<long long> second_of_year(0, 365LL * 24 * 3600 - 1);
+    uniform_int_distribution<int> millisecond_dist(0, 999);
+    // Los contadores siguen una distribución de cola larga, igual que en los datos reales
+    lognormal_distribution<double> followers_dist(4.1, 1.8);
+    lognormal_distribution<double> tweets_dist(5.1, 2.2);
+    lognormal_distribution<double> friends_dist(5.5, 1.3);
+
+    // letras mas comunes en los userName reales, se repiten para darles más peso
+    const string alphabet = "aaaaeeeiiiooorrrnnllsscctudm_gpvb1hCz20AyMf97j8346PS5kRLEDVFJGNBITxOUqHKwYZWQX";
+    uniform_int_distribution<size_t> char_dist(0, alphabet.size() - 1);
+
+    // epoch del 1 de enero de 2006 y epoch de twitter (para los ids snowflake)
+    const long long EPOCH_2006 = 1136073600LL;
+    const long long TWITTER_EPOCH_MS = 1288834974657LL;
+
+    vector<User> users;
+    users.reserve(n_users);
+
+    for (size_t i = 0; i < n_users; i++)
+    {
+        long long created = EPOCH_2006 + (long long)(year_dist(rng) * 365.25 * 24 * 3600) + second_of_year(rng);
+
+        unsigned long long userId;
+        long long millisecond = created * 1000 + millisecond_dist(rng) - TWITTER_EPOCH_MS;
+        // desde 1024 ms el id queda sobre 2^32, lejos de los antiguos
+        if (snowflake_dist(rng) && millisecond >= 1024)
+        {
+            // id snowflake: milisegundos desde el epoch de twitter seguido de 22 bits de secuencia. Los 10 bits
+            // bajos de los milisegundos se reemplazan por el carril y los bits 22 a 30 del índice
+            millisecond = (millisecond & ~1023LL) | lane << 9 | ((i >> 22) & 511);
+            userId = (unsigned long long)millisecond << 22 | (i & ((1 << 22) - 1));
+        }
+        else
+        {
+            userId = 10000 + lane * GENERATOR_OLD_ID_LANE + permute_old_id(i, seed);
+        }
+
+        string suffix = to_base36(i);
+        int length = max((int)suffix.size() + 1, length_dist(rng));
+        string userName;
+        userName.reserve(length);
+        for (int c = 0; c < length - (int)suffix.size(); c++)
+        {
+            userName += alphabet[char_dist(rng)];
+        }
+        userName += suffix;
+
+        users.emplace_back(GENERATOR_UNIVERSITIES[university_dist(rng)], userId, userName,
+                           (int)min(tweets_dist(rng), 1e6), (int)min(friends_dist(rng), 5e5),
+                           (int)min(followers_dist(rng), 3e6), format_created_at(created));
+    }
+    return users;
+}
+
+/**
+ * @brief Genera usuarios que no están entre los de generate_users (sus userId son de otro carril), para
+ * buscar usuarios inexistentes.
+ * @param n_users: cantidad de usuarios a generar.
+ * @param seed: semilla del generador.
+ */
+vector<User> generate_missing_users(size_t n_users, unsigned long long seed = 7)
+{
+    return generate_users(n_users, seed, 1);
+}
+
+/**
+ * @brief Genera usuarios cuyos userId son ids snowflake seguidos, como los de cuentas creadas en ráfagas: en cada
+ * milisegundo se crean entre 1 y 64 cuentas con secuencias 0, 1, 2, ... (ids consecutivos). Con h1 estas rachas
+ * caen en espacios seguidos de la tabla y linear probing forma clusters largos.
+ *
+ * @param n_users: cantidad de usuarios a generar.
+ * @param worker: número de máquina (0 a 31) en los bits 17 a 21 del id. Con la misma semilla y otro worker se
+ * obtienen ids distintos de los mismos milisegundos, que sirven como usuarios inexistentes.
+ * @param seed: semilla del generador.
+ * @return Vector con los usuarios generados (los demás campos como en generate_users).
+ */
+vector<User> generate_sequential_users(size_t n_users, unsigned worker = 0, unsigned long long seed = 42)
+{
+    vector<User> users = generate_users(n_users, seed);
+    mt19937_64 rng(seed);
+    uniform_int_distribution<int> burst_dist(1, 64);
+    uniform_int_distribution<int> gap_dist(1, 3);
+    // milisegundos desde el epoch de twitter de mediados de 2015
+    unsigned long long millisecond = 150000000000ULL;
+    for (size_t i = 0; i < n_users;)
+    {
+        int burst = burst_dist(rng);
+        for (int seq = 0; seq < burst && i < n_users; seq++, i++)
+            users[i].userId = (millisecond << 22) | ((unsigned long long)(worker & 31) << 17) | seq;
+        millisecond += gap_dist(rng);
+    }
+    return users;
+}
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef DATE_INDEX
+#define DATE_INDEX
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+
+#include "functions.h"
+
+using namespace std;
+
+/**
+ * @brief Indice ordenado por fecha de creación de la cuenta (createdAtEpoch), para consultas por rango de fechas.
+ *
+ * Las fechas se guardan ordenadas en un arreglo con layout de Eytzinger (el arreglo representa un árbol binario
+ * completo guardado por niveles: los hijos de k son 2k y 2k+1). Así los primeros niveles de la busqueda quedan
+ * juntos en memoria y se puede hacer prefetch de los descendientes, a diferencia de una busqueda binaria
+ * sobre el arreglo ordenado que salta por todo el arreglo.
+ *
+ * count() responde en O(log n) y range() en O(log n + k), con k la cantidad de usuarios en el rango.
+ * El indice se construye una sola vez en el constructor, no soporta insert ni remove.
+ */
+class CreatedAtIndex
+{
+public:
+    int size = 0;              ///< Cantidad de usuarios en el indice.
+    const vector<User> *users; ///< Usuarios indexados, el indice guarda sus posiciones.
+    vector<int> sorted_rows;   ///< Posiciones de los usuarios ordenadas por fecha.
+    vector<long long> eytzinger; ///< Fechas en layout de Eytzinger, eytzinger[0] no se usa.
+    vector<int> eytzinger_rank;  ///< Para cada nodo de eytzinger, su posición en sorted_rows.
+
+    /**
+     * @brief Construye el indice sobre un vector de usuarios. El vector no debe modificarse mientras se use el indice.
+     * @param users Usuarios a indexar.
+     */
+    CreatedAtIndex(const vector<User> &users) : users(&users)
+    {
+        size = users.size();
+        sorted_rows.resize(size);
+        iota(sorted_rows.begin(), sorted_rows.end(), 0);
+        sort(sorted_rows.begin(), sorted_rows.end(), [&](int a, int b)
+             { return users[a].createdAtEpoch < users[b].createdAtEpoch; });
+
+        eytzinger.resize(size + 1);
+        eytzinger_rank.resize(size + 1);
+        int i = 0;
+        build(i, 1);
+    }
+
+    /**
+     * @brief Cantidad de usuarios creados en el rango [from, to] (ambos incluidos), en segundos desde 1970.
+     */
+    int count(long long from, long long to)
+    {
+        if (to < from)
+            return 0;
+        return lower_bound(to + 1) - lower_bound(from);
+    }
+
+    /**
+     * @brief Usuarios creados en el rango [from, to] (ambos incluidos), ordenados por fecha.
+     * @param limit: cantidad máxima de usuarios a devolver, -1 para devolverlos todos.
+     */
+    vector<const User *> range(long long from, long long to, int limit = -1)
+    {
+        vector<const User *> result;
+        if (to < from)
+            return result;
+
+        int first = lower_bound(from);
+        int last = lower_bound(to + 1);
+        if (limit >= 0)
+            last = min(last, first + limit);
+        result.reserve(last - first);
+        for (int i = first; i < last; i++)
+        {
+            result.push_back(&(*users)[sorted_rows[i]]);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por el indice en bytes (sin contar los usuarios).
+     */
+    size_t get_memory_usage()
+    {
+        size_t count = 0;
+        count += sorted_rows.size() * sizeof(int);
+        count += eytzinger.size() * sizeof(long long);
+        count += eytzinger_rank.size() * sizeof(int);
+        count += sizeof(size);
+        return count;
+    }
+
+private:
+    /**
+     * @brief Llena eytzinger recorriendo el árbol en inorden, así el nodo k recibe el i-ésimo elemento ordenado.
+     */
+    void build(int &i, int k)
+    {
+        if (k <= size)
+        {
+            build(i, 2 * k);
+            eytzinger[k] = (*users)[sorted_rows[i]].createdAtEpoch;
+            eytzinger_rank[k] = i;
+            i++;
+            build(i, 2 * k + 1);
+        }
+    }
+
+    /**
+     * @brief Posición en sorted_rows del primer usuario con fecha >= epoch (size si no hay ninguno).
+     */
+    int lower_bound(long long epoch)
+    {
+        int k = 1;
+        while (k <= size)
+        {
+            // los 16 descendientes de k a 4 niveles de distancia estan juntos (16 * 8 = 128 bytes, dos lineas de
+            // cache), se pide cada mitad de 64 bytes
+            __builtin_prefetch(eytzinger.data() + min(16 * k, size));
+            __builtin_prefetch(eytzinger.data() + min(16 * k + 8, size));
+            k = 2 * k + (eytzinger[k] < epoch);
+        }
+        // se sube por el árbol hasta el último nodo en que se fue a la izquierda
+        k >>= __builtin_ffs(~k);
+        return k == 0 ? size : eytzinger_rank[k];
+    }
+};
+
+#endif
@@ -0,0 +1,600 @@
+#ifndef DISK_HASH
+#define DISK_HASH
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <unordered_map>
+#include <iostream>
+#include <new>
+#include <stdexcept>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "functions.h"
+#include "hash_functions.h"
+#include "hash_tables.h"
+
+using namespace std;
+
+/*
+Hashing extensible en disco, para conjuntos de usuarios que no caben en memoria.
+
+Los usuarios se guardan en páginas de DISK_PAGE_SIZE bytes de un archivo. Un directorio en memoria de 2^global_depth
+entradas (4 bytes cada una) dice en qué página está cada hash: la entrada es hash & (2^global_depth - 1). Cuando
+una página se llena se divide en dos usando un bit más del hash (su local_depth), y si la página ya usaba todos
+los bits del directorio el directorio se duplica. Así ninguna operación lee más de una página.
+
+Las páginas se leen y escriben con pread/pwrite a través de un buffer pool de tamaño fijo: si la página no está
+en el pool se reemplaza la que elija el algoritmo del reloj (clock), escribiéndola antes si fue modificada.
+Con direct_io el archivo se abre con O_DIRECT, así las lecturas van al disco y no al cache del sistema (si el
+sistema de archivos no lo permite, por ejemplo tmpfs, se abre sin O_DIRECT).
+
+Formato de una página: count (2 bytes), end (2 bytes, donde termina el último registro), local_depth (1 byte),
+3 bytes de relleno y luego los registros seguidos. Cada registro es: largo (2), hash de la clave (8), userId (8),
+userName, university y createdAt (1 byte de largo + los caracteres, hasta 255), numberTweets, friendsCount y
+followersCount (4 cada uno).
+*/
+
+const size_t DISK_PAGE_SIZE = 4096;     ///< Bytes de una página (y de cada lectura o escritura).
+const size_t DISK_PAGE_HEADER = 8;      ///< Bytes del encabezado de una página.
+const int DISK_MAX_DEPTH = 22;          ///< Máximo de bits del hash que usa el directorio (2^22 entradas, 16 MB).
+
+/**
+ * @brief Buffer pool: guarda en memoria una cantidad fija de páginas de un archivo y elige cual reemplazar con
+ * el algoritmo del reloj (cada página tiene un bit de referencia que se apaga cuando pasa la manecilla; se
+ * reemplaza la primera sin referencia y sin pines).
+ */
+class BufferPool
+{
+public:
+    size_t reads = 0;  ///< Páginas leídas del archivo.
+    size_t writes = 0; ///< Páginas escritas al archivo.
+    size_t hits = 0;   ///< Pedidos de una página que ya estaba en el pool.
+    size_t misses = 0; ///< Pedidos que tuvieron que leer (o crear) la página.
+    bool direct_io;    ///< Si el archivo quedó abierto con O_DIRECT.
+
+    /**
+     * @param path Archivo de las páginas.
+     * @param n_frames Páginas que caben en memoria.
+     * @param create Si se trunca el archivo (true) o se abre el que existe.
+     * @param direct_io Si se intenta abrir con O_DIRECT.
+     */
+    BufferPool(const string &path, size_t n_frames, bool create, bool direct_io)
+        : direct_io(direct_io), frames(n_frames)
+    {
+        int flags = O_RDWR | O_CREAT | (create ? O_TRUNC : 0);
+        fd = direct_io ? open(path.c_str(), flags | O_DIRECT, 0644) : -1;
+        if (fd < 0)
+        {
+            this->direct_io = false;
+            fd = open(path.c_str(), flags, 0644);
+        }
+        if (fd < 0)
+            cout << "No se pudo abrir el archivo " << path << endl;
+        // O_DIRECT necesita memoria alineada al tamaño de bloque
+        data = (char *)::operator new(n_frames * DISK_PAGE_SIZE, align_val_t(DISK_PAGE_SIZE));
+    }
+
+    BufferPool(const BufferPool &) = delete;
+    BufferPool &operator=(const BufferPool &) = delete;
+
+    ~BufferPool()
+    {
+        flush();
+        if (fd >= 0)
+            close(fd);
+        ::operator delete(data, align_val_t(DISK_PAGE_SIZE));
+    }
+
+    /**
+     * @brief Deja la página en memoria y la fija (no se reemplaza hasta unpin()).
+     * @param fresh Si es una página nueva: no se lee del archivo, queda en 0.
+     * @return Puntero a los DISK_PAGE_SIZE bytes de la página.
+     */
+    char *pin(uint32_t page, bool fresh = false)
+    {
+        auto it = page_frames.find(page);
+        size_t frame;
+        if (it != page_frames.end())
+        {
+            hits++;
+            frame = it->second;
+        }
+        else
+        {
+            misses++;
+            frame = victim();
+            Frame &f = frames[frame];
+            if (f.used)
+            {
+                if (f.dirty)
+                    write_page(f.page, frame);
+                page_frames.erase(f.page);
+            }
+            f = Frame{page, true, fresh, false, 0};
+            page_frames[page] = frame;
+            if (fresh)
+                memset(frame_data(frame), 0, DISK_PAGE_SIZE);
+            else
+                read_page(page, frame);
+        }
+        frames[frame].referenced = true;
+        frames[frame].pins++;
+        return frame_data(frame);
+    }
+
+    /**
+     * @brief Suelta una página fijada con pin().
+     * @param dirty Si se modificó (se escribe al reemplazarla o en flush()).
+     */
+    void unpin(uint32_t page, bool dirty)
+    {
+        Frame &f = frames[page_frames[page]];
+        f.pins--;
+        f.dirty = f.dirty || dirty;
+    }
+
+    /**
+     * @brief Escribe al archivo todas las páginas modificadas.
+     */
+    void flush()
+    {
+        for (size_t frame = 0; frame < frames.size(); frame++)
+        {
+            if (frames[frame].used && frames[frame].dirty)
+            {
+                write_page(frames[frame].page, frame);
+                frames[frame].dirty = false;
+            }
+        }
+    }
+
+    /**
+     * @brief Páginas que caben en memoria.
+     */
+    size_t capacity() const
+    {
+        return frames.size();
+    }
+
+private:
+    /**
+     * @brief Un espacio del pool.
+     */
+    struct Frame
+    {
+        uint32_t page = 0;       ///< Página que tiene.
+        bool used = false;       ///< Si tiene una página.
+        bool dirty = false;      ///< Si hay que escribirla antes de reemplazarla.
+        bool referenced = false; ///< Bit de referencia del reloj.
+        int pins = 0;            ///< Usos en curso, con pins > 0 no se reemplaza.
+    };
+
+    int fd = -1;
+    char *data;                                   ///< Memoria de todas las páginas del pool.
+    vector<Frame> frames;
+    unordered_map<uint32_t, size_t> page_frames;  ///< Espacio del pool de cada página que está en memoria.
+    size_t hand = 0;                              ///< Manecilla del reloj.
+
+    char *frame_data(size_t frame)
+    {
+        return data + frame * DISK_PAGE_SIZE;
+    }
+
+    /**
+     * @brief Elige el espacio que se reemplaza: uno libre, o el primero sin referencia ni pines que encuentre el reloj.
+     */
+    size_t victim()
+    {
+        // dos vueltas apagan todos los bits de referencia, si después no hay candidato todas están fijadas
+        for (size_t step = 0; step < 2 * frames.size() + 1; step++)
+        {
+            size_t frame = hand;
+            hand = hand + 1 == frames.size() ? 0 : hand + 1;
+            Frame &f = frames[frame];
+            if (!f.used)
+                return frame;
+            if (f.pins > 0)
+                continue;
+            if (f.referenced)
+            {
+                f.referenced = false;
+                continue;
+            }
+            return frame;
+        }
+        throw runtime_error("BufferPool: todas las páginas están fijadas");
+    }
+
+    void read_page(uint32_t page, size_t frame)
+    {
+        ssize_t read_bytes = pread(fd, frame_data(frame), DISK_PAGE_SIZE, (off_t)page * DISK_PAGE_SIZE);
+        // una página que nunca se escribió (después del final del archivo) queda vacía
+        if (read_bytes < (ssize_t)DISK_PAGE_SIZE)
+            memset(frame_data(frame) + max<ssize_t>(read_bytes, 0), 0, DISK_PAGE_SIZE - max<ssize_t>(read_bytes, 0));
+        reads++;
+    }
+
+    void write_page(uint32_t page, size_t frame)
+    {
+        if (pwrite(fd, frame_data(frame), DISK_PAGE_SIZE, (off_t)page * DISK_PAGE_SIZE) != (ssize_t)DISK_PAGE_SIZE)
+            cout << "No se pudo escribir la página " << page << endl;
+        writes++;
+    }
+};
+
+/**
+ * @brief Tabla hash en disco con hashing extensible, con el mismo insert/search/remove que las tablas de
+ * hash_tables.h pero con los usuarios en un archivo y solo pool_pages páginas en memoria.
+ *
+ * @tparam Key unsigned long long para usar userId de clave, string para usar userName.
+ *
+ * @note search() devuelve un puntero a una copia del usuario que guarda la tabla, vale hasta la siguiente operación.
+ * Las páginas no se juntan al eliminar: una página vacía sigue ocupando su lugar en el archivo.
+ */
+template <typename Key>
+class DiskHashTable
+{
+public:
+    int size = 0;          ///< Cantidad de usuarios en la tabla.
+    int global_depth = 0;  ///< Bits del hash que usa el directorio.
+    uint32_t page_count;   ///< Páginas del archivo.
+    size_t splits = 0;     ///< Páginas divididas.
+    vector<uint32_t> directory; ///< Página de cada valor de los global_depth bits bajos del hash.
+    BufferPool pool;       ///< Páginas en memoria.
+
+    /**
+     * @brief Crea la tabla vacía (create = true) o abre una guardada con flush().
+     * @param path Archivo de las páginas, el directorio se guarda en path + ".dir".
+     * @param pool_pages Páginas que caben en memoria (al menos 3: una división usa dos a la vez).
+     * @param create Si se crea una tabla nueva (borrando el archivo) o se abre la que existe.
+     * @param direct_io Si se leen y escriben las páginas sin pasar por el cache del sistema (O_DIRECT).
+     */
+    DiskHashTable(const string &path, size_t pool_pages, bool create = true, bool direct_io = false)
+        : pool(path, max<size_t>(pool_pages, 3), create, direct_io), path(path)
+    {
+        if (!create && load_directory())
+            return;
+        page_count = 1;
+        directory.assign(1, 0);
+        char *page = pool.pin(0, true);
+        header(page).local_depth = 0;
+        header(page).end = DISK_PAGE_HEADER;
+        pool.unpin(0, true);
+    }
+
+    DiskHashTable(const DiskHashTable &) = delete;
+    DiskHashTable &operator=(const DiskHashTable &) = delete;
+
+    ~DiskHashTable()
+    {
+        flush();
+    }
+
+    /**
+     * @brief Inserta un usuario (no revisa si su clave ya está, igual que las demás tablas). Si la página de la
+     * clave está llena de registros con su mismo hash, dividirla no separa nada y el usuario no se inserta.
+     * @param key Clave del usuario.
+     * @param user Usuario a guardar, se copia a la página.
+     */
+    void insert(const Key &key, const User *user)
+    {
+        TRACE_OPERATION("DiskHashTable::insert");
+        unsigned long long hash = TRACED("hash", UserKey<Key>::hash(key));
+        char record[DISK_PAGE_SIZE];
+        size_t length = encode(record, hash, *user);
+        if (length == 0)
+        {
+            cout << "El usuario " << user->userName << " no cabe en una página." << endl;
+            return;
+        }
+        while (true)
+        {
+            uint32_t page_id = directory[hash & ((1ULL << global_depth) - 1)];
+            char *page = pool.pin(page_id);
+            PageHeader &h = header(page);
+            if (h.end + length <= DISK_PAGE_SIZE)
+            {
+                memcpy(page + h.end, record, length);
+                h.end += length;
+                h.count++;
+                pool.unpin(page_id, true);
+                size++;
+                return;
+            }
+            if (all_hashes_equal(page, hash))
+            {
+                pool.unpin(page_id, false);
+                cout << "La página de " << user->userName << " está llena de registros con el mismo hash." << endl;
+                return;
+            }
+            if (h.local_depth >= DISK_MAX_DEPTH)
+            {
+                pool.unpin(page_id, false);
+                cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+                return;
+            }
+            split(page_id, page);
+            pool.unpin(page_id, true);
+        }
+    }
+
+    /**
+     * @brief Busca un usuario por su clave, lee a lo más una página.
+     * @return Puntero a una copia del usuario (vale hasta la siguiente operación), nullptr si no se encontró.
+     */
+    User *search(const Key &key)
+    {
+        TRACE_OPERATION("DiskHashTable::search");
+        unsigned long long hash = TRACED("hash", UserKey<Key>::hash(key));
+        uint32_t page_id = directory[hash & ((1ULL << global_depth) - 1)];
+        char *page = pool.pin(page_id);
+        int offset = find(page, hash, key);
+        if (offset >= 0)
+            decode(page + offset, found);
+        pool.unpin(page_id, false);
+        return offset >= 0 ? &found : nullptr;
+    }
+
+    /**
+     * @brief Elimina un usuario por su clave, si no existe no hace nada. Los registros siguientes de la página se
+     * corren para no dejar huecos.
+     */
+    void remove(const Key &key)
+    {
+        TRACE_OPERATION("DiskHashTable::remove");
+        unsigned long long hash = TRACED("hash", UserKey<Key>::hash(key));
+        uint32_t page_id = directory[hash & ((1ULL << global_depth) - 1)];
+        char *page = pool.pin(page_id);
+        int offset = find(page, hash, key);
+        if (offset >= 0)
+        {
+            PageHeader &h = header(page);
+            size_t length = record_length(page + offset);
+            memmove(page + offset, page + offset + length, h.end - offset - length);
+            h.end -= length;
+            h.count--;
+            size--;
+        }
+        pool.unpin(page_id, offset >= 0);
+    }
+
+    /**
+     * @brief Escribe las páginas modificadas y el directorio, después se puede abrir la tabla con create = false.
+     */
+    void flush()
+    {
+        pool.flush();
+        ofstream file(path + ".dir", ios::binary | ios::trunc);
+        int32_t values[3] = {global_depth, (int32_t)page_count, size};
+        file.write((const char *)values, sizeof(values));
+        file.write((const char *)directory.data(), directory.size() * sizeof(uint32_t));
+    }
+
+    /**
+     * @brief Bytes del archivo de páginas.
+     */
+    size_t disk_bytes() const
+    {
+        return (size_t)page_count * DISK_PAGE_SIZE;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de memoria usada por la estructura de datos en bytes (pool y directorio, los
+     * usuarios están en disco).
+     */
+    size_t get_memory_usage()
+    {
+        return pool.capacity() * DISK_PAGE_SIZE + directory.size() * sizeof(uint32_t) + sizeof(*this);
+    }
+
+private:
+    /**
+     * @brief Encabezado al inicio de cada página.
+     */
+    struct PageHeader
+    {
+        uint16_t count;      ///< Registros en la página.
+        uint16_t end;        ///< Byte donde termina el último registro.
+        uint8_t local_depth; ///< Bits del hash que comparten todos los registros de la página.
+        uint8_t padding[3];
+    };
+    static_assert(sizeof(PageHeader) == DISK_PAGE_HEADER, "encabezado de página");
+
+    string path;
+    User found; ///< Copia del último usuario encontrado por search().
+
+    static PageHeader &header(char *page)
+    {
+        return *(PageHeader *)page;
+    }
+
+    static size_t record_length(const char *record)
+    {
+        uint16_t length;
+        memcpy(&length, record, sizeof(length));
+        return length;
+    }
+
+    static unsigned long long record_hash(const char *record)
+    {
+        unsigned long long hash;
+        memcpy(&hash, record + 2, sizeof(hash));
+        return hash;
+    }
+
+    /**
+     * @brief Si todos los registros de la página tienen ese hash (por ejemplo la misma clave repetida).
+     */
+    static bool all_hashes_equal(char *page, unsigned long long hash)
+    {
+        PageHeader &h = header(page);
+        for (size_t offset = DISK_PAGE_HEADER; offset < h.end; offset += record_length(page + offset))
+        {
+            if (record_hash(page + offset) != hash)
+                return false;
+        }
+        return true;
+    }
+
+    /// La clave del registro es igual a key (el userId va en los bytes 10 a 17, el userName justo después).
+    static bool record_has_key(const char *record, unsigned long long key)
+    {
+        unsigned long long userId;
+        memcpy(&userId, record + 10, sizeof(userId));
+        return userId == key;
+    }
+
+    static bool record_has_key(const char *record, const string &key)
+    {
+        uint8_t length = record[18];
+        return length == key.size() && memcmp(record + 19, key.data(), length) == 0;
+    }
+
+    /**
+     * @brief Posición del registro con key dentro de la página, -1 si no está.
+     */
+    static int find(char *page, unsigned long long hash, const Key &key)
+    {
+        PageHeader &h = header(page);
+        for (size_t offset = DISK_PAGE_HEADER; offset < h.end; offset += record_length(page + offset))
+        {
+            if (record_hash(page + offset) == hash && TRACED("compare", record_has_key(page + offset, key)))
+                return offset;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Escribe el registro de user en out.
+     * @return Largo del registro, 0 si algún string pasa de 255 caracteres.
+     */
+    static size_t encode(char *out, unsigned long long hash, const User &user)
+    {
+        if (user.userName.size() > 255 || user.university.size() > 255 || user.createdAt.size() > 255)
+            return 0;
+        size_t pos = 2;
+        auto put = [&](const void *value, size_t bytes)
+        {
+            memcpy(out + pos, value, bytes);
+            pos += bytes;
+        };
+        auto put_string = [&](const string &value)
+        {
+            out[pos++] = (char)value.size();
+            put(value.data(), value.size());
+        };
+        put(&hash, sizeof(hash));
+        put(&user.userId, sizeof(user.userId));
+        put_string(user.userName);
+        put_string(user.university);
+        put_string(user.createdAt);
+        put(&user.numberTweets, sizeof(user.numberTweets));
+        put(&user.friendsCount, sizeof(user.friendsCount));
+        put(&user.followersCount, sizeof(user.followersCount));
+        uint16_t length = pos;
+        memcpy(out, &length, sizeof(length));
+        return pos;
+    }
+
+    /**
+     * @brief Lee el usuario de un registro.
+     */
+    static void decode(const char *record, User &user)
+    {
+        size_t pos = 10;
+        auto get = [&](void *value, size_t bytes)
+        {
+            memcpy(value, record + pos, bytes);
+            pos += bytes;
+        };
+        auto get_string = [&](string &value)
+        {
+            uint8_t length = record[pos++];
+            value.assign(record + pos, length);
+            pos += length;
+        };
+        get(&user.userId, sizeof(user.userId));
+        get_string(user.userName);
+        get_string(user.university);
+        get_string(user.createdAt);
+        get(&user.numberTweets, sizeof(user.numberTweets));
+        get(&user.friendsCount, sizeof(user.friendsCount));
+        get(&user.followersCount, sizeof(user.followersCount));
+        user.createdAtEpoch = parseCreatedAt(user.createdAt);
+    }
+
+    /**
+     * @brief Divide una página llena (fijada) en dos: los registros con el bit local_depth del hash en 1 pasan a
+     * una página nueva al final del archivo. Si la página usaba todos los bits del directorio, se duplica el
+     * directorio antes.
+     */
+    void split(uint32_t page_id, char *page)
+    {
+        TRACE_SPAN("split");
+        PageHeader &h = header(page);
+        int depth = h.local_depth;
+        if (depth == global_depth)
+        {
+            size_t n = directory.size();
+            directory.resize(2 * n);
+            copy(directory.begin(), directory.begin() + n, directory.begin() + n);
+            global_depth++;
+        }
+
+        uint32_t new_id = page_count++;
+        char *new_page = pool.pin(new_id, true);
+        char old_records[DISK_PAGE_SIZE];
+        size_t old_end = h.end;
+        memcpy(old_records, page, old_end);
+
+        PageHeader &nh = header(new_page);
+        h.count = nh.count = 0;
+        h.end = nh.end = DISK_PAGE_HEADER;
+        h.local_depth = nh.local_depth = depth + 1;
+        for (size_t offset = DISK_PAGE_HEADER; offset < old_end; offset += record_length(old_records + offset))
+        {
+            const char *record = old_records + offset;
+            size_t length = record_length(record);
+            char *target = (record_hash(record) >> depth) & 1 ? new_page : page;
+            PageHeader &th = header(target);
+            memcpy(target + th.end, record, length);
+            th.end += length;
+            th.count++;
+        }
+
+        // las entradas que apuntaban a la página y tienen el bit en 1 pasan a la nueva
+        for (size_t i = 0; i < directory.size(); i++)
+        {
+            if (directory[i] == page_id && (i >> depth) & 1)
+                directory[i] = new_id;
+        }
+        pool.unpin(new_id, true);
+        splits++;
+    }
+
+    /**
+     * @brief Lee el directorio guardado por flush().
+     * @return false si no existe o está incompleto.
+     */
+    bool load_directory()
+    {
+        ifstream file(path + ".dir", ios::binary);
+        int32_t values[3];
+        if (!file.read((char *)values, sizeof(values)))
+            return false;
+        global_depth = values[0];
+        page_count = values[1];
+        size = values[2];
+        directory.resize(1ULL << global_depth);
+        return (bool)file.read((char *)directory.data(), directory.size() * sizeof(uint32_t));
+    }
+};
+
+typedef DiskHashTable<unsigned long long> DiskHashTableUserId;
+typedef DiskHashTable<string> DiskHashTableUserName;
+
+#endif
@@ -7,6 +7,7 @@
 #include <vector>
 #include <sstream>
 #include <fstream>
+#include <utility>
 
 using namespace std;
 
@@ -30,6 +31,80 @@ unsigned long long scientificToNormal(const std::string &scientific)
     return normal;
 }
 
+/**
+ * @brief Devuelve el primer número primo mayor o igual a n, se usa para elegir el tamaño de las tablas.
+ * Es constexpr para poder usarlo en tamaños fijos en tiempo de compilación (StaticPrimePolicy).
+ * @param n: número desde el cual se busca el primo.
+ */
+constexpr unsigned long long next_prime(unsigned long long n)
+{
+    if (n <= 2)
+        return 2;
+    if (n % 2 == 0)
+        n++;
+    while (true)
+    {
+        bool is_prime = true;
+        for (unsigned long long d = 3; d * d <= n; d += 2)
+        {
+            if (n % d == 0)
+            {
+                is_prime = false;
+                break;
+            }
+        }
+        if (is_prime)
+            return n;
+        n += 2;
+    }
+}
+
+/**
+ * @brief Transforma la fecha de creación de una cuenta (formato de twitter) a segundos desde 1970 (epoch, UTC).
+ *
+ * El formato es siempre "Thu Jul 28 07:16:49 +0000 2016", por lo que se lee cada campo por su posición
+ * sin usar streams, así la conversión se hace una sola vez al cargar los datos.
+ *
+ * @param created La fecha en formato de twitter.
+ * @return Segundos desde el 1 de enero de 1970, 0 si la fecha no tiene el formato esperado.
+ */
+long long parseCreatedAt(const std::string &created)
+{
+    if (created.size() < 30)
+        return 0;
+
+    const char *months = "JanFebMarAprMayJunJulAugSepOctNovDec";
+    int month = 0;
+    while (month < 12 && created.compare(4, 3, months + 3 * month, 3) != 0)
+        month++;
+    if (month == 12)
+        return 0;
+
+    auto number = [&](int pos, int len)
+    {
+        int value = 0;
+        for (int i = pos; i < pos + len; i++)
+            value = value * 10 + (created[i] - '0');
+        return value;
+    };
+    int day = number(8, 2), hour = number(11, 2), minute = number(14, 2), second = number(17, 2);
+    int offset = number(21, 2) * 3600 + number(23, 2) * 60;
+    if (created[20] == '-')
+        offset = -offset;
+    int year = number(26, 4);
+
+    // días desde 1970 para una fecha del calendario gregoriano (algoritmo days_from_civil de Howard Hinnant)
+    int y = year - (month < 2);
+    int era = (y >= 0 ? y : y - 399) / 400;
+    int yoe = y - era * 400;
+    int mp = (month + 10) % 12;
+    int doy = (153 * mp + 2) / 5 + day - 1;
+    int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    long long days = (long long)era * 146097 + doe - 719468;
+
+    return days * 86400 + hour * 3600 + minute * 60 + second - offset;
+}
+
 /*
 Struct que guarda los datos de un usuario.
 */
@@ -42,14 +117,15 @@ struct User
     int friendsCount;          //< 4 bytes
     int followersCount;        //< 4 bytes
     string createdAt;          //< 30 char (bytes)
+    long long createdAtEpoch;  //< createdAt en segundos desde 1970, 8 bytes
 
-    //< en promedio utiliza: 9 + 8 + 11 + 4 + 4 + 4 + 30 = 70 bytes por Usuario
+    //< en promedio utiliza: 9 + 8 + 11 + 4 + 4 + 4 + 30 = 70 bytes por Usuario (+ 8 del epoch)
 
     /*
     constructor por defecto de User, si se crea un User, utilizado cuando no se especifica el valor
     de un parametro.
     */
-    User() : university(""), userId(0), userName(""), numberTweets(0), friendsCount(0), followersCount(0), createdAt("")
+    User() : university(""), userId(0), userName(""), numberTweets(0), friendsCount(0), followersCount(0), createdAt(""), createdAtEpoch(0)
     {
     }
 
@@ -61,23 +137,28 @@ struct User
     @param tweets: cantidad de tweets.
     @param friends: cantidad de amigos.
     @param followers: número de seguidores.
-    @param created: fecha de creación de la cuenta.
+    @param created: fecha de creación de la cuenta, se transforma a epoch una sola vez aquí.
+
+    Los strings se reciben por valor y se mueven a los atributos: si se pasan con move() (o son temporales)
+    no se copian.
     */
-    User(const string &uni, unsigned long long id, const string &name, int tweets, int friends, int followers, const string &created)
-        : university(uni), userId(id), userName(name), numberTweets(tweets), friendsCount(friends), followersCount(followers), createdAt(created) {}
+    User(string uni, unsigned long long id, string name, int tweets, int friends, int followers, string created)
+        : university(move(uni)), userId(id), userName(move(name)), numberTweets(tweets), friendsCount(friends), followersCount(followers),
+          createdAt(move(created)), createdAtEpoch(parseCreatedAt(createdAt)) {}
 };
 
 /**
-* @brief Carga los datos del CSV y los pasa a un vector de la STL
-* @param filename: nombre del archivo con extención.
-* @return Vector con todos los usuarios cargados satisfactoriamente
-@note Referencia: https://www.geeksforgeeks.org/how-to-read-data-from-csv-file-to-a-2d-array-in-cpp/
-*/
-vector<User> readCSV(const std::string &filename)
+ * @brief Lee el CSV línea por línea y llama a callback(User &&) con cada usuario válido, sin guardarlos.
+ * readCSV y load_csv_unique (hash_tables.h) la usan para leer el archivo de la misma forma.
+ * @param filename: nombre del archivo con extención.
+ * @return Cantidad de usuarios leídos.
+ */
+template <typename Callback>
+size_t for_each_csv_user(const std::string &filename, Callback callback)
 {
-    vector<User> users;
     ifstream file(filename);
     string line;
+    size_t count = 0;
 
     // Salta la primera línea del csv ("titulos", nose como se llaman xd)
     getline(file, line);
@@ -94,23 +175,34 @@ vector<User> readCSV(const std::string &filename)
             tokens.push_back(item);
         }
 
-        // aseguramos que nos este dando los 7 datos, si es así entonces los agregamos al vector
+        // aseguramos que nos este dando los 7 datos, si es así entonces se lo pasamos al callback
         if (tokens.size() == 7)
         {
-            string university = tokens[0];
             unsigned long long userId = scientificToNormal(tokens[1]); // Convertir a numero normal
-            string userName = tokens[2];
             int numberTweets = stoi(tokens[3]);
             int friendsCount = stoi(tokens[4]);
             int followersCount = stoi(tokens[5]);
-            string createdAt = tokens[6];
-            // std::cout << "Usuario leído: " << userName << ", userId: " << userId << endl;
-
-            // emplace_back esta buena, no necesitas crear por fuera el objeto, lo crea solo, pero obviamente
-            // le tienes que dar los parametros
-            users.emplace_back(university, userId, userName, numberTweets, friendsCount, followersCount, createdAt);
+            // Los strings se mueven, así no se copian de nuevo.
+            callback(User(move(tokens[0]), userId, move(tokens[2]), numberTweets, friendsCount, followersCount,
+                          move(tokens[6])));
+            count++;
         }
     }
+    return count;
+}
+
+/**
+* @brief Carga los datos del CSV y los pasa a un vector de la STL
+* @param filename: nombre del archivo con extención.
+* @return Vector con todos los usuarios cargados satisfactoriamente
+@note Referencia: https://www.geeksforgeeks.org/how-to-read-data-from-csv-file-to-a-2d-array-in-cpp/
+*/
+vector<User> readCSV(const std::string &filename)
+{
+    vector<User> users;
+    // push_back de un temporal mueve el usuario, sus strings no se copian de nuevo.
+    for_each_csv_user(filename, [&](User &&user)
+                      { users.push_back(move(user)); });
 
     std::cout << "Leidos " << users.size() << " usuarios del archivo CSV." << endl;
 
@@ -1,6 +1,7 @@
 #ifndef HASH_FUNCTIONS
 #define HASH_FUNCTIONS
 #include <string>
+#include <cstring>
 
 using namespace std;
 
@@ -35,6 +36,56 @@ unsigned int hash_string(const string &str)
     }
     return hash_value;
 }
+/* Mezcla los 64 bits de una clave (finalizador de splitmix64), a diferencia de h1 cada bit de la salida
+depende de todos los bits de la entrada. Se usa cuando se necesita un hash de 64 bits de buena calidad
+(filtros, indices auxiliares).
+@param k: clave a la cual aplicaremos la función hash
+*/
+unsigned long long mix64(unsigned long long k)
+{
+    k ^= k >> 30;
+    k *= 0xbf58476d1ce4e5b9ULL;
+    k ^= k >> 27;
+    k *= 0x94d049bb133111ebULL;
+    k ^= k >> 31;
+    return k;
+}
+
+/* Hash de 64 bits para strings (FNV-1a seguido de mix64)
+@param str:  palabra a la que se le aplicara la función
+*/
+unsigned long long hash_string64(const string &str)
+{
+    unsigned long long hash_value = 0xcbf29ce484222325ULL;
+    for (char c : str)
+    {
+        hash_value ^= (unsigned char)c;
+        hash_value *= 0x100000001b3ULL;
+    }
+    return mix64(hash_value);
+}
+
+/* Hash de 64 bits para strings que lee la palabra de a 8 bytes (una multiplicación por bloque en vez de una por
+caracter), para nombres largos es varias veces más rápido que hash_string64.
+@param str:  palabra a la que se le aplicara la función
+*/
+unsigned long long hash_string_words(const string &str)
+{
+    const char *data = str.data();
+    size_t length = str.size();
+    unsigned long long hash_value = 0x9e3779b97f4a7c15ULL ^ length;
+    unsigned long long block;
+    for (; length >= 8; data += 8, length -= 8)
+    {
+        memcpy(&block, data, 8);
+        hash_value = (hash_value ^ mix64(block)) * 0xff51afd7ed558ccdULL;
+    }
+    // los últimos 0 a 7 bytes
+    block = 0;
+    memcpy(&block, data, length);
+    return mix64(hash_value ^ block);
+}
+
 //--- Métodos de Open addressing o hashing cerrado ---
 
 /* Linear probing
@@ -71,6 +122,17 @@ int double_hashing(unsigned long long k, int n, int i)
     return (h1(k) + i * (h2(k) + 1)) % n;
 }
 
+/* Linear probing sobre mix64 en vez de h1: las claves seguidas (ids snowflake de un mismo milisegundo) quedan
+repartidas en la tabla en vez de en espacios contiguos
+@param k: clave a la cual aplicaremos la función hash
+@param n: tamaño de la tabla hash
+@param i: número del intento
+*/
+int mixed_linear_probing(unsigned long long k, int n, int i)
+{
+    return (mix64(k) % n + i) % n;
+}
+
 /* Linear probing
 @param k: clave a la cual aplicaremos la función hash
 @param n: tamaño de la tabla hash
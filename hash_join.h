@@ -0,0 +1,179 @@
+#ifndef HASH_JOIN
+#define HASH_JOIN
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "functions.h"
+#include "hash_functions.h"
+#include "hash_tables.h"
+#include "parallel.h"
+
+using namespace std;
+
+/*
+Join por hash entre dos vectores de usuarios, por userId o por userName.
+
+En vez de construir una tabla con todo el lado build y buscar las claves del lado probe una por una (cada busqueda
+es un fallo de cache cuando la tabla no cabe en cache), las dos entradas se reparten en particiones según los bits
+altos del hash de la clave (partición radix de parallel.h). Se eligen tantas particiones como para que la tabla de
+una partición del lado build quepa en la cache (partition_bytes), y cada partición se construye y se consulta
+entera antes de pasar a la siguiente. Las particiones se reparten entre los hilos.
+
+Tipos de join (build es el lado con que se construye la tabla, probe el que se busca):
+    inner_join  pares (fila build, fila probe) con la misma clave.
+    semi_join   filas de probe que tienen al menos una clave igual en build (intersección).
+    anti_join   filas de probe que no están en build (diferencia).
+*/
+
+/**
+ * @brief Tipo de join.
+ */
+enum JoinType
+{
+    inner_join,
+    semi_join,
+    anti_join,
+};
+
+/**
+ * @brief Resultado de hash_join: pares para inner_join, filas de probe para semi_join y anti_join.
+ * Las filas son posiciones en los vectores build y probe.
+ */
+struct JoinResult
+{
+    vector<pair<uint32_t, uint32_t>> pairs; ///< (fila build, fila probe), solo con inner_join.
+    vector<uint32_t> rows;                  ///< Filas de probe, solo con semi_join y anti_join.
+    int partitions = 1;                     ///< Particiones que se usaron.
+
+    /**
+     * @brief Cantidad de resultados.
+     */
+    size_t size() const
+    {
+        return pairs.size() + rows.size();
+    }
+};
+
+/**
+ * @brief Bytes que ocupa por fila del lado build la tabla de una partición (hash de 8 bytes, fila de 4 y dos
+ * espacios de 4 por fila, para factor de carga 0.5), para elegir la cantidad de particiones.
+ */
+const size_t JOIN_BYTES_PER_ROW = 20;
+
+/**
+ * @brief Particiones para que la tabla de una partición del lado build ocupe a lo más partition_bytes: una
+ * potencia de 2, al menos una por hilo, y a lo más 2^14.
+ */
+int join_partitions(size_t build_rows, size_t partition_bytes, int n_threads)
+{
+    int partitions = 1;
+    while (partitions < (1 << 14) &&
+           ((size_t)partitions * partition_bytes < build_rows * JOIN_BYTES_PER_ROW || partitions < n_threads))
+        partitions *= 2;
+    return partitions;
+}
+
+/**
+ * @brief Join por hash particionado entre build y probe.
+ *
+ * @tparam Key unsigned long long para usar userId de clave, string para usar userName.
+ * @param build Usuarios con que se construyen las tablas de cada partición (conviene que sea el más chico).
+ * @param probe Usuarios que se buscan.
+ * @param type inner_join, semi_join o anti_join.
+ * @param n_threads Cantidad de hilos, 0 para usar todos los de la máquina.
+ * @param partition_bytes Tamaño objetivo de la tabla de una partición (la cache L2, por ejemplo), 0 para no
+ * particionar (una sola tabla con todo el lado build).
+ * @return Resultado, agrupado por partición (dentro de una partición las filas de probe van en su orden original).
+ */
+template <typename Key>
+JoinResult hash_join(const vector<User> &build, const vector<User> &probe, JoinType type, int n_threads = 0,
+                     size_t partition_bytes = 256 << 10)
+{
+    n_threads = resolve_threads(n_threads);
+    JoinResult result;
+    int partitions = partition_bytes == 0 ? 1 : join_partitions(build.size(), partition_bytes, n_threads);
+    int bits = __builtin_ctz(partitions);
+    result.partitions = partitions;
+
+    // el hash de cada fila se calcula una vez, sirve para particionar, para la tabla y para descartar claves distintas
+    vector<unsigned long long> build_hash(build.size()), probe_hash(probe.size());
+    parallel_for(build.size(), n_threads, [&](size_t begin, size_t end, int)
+                 {
+                     for (size_t i = begin; i < end; i++)
+                         build_hash[i] = UserKey<Key>::hash(UserKey<Key>::get(build[i])); });
+    parallel_for(probe.size(), n_threads, [&](size_t begin, size_t end, int)
+                 {
+                     for (size_t i = begin; i < end; i++)
+                         probe_hash[i] = UserKey<Key>::hash(UserKey<Key>::get(probe[i])); });
+
+    // bits altos para la partición, los bajos quedan para la posición dentro de la tabla de la partición
+    auto partition_of = [bits](unsigned long long hash)
+    { return bits == 0 ? 0 : (uint32_t)(hash >> (64 - bits)); };
+    Partitions build_parts = radix_partition(build.size(), partitions, n_threads, [&](size_t i)
+                                             { return partition_of(build_hash[i]); });
+    Partitions probe_parts = radix_partition(probe.size(), partitions, n_threads, [&](size_t i)
+                                             { return partition_of(probe_hash[i]); });
+
+    vector<JoinResult> partial(partitions);
+    // cada hilo reutiliza su tabla entre particiones
+    vector<vector<uint32_t>> tables(n_threads);
+    parallel_partitions(partitions, n_threads, [&](int p, int t)
+                        {
+                            size_t first = build_parts.offsets[p], last = build_parts.offsets[p + 1];
+                            size_t capacity = 1;
+                            while (capacity < 2 * (last - first))
+                                capacity *= 2;
+                            size_t mask = capacity - 1;
+                            vector<uint32_t> &table = tables[t];
+                            table.assign(capacity, UINT32_MAX);
+
+                            // cada espacio guarda la fila build, las claves repetidas ocupan espacios seguidos
+                            for (size_t j = first; j < last; j++)
+                            {
+                                uint32_t row = build_parts.order[j];
+                                size_t slot = build_hash[row] & mask;
+                                while (table[slot] != UINT32_MAX)
+                                    slot = (slot + 1) & mask;
+                                table[slot] = row;
+                            }
+
+                            JoinResult &out = partial[p];
+                            for (size_t j = probe_parts.offsets[p]; j < probe_parts.offsets[p + 1]; j++)
+                            {
+                                uint32_t row = probe_parts.order[j];
+                                unsigned long long hash = probe_hash[row];
+                                const Key &key = UserKey<Key>::get(probe[row]);
+                                bool matched = false;
+                                for (size_t slot = hash & mask; table[slot] != UINT32_MAX; slot = (slot + 1) & mask)
+                                {
+                                    uint32_t candidate = table[slot];
+                                    if (build_hash[candidate] != hash || !(UserKey<Key>::get(build[candidate]) == key))
+                                        continue;
+                                    matched = true;
+                                    if (type != inner_join)
+                                        break;
+                                    out.pairs.push_back({candidate, row});
+                                }
+                                if ((type == semi_join && matched) || (type == anti_join && !matched))
+                                    out.rows.push_back(row);
+                            } });
+
+    size_t total_pairs = 0, total_rows = 0;
+    for (JoinResult &part : partial)
+    {
+        total_pairs += part.pairs.size();
+        total_rows += part.rows.size();
+    }
+    result.pairs.reserve(total_pairs);
+    result.rows.reserve(total_rows);
+    for (JoinResult &part : partial)
+    {
+        result.pairs.insert(result.pairs.end(), part.pairs.begin(), part.pairs.end());
+        result.rows.insert(result.rows.end(), part.rows.begin(), part.rows.end());
+    }
+    return result;
+}
+
+#endif
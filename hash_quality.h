@@ -0,0 +1,196 @@
+#ifndef HASH_QUALITY
+#define HASH_QUALITY
+
+#include <vector>
+#include <string>
+#include <cmath>
+#include <cstdint>
+#include <algorithm>
+#include <random>
+
+using namespace std;
+
+/*
+Medidas de calidad de las funciones de hash de hash_functions.h, para elegir la función según los datos.
+
+Avalanche: al cambiar un bit de la entrada cada bit de la salida debería cambiar con probabilidad 1/2. El sesgo
+de un par (bit de entrada, bit de salida) es |2p - 1|: 0 es ideal y 1 significa que el bit de salida nunca cambia
+(o siempre cambia).
+
+Uniformidad: se reparten las claves en m buckets (con % primo o con la máscara de una potencia de 2, que es lo
+que usan las tablas) y se calcula chi-cuadrado / (m - 1). Con un hash aleatorio queda cerca de 1, mientras más
+grande peor se reparten las claves.
+
+Prueba más larga: se simula linear probing con las posiciones de las claves y se compara la clave más desplazada
+y el grupo de espacios ocupados seguidos (cluster) más largo con lo que se espera de un hash aleatorio, que se
+obtiene simulando posiciones aleatorias (con un hash aleatorio los dos crecen como log n, pero para tablas de este
+tamaño la fórmula asintótica de Pittel sobreestima bastante).
+*/
+
+/**
+ * @brief Cantidad de bits de una clave que se cambian en avalanche_bias.
+ */
+size_t input_bits(unsigned long long) { return 64; }
+size_t input_bits(const string &key) { return key.size() * 8; }
+
+/**
+ * @brief Copia de key con el bit indicado cambiado.
+ */
+unsigned long long flip_bit(unsigned long long key, size_t bit) { return key ^ (1ULL << bit); }
+string flip_bit(string key, size_t bit)
+{
+    key[bit / 8] ^= (char)(1 << (bit % 8));
+    return key;
+}
+
+/**
+ * @brief Resultado de avalanche_bias.
+ */
+struct AvalancheResult
+{
+    double mean_bias = 0;  ///< Sesgo promedio de todos los pares (bit de entrada, bit de salida).
+    double worst_bias = 0; ///< Sesgo del peor par.
+};
+
+/**
+ * @brief Sesgo de avalanche de una función de hash, cambiando cada bit de cada clave de inputs.
+ * Las claves string deben tener todas el mismo largo.
+ *
+ * @param hasher Función de hash, recibe la clave y devuelve un entero de hasta 64 bits.
+ * @param output_bits Bits de la salida que se miden (32 para h1, h2 y hash_string, 64 para las demás).
+ */
+template <typename Key, typename Hasher>
+AvalancheResult avalanche_bias(const vector<Key> &inputs, Hasher hasher, int output_bits)
+{
+    AvalancheResult result;
+    if (inputs.empty())
+        return result;
+    size_t bits = input_bits(inputs[0]);
+    vector<uint32_t> flips(bits * output_bits, 0);
+    for (const Key &key : inputs)
+    {
+        unsigned long long base = hasher(key);
+        for (size_t i = 0; i < bits; i++)
+        {
+            unsigned long long diff = base ^ (unsigned long long)hasher(flip_bit(key, i));
+            for (int j = 0; j < output_bits; j++)
+                flips[i * output_bits + j] += (diff >> j) & 1;
+        }
+    }
+    for (uint32_t count : flips)
+    {
+        double bias = fabs(2.0 * count / inputs.size() - 1);
+        result.mean_bias += bias;
+        result.worst_bias = max(result.worst_bias, bias);
+    }
+    result.mean_bias /= flips.size();
+    return result;
+}
+
+/**
+ * @brief Posición inicial de cada hash en una tabla de m espacios: hash % m, o hash & (m - 1) si mask es true
+ * (m debe ser potencia de 2).
+ */
+vector<size_t> home_slots(const vector<unsigned long long> &hashes, size_t m, bool mask)
+{
+    vector<size_t> homes(hashes.size());
+    for (size_t i = 0; i < hashes.size(); i++)
+        homes[i] = mask ? hashes[i] & (m - 1) : hashes[i] % m;
+    return homes;
+}
+
+/**
+ * @brief Chi-cuadrado de la cantidad de claves por bucket dividido por los grados de libertad (m - 1).
+ * Cerca de 1 con un hash aleatorio.
+ */
+double chi_square_ratio(const vector<size_t> &homes, size_t m)
+{
+    vector<uint32_t> counts(m, 0);
+    for (size_t home : homes)
+        counts[home]++;
+    double expected = (double)homes.size() / m;
+    double chi = 0;
+    for (uint32_t count : counts)
+        chi += (count - expected) * (count - expected) / expected;
+    return chi / (m - 1);
+}
+
+/**
+ * @brief Resultado de simulate_linear_probing.
+ */
+struct ProbeResult
+{
+    double average = 0; ///< Promedio de intentos para encontrar una clave (1 = en su posición inicial).
+    size_t longest = 0; ///< Intentos de la clave más desplazada.
+    size_t cluster = 0; ///< Largo del grupo más largo de espacios ocupados seguidos.
+};
+
+/**
+ * @brief Inserta las posiciones iniciales en una tabla de m espacios con linear probing (solo se marcan los espacios
+ * ocupados) y mide cuantos intentos necesitaría cada clave. Debe haber menos claves que espacios.
+ */
+ProbeResult simulate_linear_probing(const vector<size_t> &homes, size_t m)
+{
+    ProbeResult result;
+    vector<bool> used(m, false);
+    double total = 0;
+    for (size_t home : homes)
+    {
+        size_t probes = 1, slot = home;
+        while (used[slot])
+        {
+            slot = slot + 1 == m ? 0 : slot + 1;
+            probes++;
+        }
+        used[slot] = true;
+        total += probes;
+        result.longest = max(result.longest, probes);
+    }
+    result.average = homes.empty() ? 0 : total / homes.size();
+
+    // se empieza a contar después de un espacio libre, así un cluster que da la vuelta se cuenta entero
+    size_t free_slot = find(used.begin(), used.end(), false) - used.begin();
+    size_t run = 0;
+    for (size_t i = 1; i <= m; i++)
+    {
+        run = used[(free_slot + i) % m] ? run + 1 : 0;
+        result.cluster = max(result.cluster, run);
+    }
+    return result;
+}
+
+/**
+ * @brief Intentos promedio esperados en una busqueda exitosa con linear probing y un hash aleatorio (Knuth):
+ * (1 + 1 / (1 - a)) / 2.
+ */
+double expected_linear_probes(double load_factor)
+{
+    return (1 + 1 / (1 - load_factor)) / 2;
+}
+
+/**
+ * @brief Prueba más larga y cluster más largo esperados con linear probing y un hash aleatorio: promedio de
+ * simular n claves con posiciones aleatorias en m espacios, n_runs veces. El promedio de intentos queda en
+ * average, aunque para eso basta con expected_linear_probes.
+ */
+ProbeResult expected_linear_probing(size_t n, size_t m, int n_runs = 5)
+{
+    mt19937_64 rng(12345);
+    ProbeResult expected;
+    double longest = 0, cluster = 0;
+    for (int r = 0; r < n_runs; r++)
+    {
+        vector<size_t> homes(n);
+        for (size_t &home : homes)
+            home = rng() % m;
+        ProbeResult run = simulate_linear_probing(homes, m);
+        expected.average += run.average / n_runs;
+        longest += run.longest;
+        cluster += run.cluster;
+    }
+    expected.longest = round(longest / n_runs);
+    expected.cluster = round(cluster / n_runs);
+    return expected;
+}
+
+#endif
@@ -4,17 +4,50 @@
 #include <vector>
 #include <string>
 #include <iostream>
+#include <cstdint>
 
 #include "functions.h"
 #include "hash_functions.h"
+#include "parallel.h"
+#include "huge_pages.h"
+#include "trace.h"
 #include <unordered_set>
 
 using namespace std;
 
 // Máximo de intentos de una operación en una hash table.
 const int MAX_ATTEMPTS = 5000;
+// Proporción de la tabla ocupada por eliminados sobre la cual las tablas cerradas se compactan.
+const double MAX_TOMBSTONE_RATIO = 0.2;
+// Marca de eliminado de las tablas cerradas. Se guarda su dirección (&DELETED_VAR) en vez de una copia en el heap,
+// por lo que un eliminado se reconoce comparando punteros.
 User DELETED_VAR = User("", 0, "DELETED_VAR", 0, 0, 0, "");
 
+/**
+ * @brief Permite escribir estructuras genéricas sobre el tipo de clave: UserKey<unsigned long long> usa userId
+ * y UserKey<string> usa userName.
+ */
+template <typename Key>
+struct UserKey;
+
+template <>
+struct UserKey<unsigned long long>
+{
+    /// Clave de un usuario.
+    static unsigned long long get(const User &user) { return user.userId; }
+    /// Hash de 64 bits de la clave.
+    static unsigned long long hash(unsigned long long key) { return mix64(key); }
+};
+
+template <>
+struct UserKey<string>
+{
+    /// Clave de un usuario.
+    static const string &get(const User &user) { return user.userName; }
+    /// Hash de 64 bits de la clave.
+    static unsigned long long hash(const string &key) { return hash_string64(key); }
+};
+
 //---------------------------------------------------------------//
 //-------------TABLAS DE HASHEO PARA KEY USERID------------------//
 //---------------------------------------------------------------//
@@ -25,11 +58,15 @@ User DELETED_VAR = User("", 0, "DELETED_VAR", 0, 0, 0, "");
 class CloseHashTableUserId
 {
 public:
+    using key_type = unsigned long long; ///< Tipo de la clave (para load_csv_unique).
     int max_size; ///< Tamaño de la tabla hash.
     int size = 0;
     int totalCollisions = 0;                             ///< Contador global de colisiones                                            ///< Tamaño de la tabla hash.
+    int tombstones = 0;                                  ///< Espacios marcados como eliminados (&DELETED_VAR).
+    int compactions = 0;                                 ///< Veces que se ha compactado la tabla.
+    bool auto_compact = true;                            ///< Si se compacta sola al superar MAX_TOMBSTONE_RATIO.
     int (*hashing_method)(unsigned long long, int, int); ///< Puntero a la función de hash.
-    vector<User *> table;                                ///< Vector que almacena punteros a onjetos User.
+    HugePageVector<User *> table;                        ///< Vector que almacena punteros a onjetos User.
 
     /**
      * @brief Constructor para inicializar la tabla hash con un tamaño dado y un método de hash.
@@ -39,28 +76,106 @@ public:
     CloseHashTableUserId(int size, int (*hashing_method)(unsigned long long, int, int))
         : max_size(size), hashing_method(hashing_method), table(size, nullptr) {}
 
+    ~CloseHashTableUserId()
+    {
+        for (User *user : table)
+        {
+            if (user != &DELETED_VAR)
+                delete user;
+        }
+    }
+
     /**
-     * @brief Inserta un usuario en la tabla hash.
+     * @brief Inserta una copia del usuario en la tabla hash (la tabla es dueña de la copia).
      * @param userId El ID del usuario a insertar.
-     * @param user Puntero al objeto User que se va a insertar.
+     * @param user Puntero al objeto User que se va a insertar, se copia.
      */
     void insert(unsigned long long key, User *user_data)
     {
-        int i = 0;
-        unsigned int index = hashing_method(key, max_size, i);
-        while (i < MAX_ATTEMPTS)
+        TRACE_OPERATION("CloseHashTableUserId::insert");
+        User *copy = new User(*user_data);
+        int attempts = place(key, copy);
+        if (attempts < 0)
         {
-            if (!table[index] || table[index]->userName == "DELETED_VAR")
-            {
-                table[index] = new User(*user_data);
-                size++;
-                return;
-            }
-            i++;
-            totalCollisions++;
-            index = hashing_method(key, max_size, i);
+            delete copy;
+            cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+            return;
         }
-        cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+        totalCollisions += attempts;
+        size++;
+    }
+
+    /**
+     * @brief Inserta un usuario moviéndolo a memoria de la tabla (la tabla es dueña de sus usuarios), sus strings no se copian.
+     * @param user Usuario a insertar, queda vacío después de la llamada.
+     * @return Puntero al usuario dentro de la tabla, nullptr si la tabla está llena.
+     */
+    User *insert(User &&user)
+    {
+        return adopt(new User(move(user)));
+    }
+
+    /**
+     * @brief Construye un usuario directamente en memoria de la tabla, recibe los mismos parametros que el constructor de User.
+     * @return Puntero al usuario dentro de la tabla, nullptr si la tabla está llena.
+     */
+    template <typename... Args>
+    User *emplace(Args &&...args)
+    {
+        return adopt(new User(forward<Args>(args)...));
+    }
+
+    /**
+     * @brief Inserta un usuario construido con args solo si key no está en la tabla (como try_emplace de
+     * unordered_map). Una sola pasada por la secuencia de prueba encuentra la clave o el espacio donde insertarla
+     * (el primer eliminado o el espacio vacío), y el usuario solo se construye si se inserta.
+     * @param key userId del usuario, debe ser igual al del usuario que construyen args. Puede ser una referencia
+     * a un campo de args: no se usa después de construir el usuario.
+     * @return Puntero al usuario con esa clave y true si se insertó, false si ya estaba (nullptr si la tabla está llena).
+     */
+    template <typename... Args>
+    pair<User *, bool> try_emplace(unsigned long long key, Args &&...args)
+    {
+        TRACE_OPERATION("CloseHashTableUserId::try_emplace");
+        int attempts;
+        int index = find_or_free(key, attempts);
+        if (index >= 0 && table[index] && table[index] != &DELETED_VAR)
+            return {table[index], false};
+        if (index < 0)
+        {
+            cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+            return {nullptr, false};
+        }
+        User *user = new User(forward<Args>(args)...);
+        claim(index, user, attempts);
+        return {user, true};
+    }
+
+    /**
+     * @brief Reemplaza los datos del usuario con la misma clave, o lo inserta si no está (como insert_or_assign
+     * de unordered_map), con una sola pasada por la secuencia de prueba.
+     * @param user Usuario a guardar, queda vacío después de la llamada.
+     * @return Puntero al usuario dentro de la tabla y true si se insertó, false si se reemplazó uno existente
+     * (nullptr si la tabla está llena).
+     */
+    pair<User *, bool> insert_or_assign(User &&user)
+    {
+        TRACE_OPERATION("CloseHashTableUserId::insert_or_assign");
+        int attempts;
+        int index = find_or_free(user.userId, attempts);
+        if (index >= 0 && table[index] && table[index] != &DELETED_VAR)
+        {
+            *table[index] = move(user);
+            return {table[index], false};
+        }
+        if (index < 0)
+        {
+            cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+            return {nullptr, false};
+        }
+        User *copy = new User(move(user));
+        claim(index, copy, attempts);
+        return {copy, true};
     }
 
     /**
@@ -81,14 +196,15 @@ public:
      */
     User *search(unsigned long long userId)
     {
+        TRACE_OPERATION("CloseHashTableUserId::search");
         int i = 0;
         int index;
         do
         {
-            index = hashing_method(userId, max_size, i);
+            index = TRACED("hash", hashing_method(userId, max_size, i));
             if (table[index] == nullptr)
                 return nullptr;
-            if (table[index]->userId == userId)
+            if (table[index] != &DELETED_VAR && TRACED("compare", table[index]->userId == userId))
                 return table[index];
             i++;
         } while (i < max_size);
@@ -102,8 +218,9 @@ public:
      */
     void remove(unsigned long long &key)
     {
+        TRACE_OPERATION("CloseHashTableUserId::remove");
         int i = 0;
-        unsigned int index = hashing_method(key, max_size, i);
+        unsigned int index = TRACED("hash", hashing_method(key, max_size, i));
         while (i < MAX_ATTEMPTS && table[index])
         {
             if (!table[index])
@@ -111,14 +228,18 @@ public:
                 // Esto pasa cuando nos encontramos con un espacio al cual nunca se ha accedido.
                 return;
             }
-            if (table[index]->userId == key)
+            if (table[index] != &DELETED_VAR && TRACED("compare", table[index]->userId == key))
             {
-                table[index] = new User(DELETED_VAR);
+                delete table[index];
+                table[index] = &DELETED_VAR;
                 size--;
+                tombstones++;
+                if (auto_compact && !compact_failed && tombstones > MAX_TOMBSTONE_RATIO * max_size)
+                    compact();
                 return;
             }
             i++;
-            index = hashing_method(key, max_size, i);
+            index = TRACED("hash", hashing_method(key, max_size, i));
         }
     }
 
@@ -134,7 +255,7 @@ public:
         for (auto element : table)
         {
             count += 8; //< tamaño de los punteros
-            if (element)
+            if (element && element != &DELETED_VAR)
             {
                 count += user_size;
             }
@@ -145,6 +266,259 @@ public:
 
         return count;
     }
+
+    /**
+     * @brief Compacta la tabla: reinserta todos los usuarios en un arreglo nuevo sin eliminados, así las
+     * secuencias de prueba vuelven a terminar en espacios vacíos. Los usuarios no se copian, solo se mueven los punteros.
+     * @return false si algún usuario no cabe en MAX_ATTEMPTS intentos, la tabla queda como estaba (con sus eliminados)
+     * y remove deja de compactar sola hasta el siguiente compact() o rehash() exitoso.
+     */
+    bool compact()
+    {
+        TRACE_SPAN("compact");
+        int collisions;
+        if (!rebuild(max_size, collisions))
+        {
+            cout << "No se pudo compactar la tabla: un usuario no cabe en MAX_ATTEMPTS intentos." << endl;
+            // cada remove volvería a recorrer toda la tabla para fallar igual, se espera a un rehash()
+            compact_failed = true;
+            return false;
+        }
+        compactions++;
+        return true;
+    }
+
+    /**
+     * @brief Cambia el tamaño de la tabla reinsertando todos los usuarios (sin eliminados) en un arreglo de
+     * new_size espacios, para hacerla crecer cuando se llena. Los usuarios no se copian, solo se mueven los punteros.
+     * @param new_size Nuevo tamaño, debe ser mayor que la cantidad de usuarios (conviene un primo).
+     * @return false si new_size no alcanza o algún usuario no cabe en MAX_ATTEMPTS intentos, la tabla queda como estaba.
+     */
+    bool rehash(int new_size)
+    {
+        int collisions;
+        if (new_size <= size || !rebuild(new_size, collisions))
+        {
+            cout << "No se pudo cambiar el tamaño de la tabla a " << new_size << " (hay " << size << " usuarios)." << endl;
+            return false;
+        }
+        totalCollisions = collisions;
+        return true;
+    }
+
+    /**
+     * @brief Proporción de la tabla ocupada por eliminados.
+     */
+    double tombstone_ratio()
+    {
+        return (double)tombstones / max_size;
+    }
+
+    /**
+     * @brief Inserta todos los usuarios de un vector usando varios hilos, queda igual que llamando insert() con cada uno.
+     * Los usuarios se reparten (partición radix) según el rango de la tabla donde cae su primer intento y cada hilo
+     * llena sus rangos sin locks. Los usuarios cuya secuencia de prueba sale de su rango se insertan al final en un solo hilo.
+     * @param users Usuarios a insertar, se copian.
+     * @param n_threads Cantidad de hilos, 0 para usar todos los de la máquina.
+     */
+    void bulk_load(const vector<User> &users, int n_threads = 0)
+    {
+        int n_partitions = bulk_partitions(n_threads, max_size);
+        Partitions partitions = radix_partition(users.size(), n_partitions, n_threads, [&](size_t i)
+                                                { return slot_partition(hashing_method(users[i].userId, max_size, 0), max_size, n_partitions); });
+
+        vector<vector<uint32_t>> deferred(n_partitions);
+        vector<int> collisions(n_partitions, 0), placed(n_partitions, 0), reused(n_partitions, 0);
+        parallel_partitions(n_partitions, n_threads, [&](int p, int)
+                            {
+                                size_t first = partition_begin(p, max_size, n_partitions);
+                                size_t last = partition_begin(p + 1, max_size, n_partitions);
+                                for (size_t j = partitions.offsets[p]; j < partitions.offsets[p + 1]; j++)
+                                {
+                                    uint32_t i = partitions.order[j];
+                                    User *copy = new User(users[i]);
+                                    int attempts = place_in_range(users[i].userId, copy, first, last, reused[p]);
+                                    if (attempts < 0)
+                                    {
+                                        delete copy;
+                                        deferred[p].push_back(i);
+                                        continue;
+                                    }
+                                    collisions[p] += attempts;
+                                    placed[p]++;
+                                } });
+
+        for (int p = 0; p < n_partitions; p++)
+        {
+            totalCollisions += collisions[p];
+            size += placed[p];
+            tombstones -= reused[p];
+        }
+        for (const vector<uint32_t> &rest : deferred)
+        {
+            for (uint32_t i : rest)
+            {
+                User *copy = new User(users[i]);
+                int attempts = place(users[i].userId, copy);
+                if (attempts < 0)
+                {
+                    delete copy;
+                    cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+                    continue;
+                }
+                totalCollisions += attempts;
+                size++;
+            }
+        }
+    }
+
+private:
+    bool compact_failed = false; ///< El último compact() falló, remove no vuelve a intentarlo hasta otro rebuild exitoso.
+
+    /**
+     * @brief Reinserta todos los usuarios (sin eliminados) en un arreglo nuevo de new_size espacios, con el mismo
+     * allocator así el arreglo nuevo usa las mismas páginas que el anterior.
+     * @param collisions Colisiones de las reinserciones.
+     * @return false si algún usuario no cabe en MAX_ATTEMPTS intentos: se vuelve al arreglo anterior (que todavía
+     * tiene a todos los usuarios), así ninguno se pierde.
+     */
+    bool rebuild(int new_size, int &collisions)
+    {
+        HugePageVector<User *> old_table(new_size, nullptr, table.get_allocator());
+        old_table.swap(table);
+        int old_size = max_size;
+        max_size = new_size;
+        collisions = 0;
+        for (User *user : old_table)
+        {
+            if (!user || user == &DELETED_VAR)
+                continue;
+            int attempts = place(user->userId, user);
+            if (attempts < 0)
+            {
+                table.swap(old_table);
+                max_size = old_size;
+                return false;
+            }
+            collisions += attempts;
+        }
+        tombstones = 0;
+        compact_failed = false;
+        return true;
+    }
+
+    /**
+     * @brief Guarda el puntero en el primer espacio vacío o eliminado de la secuencia de prueba de key.
+     * @return Cantidad de colisiones hasta encontrar el espacio, -1 si no se encontro.
+     */
+    int place(unsigned long long key, User *user)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            unsigned int index = TRACED("hash", hashing_method(key, max_size, i));
+            if (!table[index] || table[index] == &DELETED_VAR)
+            {
+                if (table[index] == &DELETED_VAR)
+                    tombstones--;
+                table[index] = user;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Igual que place() pero solo usa espacios en [first, last), para bulk_load.
+     * @param reused Se incrementa si el espacio usado era un eliminado.
+     * @return Cantidad de colisiones, -1 si la secuencia de prueba sale del rango antes de encontrar un espacio.
+     */
+    int place_in_range(unsigned long long key, User *user, size_t first, size_t last, int &reused)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            unsigned int index = hashing_method(key, max_size, i);
+            if (index < first || index >= last)
+                return -1;
+            if (!table[index] || table[index] == &DELETED_VAR)
+            {
+                if (table[index] == &DELETED_VAR)
+                    reused++;
+                table[index] = user;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Recorre la secuencia de prueba de key una vez: devuelve el espacio de key si está, si no el primer
+     * eliminado que se cruzó o el espacio vacío donde terminó la secuencia.
+     * @param attempts Intentos hasta el espacio devuelto (las colisiones si se inserta ahí).
+     * @return Posición del espacio, -1 si no está y no hay espacio libre en MAX_ATTEMPTS intentos.
+     */
+    int find_or_free(unsigned long long key, int &attempts)
+    {
+        int free_slot = -1;
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int index = TRACED("hash", hashing_method(key, max_size, i));
+            User *user = table[index];
+            if (!user)
+            {
+                if (free_slot < 0)
+                {
+                    free_slot = index;
+                    attempts = i;
+                }
+                return free_slot;
+            }
+            if (user == &DELETED_VAR)
+            {
+                if (free_slot < 0)
+                {
+                    free_slot = index;
+                    attempts = i;
+                }
+            }
+            else if (TRACED("compare", user->userId == key))
+            {
+                attempts = i;
+                return index;
+            }
+        }
+        return free_slot;
+    }
+
+    /**
+     * @brief Guarda un usuario nuevo en un espacio libre que devolvió find_or_free.
+     */
+    void claim(int index, User *user, int attempts)
+    {
+        if (table[index] == &DELETED_VAR)
+            tombstones--;
+        table[index] = user;
+        totalCollisions += attempts;
+        size++;
+    }
+
+    /**
+     * @brief Guarda un usuario ya reservado en el heap, la tabla pasa a ser su dueña (lo libera si no cabe).
+     * @return El mismo puntero, nullptr si la tabla está llena.
+     */
+    User *adopt(User *user)
+    {
+        TRACE_OPERATION("CloseHashTableUserId::insert");
+        int attempts = place(user->userId, user);
+        if (attempts < 0)
+        {
+            delete user;
+            cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+            return nullptr;
+        }
+        totalCollisions += attempts;
+        size++;
+        return user;
+    }
 };
 
 /**
@@ -166,15 +540,16 @@ public:
     OpenHashTableUserId(int size) : max_size(size), table(size) {}
 
     /**
-     * @brief Inserta un usuario en la tabla hash.
+     * @brief Guarda el puntero a un usuario sin copiarlo, la tabla es un indice sobre usuarios que viven afuera
+     * (el usuario debe vivir más que la tabla). Es lo mismo que insert_ref().
      *
      * @param userId El ID del usuario a insertar.
      * @param user Un puntero al objeto User que contiene los datos del usuario.
      */
     void insert(unsigned long long userId, User *user)
     {
-
-        unsigned int index = hashing_method(userId);
+        TRACE_OPERATION("OpenHashTableUserId::insert");
+        unsigned int index = TRACED("hash", hashing_method(userId));
         if (!table[index].empty())
         {
             totalCollisions++;
@@ -183,6 +558,15 @@ public:
         size++;
     }
 
+    /**
+     * @brief Guarda el puntero a un usuario sin copiarlo ni ser dueña de él, el nombre deja explícito que
+     * el usuario debe vivir más que la tabla.
+     */
+    void insert_ref(unsigned long long userId, User *user)
+    {
+        insert(userId, user);
+    }
+
     /**
      *@brief Devuelve el numero total de colisiones que hubo en una Tabla Hash dependiendo
      * del metodo de resolucion de colisiones utilizado
@@ -202,10 +586,11 @@ public:
      */
     User *search(unsigned long long userId)
     {
-        unsigned int index = hashing_method(userId);
+        TRACE_OPERATION("OpenHashTableUserId::search");
+        unsigned int index = TRACED("hash", hashing_method(userId));
         for (User *user : table[index])
         {
-            if (user->userId == userId)
+            if (TRACED("compare", user->userId == userId))
                 return user;
         }
         return nullptr;
@@ -218,13 +603,14 @@ public:
      */
     void remove(unsigned long long key)
     {
-        unsigned int index = hashing_method(key);
+        TRACE_OPERATION("OpenHashTableUserId::remove");
+        unsigned int index = TRACED("hash", hashing_method(key));
         auto &bucket = table[index];
         int bucket_size = bucket.size();
 
         for (int i = 0; i < bucket_size; i++)
         {
-            if (bucket.at(i)->userId == key)
+            if (TRACED("compare", bucket.at(i)->userId == key))
             {
                 // Esto es iniciar el iterador y moverlo hasta el indice correspondiente
                 bucket.erase(bucket.begin() + i);
@@ -243,15 +629,14 @@ public:
         // considerando el tamaño promedio de un usuario en memoria de 70 bytes
         int user_size = 70;
 
-        for (auto bucket : table)
+        // por referencia, para no copiar cada bucket al recorrerlo
+        for (const auto &bucket : table)
         {
             // tamaño usado por vector
             count += sizeof(bucket);
 
-            for (auto element : bucket)
-            {
-                count += 8 + user_size; //< Se le esta sumando el tamaño del puntero (lo que se guarda) y del struct
-            }
+            //< Se le esta sumando el tamaño del puntero (lo que se guarda) y del struct por cada elemento
+            count += bucket.size() * (8 + user_size);
         }
         // espacio usado por el resto de variables
         count += sizeof(max_size);
@@ -260,6 +645,48 @@ public:
         return count;
     }
 
+    /**
+     * @brief Inserta todos los usuarios de un vector usando varios hilos, queda igual que llamando insert() con cada uno.
+     * Los usuarios se reparten (partición radix) según el rango de buckets al que van, y cada hilo reserva el
+     * tamaño final de sus buckets antes de llenarlos, sin locks.
+     * @param users Usuarios a insertar, la tabla guarda punteros a este vector.
+     * @param n_threads Cantidad de hilos, 0 para usar todos los de la máquina.
+     */
+    void bulk_load(vector<User> &users, int n_threads = 0)
+    {
+        int n_partitions = bulk_partitions(n_threads, max_size);
+        vector<unsigned int> index(users.size());
+        Partitions partitions = radix_partition(users.size(), n_partitions, n_threads, [&](size_t i)
+                                                {
+                                                    index[i] = hashing_method(users[i].userId);
+                                                    return slot_partition(index[i], max_size, n_partitions); });
+
+        vector<int> collisions(n_partitions, 0);
+        parallel_partitions(n_partitions, n_threads, [&](int p, int)
+                            {
+                                size_t first = partitions.offsets[p], last = partitions.offsets[p + 1];
+                                size_t bucket_base = partition_begin(p, max_size, n_partitions);
+                                vector<int> pending(partition_begin(p + 1, max_size, n_partitions) - bucket_base, 0);
+                                for (size_t j = first; j < last; j++)
+                                    pending[index[partitions.order[j]] - bucket_base]++;
+                                for (size_t b = 0; b < pending.size(); b++)
+                                {
+                                    if (pending[b] > 0)
+                                        table[bucket_base + b].reserve(table[bucket_base + b].size() + pending[b]);
+                                }
+                                for (size_t j = first; j < last; j++)
+                                {
+                                    uint32_t i = partitions.order[j];
+                                    if (!table[index[i]].empty())
+                                        collisions[p]++;
+                                    table[index[i]].push_back(&users[i]);
+                                } });
+
+        for (int count : collisions)
+            totalCollisions += count;
+        size += users.size();
+    }
+
 private:
     /**
      * @brief remueve un usuario en la tabla hash por su UserID, si este no existe no hace nada.
@@ -284,11 +711,15 @@ private:
 class CloseHashTableUserName
 {
 public:
+    using key_type = string; ///< Tipo de la clave (para load_csv_unique).
     int max_size;
     int size = 0;
     int totalCollisions = 0;
+    int tombstones = 0;        ///< Espacios marcados como eliminados (&DELETED_VAR).
+    int compactions = 0;       ///< Veces que se ha compactado la tabla.
+    bool auto_compact = true;  ///< Si se compacta sola al superar MAX_TOMBSTONE_RATIO.
     unsigned int (*hashing_method)(const string &, int, int);
-    vector<User *> table;
+    HugePageVector<User *> table;
 
     /**
      * @brief Constructor de la clase CloseHashUserName.
@@ -305,33 +736,103 @@ public:
     {
         for (User *user : table)
         {
-            delete user;
+            if (user != &DELETED_VAR)
+                delete user;
         }
     }
 
     /**
-     * @brief Inserta un usuario en la tabla hash.
+     * @brief Inserta una copia del usuario en la tabla hash (la tabla es dueña de la copia).
      *
      * @param key nombre del usuario a insertar.
-     * @param user Un puntero al objeto User que contiene los datos del usuario.
+     * @param user Un puntero al objeto User que contiene los datos del usuario, se copia.
      */
     void insert(const string &key, User *user_data)
     {
-        int i = 0;
-        unsigned int index = hashing_method(key, max_size, i);
-        while (i < MAX_ATTEMPTS)
+        TRACE_OPERATION("CloseHashTableUserName::insert");
+        User *copy = new User(*user_data);
+        int attempts = place(key, copy);
+        if (attempts < 0)
         {
-            if (!table[index] || table[index]->userName == "DELETED_VAR")
-            {
-                table[index] = new User(*user_data);
-                size++;
-                return;
-            }
-            i++;
-            totalCollisions++;
-            index = hashing_method(key, max_size, i);
+            delete copy;
+            cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+            return;
+        }
+        totalCollisions += attempts;
+        size++;
+    }
+
+    /**
+     * @brief Inserta un usuario moviéndolo a memoria de la tabla (la tabla es dueña de sus usuarios), sus strings no se copian.
+     * @param user Usuario a insertar, queda vacío después de la llamada.
+     * @return Puntero al usuario dentro de la tabla, nullptr si la tabla está llena.
+     */
+    User *insert(User &&user)
+    {
+        return adopt(new User(move(user)));
+    }
+
+    /**
+     * @brief Construye un usuario directamente en memoria de la tabla, recibe los mismos parametros que el constructor de User.
+     * @return Puntero al usuario dentro de la tabla, nullptr si la tabla está llena.
+     */
+    template <typename... Args>
+    User *emplace(Args &&...args)
+    {
+        return adopt(new User(forward<Args>(args)...));
+    }
+
+    /**
+     * @brief Inserta un usuario construido con args solo si key no está en la tabla (como try_emplace de
+     * unordered_map). Una sola pasada por la secuencia de prueba encuentra la clave o el espacio donde insertarla
+     * (el primer eliminado o el espacio vacío), y el usuario solo se construye si se inserta.
+     * @param key userName del usuario, debe ser igual al del usuario que construyen args. Puede ser una referencia
+     * a un campo de args: no se usa después de construir el usuario.
+     * @return Puntero al usuario con esa clave y true si se insertó, false si ya estaba (nullptr si la tabla está llena).
+     */
+    template <typename... Args>
+    pair<User *, bool> try_emplace(const string &key, Args &&...args)
+    {
+        TRACE_OPERATION("CloseHashTableUserName::try_emplace");
+        int attempts;
+        int index = find_or_free(key, attempts);
+        if (index >= 0 && table[index] && table[index] != &DELETED_VAR)
+            return {table[index], false};
+        if (index < 0)
+        {
+            cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+            return {nullptr, false};
         }
-        cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+        User *user = new User(forward<Args>(args)...);
+        claim(index, user, attempts);
+        return {user, true};
+    }
+
+    /**
+     * @brief Reemplaza los datos del usuario con la misma clave, o lo inserta si no está (como insert_or_assign
+     * de unordered_map), con una sola pasada por la secuencia de prueba.
+     * @param user Usuario a guardar, queda vacío después de la llamada.
+     * @return Puntero al usuario dentro de la tabla y true si se insertó, false si se reemplazó uno existente
+     * (nullptr si la tabla está llena).
+     */
+    pair<User *, bool> insert_or_assign(User &&user)
+    {
+        TRACE_OPERATION("CloseHashTableUserName::insert_or_assign");
+        int attempts;
+        int index = find_or_free(user.userName, attempts);
+        if (index >= 0 && table[index] && table[index] != &DELETED_VAR)
+        {
+            *table[index] = move(user);
+            return {table[index], false};
+        }
+        if (index < 0)
+        {
+            cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+            return {nullptr, false};
+        }
+        User *copy = new User(move(user));
+        claim(index, copy, attempts);
+        return {copy, true};
     }
 
     /**
@@ -353,16 +854,17 @@ public:
      */
     User *search(const string &key)
     {
+        TRACE_OPERATION("CloseHashTableUserName::search");
         int i = 0;
-        unsigned int index = hashing_method(key, max_size, i);
+        unsigned int index = TRACED("hash", hashing_method(key, max_size, i));
         while (i < MAX_ATTEMPTS && table[index])
         {
-            if (table[index]->userName == key)
+            if (table[index] != &DELETED_VAR && TRACED("compare", table[index]->userName == key))
             {
                 return table[index];
             }
             i++;
-            index = hashing_method(key, max_size, i);
+            index = TRACED("hash", hashing_method(key, max_size, i));
         }
         return nullptr;
     }
@@ -374,8 +876,9 @@ public:
      */
     void remove(const string &key)
     {
+        TRACE_OPERATION("CloseHashTableUserName::remove");
         int i = 0;
-        unsigned int index = hashing_method(key, max_size, i);
+        unsigned int index = TRACED("hash", hashing_method(key, max_size, i));
         while (i < MAX_ATTEMPTS && table[index])
         {
             if (!table[index])
@@ -383,14 +886,18 @@ public:
                 // Esto pasa cuando nos encontramos con un espacio al cual nunca se ha accedido.
                 return;
             }
-            if (table[index]->userName == key)
+            if (table[index] != &DELETED_VAR && TRACED("compare", table[index]->userName == key))
             {
-                table[index] = new User(DELETED_VAR);
+                delete table[index];
+                table[index] = &DELETED_VAR;
                 size--;
+                tombstones++;
+                if (auto_compact && !compact_failed && tombstones > MAX_TOMBSTONE_RATIO * max_size)
+                    compact();
                 return;
             }
             i++;
-            index = hashing_method(key, max_size, i);
+            index = TRACED("hash", hashing_method(key, max_size, i));
         }
     }
 
@@ -406,7 +913,7 @@ public:
         for (auto element : table)
         {
             count += 8; //< tamaño de los punteros
-            if (element)
+            if (element && element != &DELETED_VAR)
             {
                 count += user_size;
             }
@@ -417,6 +924,259 @@ public:
 
         return count;
     }
+
+    /**
+     * @brief Compacta la tabla: reinserta todos los usuarios en un arreglo nuevo sin eliminados, así las
+     * secuencias de prueba vuelven a terminar en espacios vacíos. Los usuarios no se copian, solo se mueven los punteros.
+     * @return false si algún usuario no cabe en MAX_ATTEMPTS intentos, la tabla queda como estaba (con sus eliminados)
+     * y remove deja de compactar sola hasta el siguiente compact() o rehash() exitoso.
+     */
+    bool compact()
+    {
+        TRACE_SPAN("compact");
+        int collisions;
+        if (!rebuild(max_size, collisions))
+        {
+            cout << "No se pudo compactar la tabla: un usuario no cabe en MAX_ATTEMPTS intentos." << endl;
+            // cada remove volvería a recorrer toda la tabla para fallar igual, se espera a un rehash()
+            compact_failed = true;
+            return false;
+        }
+        compactions++;
+        return true;
+    }
+
+    /**
+     * @brief Cambia el tamaño de la tabla reinsertando todos los usuarios (sin eliminados) en un arreglo de
+     * new_size espacios, para hacerla crecer cuando se llena. Los usuarios no se copian, solo se mueven los punteros.
+     * @param new_size Nuevo tamaño, debe ser mayor que la cantidad de usuarios (conviene un primo).
+     * @return false si new_size no alcanza o algún usuario no cabe en MAX_ATTEMPTS intentos, la tabla queda como estaba.
+     */
+    bool rehash(int new_size)
+    {
+        int collisions;
+        if (new_size <= size || !rebuild(new_size, collisions))
+        {
+            cout << "No se pudo cambiar el tamaño de la tabla a " << new_size << " (hay " << size << " usuarios)." << endl;
+            return false;
+        }
+        totalCollisions = collisions;
+        return true;
+    }
+
+    /**
+     * @brief Proporción de la tabla ocupada por eliminados.
+     */
+    double tombstone_ratio()
+    {
+        return (double)tombstones / max_size;
+    }
+
+    /**
+     * @brief Inserta todos los usuarios de un vector usando varios hilos, queda igual que llamando insert() con cada uno.
+     * Los usuarios se reparten (partición radix) según el rango de la tabla donde cae su primer intento y cada hilo
+     * llena sus rangos sin locks. Los usuarios cuya secuencia de prueba sale de su rango se insertan al final en un solo hilo.
+     * @param users Usuarios a insertar, se copian.
+     * @param n_threads Cantidad de hilos, 0 para usar todos los de la máquina.
+     */
+    void bulk_load(const vector<User> &users, int n_threads = 0)
+    {
+        int n_partitions = bulk_partitions(n_threads, max_size);
+        Partitions partitions = radix_partition(users.size(), n_partitions, n_threads, [&](size_t i)
+                                                { return slot_partition(hashing_method(users[i].userName, max_size, 0), max_size, n_partitions); });
+
+        vector<vector<uint32_t>> deferred(n_partitions);
+        vector<int> collisions(n_partitions, 0), placed(n_partitions, 0), reused(n_partitions, 0);
+        parallel_partitions(n_partitions, n_threads, [&](int p, int)
+                            {
+                                size_t first = partition_begin(p, max_size, n_partitions);
+                                size_t last = partition_begin(p + 1, max_size, n_partitions);
+                                for (size_t j = partitions.offsets[p]; j < partitions.offsets[p + 1]; j++)
+                                {
+                                    uint32_t i = partitions.order[j];
+                                    User *copy = new User(users[i]);
+                                    int attempts = place_in_range(users[i].userName, copy, first, last, reused[p]);
+                                    if (attempts < 0)
+                                    {
+                                        delete copy;
+                                        deferred[p].push_back(i);
+                                        continue;
+                                    }
+                                    collisions[p] += attempts;
+                                    placed[p]++;
+                                } });
+
+        for (int p = 0; p < n_partitions; p++)
+        {
+            totalCollisions += collisions[p];
+            size += placed[p];
+            tombstones -= reused[p];
+        }
+        for (const vector<uint32_t> &rest : deferred)
+        {
+            for (uint32_t i : rest)
+            {
+                User *copy = new User(users[i]);
+                int attempts = place(users[i].userName, copy);
+                if (attempts < 0)
+                {
+                    delete copy;
+                    cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+                    continue;
+                }
+                totalCollisions += attempts;
+                size++;
+            }
+        }
+    }
+
+private:
+    bool compact_failed = false; ///< El último compact() falló, remove no vuelve a intentarlo hasta otro rebuild exitoso.
+
+    /**
+     * @brief Reinserta todos los usuarios (sin eliminados) en un arreglo nuevo de new_size espacios, con el mismo
+     * allocator así el arreglo nuevo usa las mismas páginas que el anterior.
+     * @param collisions Colisiones de las reinserciones.
+     * @return false si algún usuario no cabe en MAX_ATTEMPTS intentos: se vuelve al arreglo anterior (que todavía
+     * tiene a todos los usuarios), así ninguno se pierde.
+     */
+    bool rebuild(int new_size, int &collisions)
+    {
+        HugePageVector<User *> old_table(new_size, nullptr, table.get_allocator());
+        old_table.swap(table);
+        int old_size = max_size;
+        max_size = new_size;
+        collisions = 0;
+        for (User *user : old_table)
+        {
+            if (!user || user == &DELETED_VAR)
+                continue;
+            int attempts = place(user->userName, user);
+            if (attempts < 0)
+            {
+                table.swap(old_table);
+                max_size = old_size;
+                return false;
+            }
+            collisions += attempts;
+        }
+        tombstones = 0;
+        compact_failed = false;
+        return true;
+    }
+
+    /**
+     * @brief Guarda el puntero en el primer espacio vacío o eliminado de la secuencia de prueba de key.
+     * @return Cantidad de colisiones hasta encontrar el espacio, -1 si no se encontro.
+     */
+    int place(const string &key, User *user)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            unsigned int index = TRACED("hash", hashing_method(key, max_size, i));
+            if (!table[index] || table[index] == &DELETED_VAR)
+            {
+                if (table[index] == &DELETED_VAR)
+                    tombstones--;
+                table[index] = user;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Igual que place() pero solo usa espacios en [first, last), para bulk_load.
+     * @param reused Se incrementa si el espacio usado era un eliminado.
+     * @return Cantidad de colisiones, -1 si la secuencia de prueba sale del rango antes de encontrar un espacio.
+     */
+    int place_in_range(const string &key, User *user, size_t first, size_t last, int &reused)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            unsigned int index = hashing_method(key, max_size, i);
+            if (index < first || index >= last)
+                return -1;
+            if (!table[index] || table[index] == &DELETED_VAR)
+            {
+                if (table[index] == &DELETED_VAR)
+                    reused++;
+                table[index] = user;
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Recorre la secuencia de prueba de key una vez: devuelve el espacio de key si está, si no el primer
+     * eliminado que se cruzó o el espacio vacío donde terminó la secuencia.
+     * @param attempts Intentos hasta el espacio devuelto (las colisiones si se inserta ahí).
+     * @return Posición del espacio, -1 si no está y no hay espacio libre en MAX_ATTEMPTS intentos.
+     */
+    int find_or_free(const string &key, int &attempts)
+    {
+        int free_slot = -1;
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int index = TRACED("hash", hashing_method(key, max_size, i));
+            User *user = table[index];
+            if (!user)
+            {
+                if (free_slot < 0)
+                {
+                    free_slot = index;
+                    attempts = i;
+                }
+                return free_slot;
+            }
+            if (user == &DELETED_VAR)
+            {
+                if (free_slot < 0)
+                {
+                    free_slot = index;
+                    attempts = i;
+                }
+            }
+            else if (TRACED("compare", user->userName == key))
+            {
+                attempts = i;
+                return index;
+            }
+        }
+        return free_slot;
+    }
+
+    /**
+     * @brief Guarda un usuario nuevo en un espacio libre que devolvió find_or_free.
+     */
+    void claim(int index, User *user, int attempts)
+    {
+        if (table[index] == &DELETED_VAR)
+            tombstones--;
+        table[index] = user;
+        totalCollisions += attempts;
+        size++;
+    }
+
+    /**
+     * @brief Guarda un usuario ya reservado en el heap, la tabla pasa a ser su dueña (lo libera si no cabe).
+     * @return El mismo puntero, nullptr si la tabla está llena.
+     */
+    User *adopt(User *user)
+    {
+        TRACE_OPERATION("CloseHashTableUserName::insert");
+        int attempts = place(user->userName, user);
+        if (attempts < 0)
+        {
+            delete user;
+            cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+            return nullptr;
+        }
+        totalCollisions += attempts;
+        size++;
+        return user;
+    }
 };
 
 /**
@@ -438,15 +1198,16 @@ public:
     OpenHashTableUserName(int size) : max_size(size), table(size){};
 
     /**
-     * @brief Inserta un usuario en la tabla hash.
+     * @brief Guarda el puntero a un usuario sin copiarlo, la tabla es un indice sobre usuarios que viven afuera
+     * (el usuario debe vivir más que la tabla). Es lo mismo que insert_ref().
      *
      * @param key nombre del usuario a insertar.
      * @param user Un puntero al objeto User que contiene los datos del usuario.
      */
     void insert(const string &key, User *user_data)
     {
-
-        unsigned int index = hashing_method(key);
+        TRACE_OPERATION("OpenHashTableUserName::insert");
+        unsigned int index = TRACED("hash", hashing_method(key));
         if (!table[index].empty())
         {
             totalCollisions++;
@@ -456,6 +1217,15 @@ public:
         size++;
     }
 
+    /**
+     * @brief Guarda el puntero a un usuario sin copiarlo ni ser dueña de él, el nombre deja explícito que
+     * el usuario debe vivir más que la tabla.
+     */
+    void insert_ref(const string &key, User *user)
+    {
+        insert(key, user);
+    }
+
     /**
      *@brief Devuelve el numero total de colisiones que hubo en una Tabla Hash dependiendo
      * del metodo de resolucion de colisiones utilizado
@@ -475,10 +1245,11 @@ public:
      */
     User *search(const string &key)
     {
-        unsigned int index = hashing_method(key);
+        TRACE_OPERATION("OpenHashTableUserName::search");
+        unsigned int index = TRACED("hash", hashing_method(key));
         for (User *user : table[index])
         {
-            if (user->userName == key)
+            if (TRACED("compare", user->userName == key))
                 return user;
         }
         return nullptr;
@@ -490,13 +1261,14 @@ public:
      */
     void remove(const string &key)
     {
-        unsigned int index = hashing_method(key);
+        TRACE_OPERATION("OpenHashTableUserName::remove");
+        unsigned int index = TRACED("hash", hashing_method(key));
         auto &bucket = table[index];
         int bucket_size = bucket.size();
 
         for (int i = 0; i < bucket_size; i++)
         {
-            if (bucket.at(i)->userName == key)
+            if (TRACED("compare", bucket.at(i)->userName == key))
             {
                 // Esto es iniciar el iterador y moverlo hasta el indice correspondiente
                 bucket.erase(bucket.begin() + i);
@@ -515,15 +1287,14 @@ public:
         // considerando el tamaño promedio de un usuario en memoria de 70 bytes
         int user_size = 70;
 
-        for (auto bucket : table)
+        // por referencia, para no copiar cada bucket al recorrerlo
+        for (const auto &bucket : table)
         {
             // tamaño usado por vector
             count += sizeof(bucket);
 
-            for (auto element : bucket)
-            {
-                count += 8 + user_size; //< Se le esta sumando el tamaño del puntero (lo que se guarda) y del struct
-            }
+            //< Se le esta sumando el tamaño del puntero (lo que se guarda) y del struct por cada elemento
+            count += bucket.size() * (8 + user_size);
         }
         // espacio usado por el resto de variables
         count += sizeof(max_size);
@@ -532,6 +1303,48 @@ public:
         return count;
     }
 
+    /**
+     * @brief Inserta todos los usuarios de un vector usando varios hilos, queda igual que llamando insert() con cada uno.
+     * Los usuarios se reparten (partición radix) según el rango de buckets al que van, y cada hilo reserva el
+     * tamaño final de sus buckets antes de llenarlos, sin locks.
+     * @param users Usuarios a insertar, la tabla guarda punteros a este vector.
+     * @param n_threads Cantidad de hilos, 0 para usar todos los de la máquina.
+     */
+    void bulk_load(vector<User> &users, int n_threads = 0)
+    {
+        int n_partitions = bulk_partitions(n_threads, max_size);
+        vector<unsigned int> index(users.size());
+        Partitions partitions = radix_partition(users.size(), n_partitions, n_threads, [&](size_t i)
+                                                {
+                                                    index[i] = hashing_method(users[i].userName);
+                                                    return slot_partition(index[i], max_size, n_partitions); });
+
+        vector<int> collisions(n_partitions, 0);
+        parallel_partitions(n_partitions, n_threads, [&](int p, int)
+                            {
+                                size_t first = partitions.offsets[p], last = partitions.offsets[p + 1];
+                                size_t bucket_base = partition_begin(p, max_size, n_partitions);
+                                vector<int> pending(partition_begin(p + 1, max_size, n_partitions) - bucket_base, 0);
+                                for (size_t j = first; j < last; j++)
+                                    pending[index[partitions.order[j]] - bucket_base]++;
+                                for (size_t b = 0; b < pending.size(); b++)
+                                {
+                                    if (pending[b] > 0)
+                                        table[bucket_base + b].reserve(table[bucket_base + b].size() + pending[b]);
+                                }
+                                for (size_t j = first; j < last; j++)
+                                {
+                                    uint32_t i = partitions.order[j];
+                                    if (!table[index[i]].empty())
+                                        collisions[p]++;
+                                    table[index[i]].push_back(&users[i]);
+                                } });
+
+        for (int count : collisions)
+            totalCollisions += count;
+        size += users.size();
+    }
+
 private:
     /**
      * @brief remueve un usuario en la tabla hash por su UserName, si este no existe no hace nada.
@@ -546,4 +1359,456 @@ private:
     }
 };
 
+//---------------------------------------------------------------//
+//-------------TABLAS DE ENCADENAMIENTO CON POOL DE NODOS--------//
+//---------------------------------------------------------------//
+
+/**
+ * @brief Tabla hash con encadenamiento donde todos los nodos viven en un solo arreglo contiguo (pool).
+ *
+ * A diferencia de OpenHashTableUserId/OpenHashTableUserName (vector<vector<User *>>, 24 bytes por bucket vacío y
+ * una reserva de memoria por bucket no vacío), cada bucket es un indice de 32 bits al primer nodo de su lista
+ * y cada nodo guarda el hash de la clave, la fila del usuario en rows y el indice del siguiente nodo.
+ * Los nodos eliminados quedan en una lista libre y se reutilizan, por lo que no hay reservas de memoria por bucket.
+ *
+ * @tparam Key unsigned long long para usar userId de clave, string para usar userName.
+ *
+ * @note La tabla no copia los usuarios: guarda su posición en el vector rows, que debe vivir más que la tabla.
+ */
+template <typename Key>
+class NodePoolHashTable
+{
+public:
+    static constexpr uint32_t NIL = 0xffffffff; ///< Fin de lista.
+
+    /**
+     * @brief Nodo de una lista (16 bytes).
+     */
+    struct Node
+    {
+        unsigned long long hash; ///< Hash de 64 bits de la clave, se compara antes que la clave.
+        uint32_t row;            ///< Posición del usuario en rows.
+        uint32_t next;           ///< Siguiente nodo de la lista o NIL.
+    };
+
+    int max_size;            ///< Cantidad de buckets.
+    int size = 0;            ///< Cantidad de usuarios en la tabla.
+    int totalCollisions = 0; ///< Inserciones en un bucket no vacío.
+    vector<User> *rows;      ///< Usuarios a los que apuntan los nodos.
+    HugePageVector<uint32_t> heads; ///< Primer nodo de cada bucket o NIL.
+    HugePageVector<Node> nodes;     ///< Pool de nodos.
+    uint32_t free_list = NIL; ///< Primer nodo libre (los libres se encadenan por next).
+
+    /**
+     * @brief Constructor de la tabla.
+     * @param size Cantidad de buckets.
+     * @param rows Vector con los usuarios, insert recibe posiciones de este vector.
+     */
+    NodePoolHashTable(int size, vector<User> &rows) : max_size(size), rows(&rows), heads(size, NIL) {}
+
+    /**
+     * @brief Inserta un usuario en la tabla.
+     * @param key Clave del usuario.
+     * @param row Posición del usuario en rows.
+     */
+    void insert(const Key &key, uint32_t row)
+    {
+        TRACE_OPERATION("NodePoolHashTable::insert");
+        unsigned long long hash = TRACED("hash", UserKey<Key>::hash(key));
+        uint32_t bucket = hash % max_size;
+        if (heads[bucket] != NIL)
+        {
+            totalCollisions++;
+        }
+
+        uint32_t node = new_node();
+        nodes[node] = {hash, row, heads[bucket]};
+        heads[bucket] = node;
+        size++;
+    }
+
+    /**
+     *@brief Devuelve el numero total de colisiones que hubo en la tabla.
+     */
+    int getCollision()
+    {
+        return totalCollisions;
+    }
+
+    /**
+     * @brief Busca un usuario en la tabla hash por su clave.
+     * @return Puntero al usuario dentro de rows, nullptr si no se encontró.
+     */
+    User *search(const Key &key)
+    {
+        TRACE_OPERATION("NodePoolHashTable::search");
+        unsigned long long hash = TRACED("hash", UserKey<Key>::hash(key));
+        for (uint32_t node = heads[hash % max_size]; node != NIL; node = nodes[node].next)
+        {
+            if (nodes[node].hash == hash && TRACED("compare", UserKey<Key>::get((*rows)[nodes[node].row]) == key))
+                return &(*rows)[nodes[node].row];
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Elimina un usuario de la tabla por su clave, si no existe no hace nada.
+     */
+    void remove(const Key &key)
+    {
+        TRACE_OPERATION("NodePoolHashTable::remove");
+        unsigned long long hash = TRACED("hash", UserKey<Key>::hash(key));
+        // link apunta al indice que hay que modificar para sacar el nodo (la cabeza del bucket o el next del anterior)
+        uint32_t *link = &heads[hash % max_size];
+        while (*link != NIL)
+        {
+            Node &node = nodes[*link];
+            if (node.hash == hash && TRACED("compare", UserKey<Key>::get((*rows)[node.row]) == key))
+            {
+                uint32_t removed = *link;
+                *link = node.next;
+                node.next = free_list;
+                free_list = removed;
+                size--;
+                return;
+            }
+            link = &node.next;
+        }
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por la estructura de datos en bytes.
+     */
+    size_t get_memory_usage()
+    {
+        size_t count = 0;
+        // considerando el tamaño promedio de un usuario en memoria de 70 bytes
+        int user_size = 70;
+
+        count += heads.size() * sizeof(uint32_t);
+        count += nodes.capacity() * sizeof(Node);
+        count += size * user_size;
+        // espacio usado por el resto de variables
+        count += sizeof(max_size);
+        count += sizeof(size);
+
+        return count;
+    }
+
+    /**
+     * @brief Inserta todas las filas de rows usando varios hilos, queda igual que llamando insert() con cada una.
+     * Las filas se reparten (partición radix) según el rango de buckets al que van y los nodos nuevos se reservan
+     * de una vez, en el orden de las particiones: cada hilo enlaza sus nodos en sus buckets sin locks, y los nodos
+     * de buckets cercanos quedan cerca en el pool.
+     * @param n_threads Cantidad de hilos, 0 para usar todos los de la máquina.
+     */
+    void bulk_load(int n_threads = 0)
+    {
+        size_t n = rows->size();
+        int n_partitions = bulk_partitions(n_threads, max_size);
+        vector<unsigned long long> hashes(n);
+        Partitions partitions = radix_partition(n, n_partitions, n_threads, [&](size_t i)
+                                                {
+                                                    hashes[i] = UserKey<Key>::hash(UserKey<Key>::get((*rows)[i]));
+                                                    return slot_partition(hashes[i] % max_size, max_size, n_partitions); });
+
+        size_t base = nodes.size();
+        nodes.resize(base + n);
+        vector<int> collisions(n_partitions, 0);
+        parallel_partitions(n_partitions, n_threads, [&](int p, int)
+                            {
+                                for (size_t j = partitions.offsets[p]; j < partitions.offsets[p + 1]; j++)
+                                {
+                                    uint32_t row = partitions.order[j];
+                                    uint32_t bucket = hashes[row] % max_size;
+                                    if (heads[bucket] != NIL)
+                                        collisions[p]++;
+                                    nodes[base + j] = {hashes[row], row, heads[bucket]};
+                                    heads[bucket] = base + j;
+                                } });
+
+        for (int count : collisions)
+            totalCollisions += count;
+        size += n;
+    }
+
+private:
+    /**
+     * @brief Devuelve un nodo libre, reutilizando uno eliminado si existe.
+     */
+    uint32_t new_node()
+    {
+        if (free_list != NIL)
+        {
+            uint32_t node = free_list;
+            free_list = nodes[node].next;
+            return node;
+        }
+        nodes.push_back(Node());
+        return nodes.size() - 1;
+    }
+};
+
+typedef NodePoolHashTable<unsigned long long> NodePoolHashTableUserId;
+typedef NodePoolHashTable<string> NodePoolHashTableUserName;
+
+//---------------------------------------------------------------//
+//---------TABLAS DE ENCADENAMIENTO CON BUCKETS DE 64 BYTES------//
+//---------------------------------------------------------------//
+
+/**
+ * @brief Tabla hash con encadenamiento donde cada bucket ocupa exactamente una linea de cache (64 bytes).
+ *
+ * Cada bucket guarda hasta BUCKET_SLOTS pares (huella, fila) directamente en el bucket y un puntero a un bucket de
+ * desborde para cuando se llena. Con los factores de carga de main.cpp (hasta ~0.94) la cadena promedio tiene
+ * cerca de un elemento, por lo que casi todas las busquedas leen una sola linea de cache y comparan la clave
+ * completa solo cuando la huella de 16 bits coincide.
+ *
+ * @tparam Key unsigned long long para usar userId de clave, string para usar userName.
+ *
+ * @note La tabla no copia los usuarios: guarda su posición en el vector rows, que debe vivir más que la tabla.
+ */
+template <typename Key>
+class BucketHashTable
+{
+public:
+    static constexpr int BUCKET_SLOTS = 9; ///< Pares (huella, fila) por bucket.
+
+    /**
+     * @brief Bucket de 64 bytes: puntero de desborde (8), filas (9 * 4), huellas (9 * 2) y cantidad (1).
+     */
+    struct alignas(64) Bucket
+    {
+        Bucket *overflow = nullptr;         ///< Siguiente bucket de la cadena.
+        uint32_t rows[BUCKET_SLOTS];        ///< Posición de cada usuario en rows.
+        uint16_t fingerprints[BUCKET_SLOTS]; ///< 16 bits altos del hash de cada clave.
+        uint8_t count = 0;                  ///< Pares ocupados.
+    };
+    static_assert(sizeof(Bucket) == 64, "un bucket debe ocupar una linea de cache");
+
+    int max_size;               ///< Cantidad de buckets.
+    int size = 0;               ///< Cantidad de usuarios en la tabla.
+    int totalCollisions = 0;    ///< Inserciones en un bucket no vacío.
+    int overflow_buckets = 0;   ///< Buckets de desborde reservados.
+    vector<User> *rows;         ///< Usuarios a los que apuntan los buckets.
+    HugePageVector<Bucket> buckets; ///< Buckets principales.
+
+    /**
+     * @brief Constructor de la tabla.
+     * @param size Cantidad de buckets.
+     * @param rows Vector con los usuarios, insert recibe posiciones de este vector.
+     */
+    BucketHashTable(int size, vector<User> &rows) : max_size(size), rows(&rows), buckets(size) {}
+
+    BucketHashTable(const BucketHashTable &) = delete;
+    BucketHashTable &operator=(const BucketHashTable &) = delete;
+
+    ~BucketHashTable()
+    {
+        for (Bucket &bucket : buckets)
+        {
+            Bucket *overflow = bucket.overflow;
+            while (overflow)
+            {
+                Bucket *next = overflow->overflow;
+                delete overflow;
+                overflow = next;
+            }
+        }
+    }
+
+    /**
+     * @brief Inserta un usuario en la tabla, en el primer bucket de la cadena que tenga espacio.
+     * @param key Clave del usuario.
+     * @param row Posición del usuario en rows.
+     */
+    void insert(const Key &key, uint32_t row)
+    {
+        TRACE_OPERATION("BucketHashTable::insert");
+        unsigned long long hash = TRACED("hash", UserKey<Key>::hash(key));
+        Bucket *bucket = &buckets[hash % max_size];
+        if (bucket->count > 0)
+        {
+            totalCollisions++;
+        }
+
+        while (bucket->count == BUCKET_SLOTS)
+        {
+            if (!bucket->overflow)
+            {
+                bucket->overflow = new Bucket();
+                overflow_buckets++;
+            }
+            bucket = bucket->overflow;
+        }
+        bucket->rows[bucket->count] = row;
+        bucket->fingerprints[bucket->count] = fingerprint(hash);
+        bucket->count++;
+        size++;
+    }
+
+    /**
+     *@brief Devuelve el numero total de colisiones que hubo en la tabla.
+     */
+    int getCollision()
+    {
+        return totalCollisions;
+    }
+
+    /**
+     * @brief Busca un usuario en la tabla hash por su clave.
+     * @return Puntero al usuario dentro de rows, nullptr si no se encontró.
+     */
+    User *search(const Key &key)
+    {
+        TRACE_OPERATION("BucketHashTable::search");
+        unsigned long long hash = TRACED("hash", UserKey<Key>::hash(key));
+        uint16_t print = fingerprint(hash);
+        for (Bucket *bucket = &buckets[hash % max_size]; bucket; bucket = bucket->overflow)
+        {
+            for (int i = 0; i < bucket->count; i++)
+            {
+                if (bucket->fingerprints[i] == print && TRACED("compare", UserKey<Key>::get((*rows)[bucket->rows[i]]) == key))
+                    return &(*rows)[bucket->rows[i]];
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * @brief Elimina un usuario de la tabla por su clave, si no existe no hace nada.
+     * El hueco se llena con el último par del mismo bucket y los buckets de desborde vacíos se liberan.
+     */
+    void remove(const Key &key)
+    {
+        TRACE_OPERATION("BucketHashTable::remove");
+        unsigned long long hash = TRACED("hash", UserKey<Key>::hash(key));
+        uint16_t print = fingerprint(hash);
+        Bucket *previous = nullptr;
+        for (Bucket *bucket = &buckets[hash % max_size]; bucket; previous = bucket, bucket = bucket->overflow)
+        {
+            for (int i = 0; i < bucket->count; i++)
+            {
+                if (bucket->fingerprints[i] == print && TRACED("compare", UserKey<Key>::get((*rows)[bucket->rows[i]]) == key))
+                {
+                    bucket->count--;
+                    bucket->rows[i] = bucket->rows[bucket->count];
+                    bucket->fingerprints[i] = bucket->fingerprints[bucket->count];
+                    if (bucket->count == 0 && previous)
+                    {
+                        previous->overflow = bucket->overflow;
+                        delete bucket;
+                        overflow_buckets--;
+                    }
+                    size--;
+                    return;
+                }
+            }
+        }
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por la estructura de datos en bytes.
+     */
+    size_t get_memory_usage()
+    {
+        size_t count = 0;
+        // considerando el tamaño promedio de un usuario en memoria de 70 bytes
+        int user_size = 70;
+
+        count += (buckets.size() + overflow_buckets) * sizeof(Bucket);
+        count += size * user_size;
+        // espacio usado por el resto de variables
+        count += sizeof(max_size);
+        count += sizeof(size);
+
+        return count;
+    }
+
+    /**
+     * @brief Inserta todas las filas de rows usando varios hilos, queda igual que llamando insert() con cada una.
+     * Las filas se reparten (partición radix) según el rango de buckets al que van y cada hilo llena sus buckets sin locks.
+     * @param n_threads Cantidad de hilos, 0 para usar todos los de la máquina.
+     */
+    void bulk_load(int n_threads = 0)
+    {
+        size_t n = rows->size();
+        int n_partitions = bulk_partitions(n_threads, max_size);
+        vector<unsigned long long> hashes(n);
+        Partitions partitions = radix_partition(n, n_partitions, n_threads, [&](size_t i)
+                                                {
+                                                    hashes[i] = UserKey<Key>::hash(UserKey<Key>::get((*rows)[i]));
+                                                    return slot_partition(hashes[i] % max_size, max_size, n_partitions); });
+
+        vector<int> collisions(n_partitions, 0), overflows(n_partitions, 0);
+        parallel_partitions(n_partitions, n_threads, [&](int p, int)
+                            {
+                                for (size_t j = partitions.offsets[p]; j < partitions.offsets[p + 1]; j++)
+                                {
+                                    uint32_t row = partitions.order[j];
+                                    Bucket *bucket = &buckets[hashes[row] % max_size];
+                                    if (bucket->count > 0)
+                                        collisions[p]++;
+                                    while (bucket->count == BUCKET_SLOTS)
+                                    {
+                                        if (!bucket->overflow)
+                                        {
+                                            bucket->overflow = new Bucket();
+                                            overflows[p]++;
+                                        }
+                                        bucket = bucket->overflow;
+                                    }
+                                    bucket->rows[bucket->count] = row;
+                                    bucket->fingerprints[bucket->count] = fingerprint(hashes[row]);
+                                    bucket->count++;
+                                } });
+
+        for (int p = 0; p < n_partitions; p++)
+        {
+            totalCollisions += collisions[p];
+            overflow_buckets += overflows[p];
+        }
+        size += n;
+    }
+
+private:
+    /// Los 16 bits altos del hash, el bucket se elige con el hash completo (módulo) por lo que son casi independientes.
+    static uint16_t fingerprint(unsigned long long hash)
+    {
+        return hash >> 48;
+    }
+};
+
+typedef BucketHashTable<unsigned long long> BucketHashTableUserId;
+typedef BucketHashTable<string> BucketHashTableUserName;
+
+/**
+ * @brief Qué usuario se queda cuando el CSV tiene varias filas con la misma clave.
+ */
+enum DuplicatePolicy
+{
+    keep_first, ///< El primero del archivo (igual que delete_duplicates.py), con try_emplace.
+    keep_last,  ///< El último del archivo, con insert_or_assign.
+};
+
+/**
+ * @brief Carga un CSV en una tabla cerrada eliminando los duplicados mientras lee, sin el paso previo de
+ * delete_duplicates.py: cada fila se inserta con try_emplace o insert_or_assign según policy, que buscan la clave
+ * y el espacio donde insertarla en una sola pasada.
+ *
+ * @tparam Table CloseHashTableUserId (duplicados por userId) o CloseHashTableUserName (duplicados por userName).
+ * @param filename: nombre del archivo con extención.
+ * @return Cantidad de filas leídas (la cantidad de usuarios sin repetir queda en table.size).
+ */
+template <typename Table>
+size_t load_csv_unique(const string &filename, Table &table, DuplicatePolicy policy)
+{
+    return for_each_csv_user(filename, [&](User &&user)
+                             {
+                                 if (policy == keep_first)
+                                     table.try_emplace(UserKey<typename Table::key_type>::get(user), move(user));
+                                 else
+                                     table.insert_or_assign(move(user)); });
+}
+
 #endif
\ No newline at end of file
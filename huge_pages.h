@@ -0,0 +1,170 @@
+#ifndef HUGE_PAGES
+#define HUGE_PAGES
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <sstream>
+#include <new>
+#include <atomic>
+#include <type_traits>
+#include <cstdint>
+#include <sys/mman.h>
+
+using namespace std;
+
+/*
+Memoria respaldada por páginas grandes (2 MB) para los arreglos de las tablas.
+
+Con millones de espacios, cada busqueda cae en una página de 4 KB distinta y casi siempre falla en la TLB (que
+tiene del orden de 1500 entradas, o sea cubre ~6 MB con páginas de 4 KB pero ~3 GB con páginas de 2 MB).
+Los arreglos grandes se reservan con mmap alineados a 2 MB: primero se piden páginas grandes explícitas
+(MAP_HUGETLB, solo funciona si el sistema tiene páginas reservadas) y si no hay, páginas normales con
+madvise(MADV_HUGEPAGE) para que el kernel use páginas grandes transparentes si están activadas. Si ninguna de
+las dos está disponible la memoria queda con páginas normales, sin error.
+*/
+
+constexpr size_t HUGE_PAGE_SIZE = 2 << 20; ///< Tamaño de una página grande en x86-64.
+
+/**
+ * @brief Si las tablas que se construyan desde ahora usan páginas grandes (cada tabla lo fija al construirse).
+ */
+bool huge_pages_enabled = false;
+
+atomic<size_t> huge_page_mapped_bytes(0); ///< Bytes reservados ahora con huge_page_allocate.
+atomic<size_t> hugetlb_allocations(0);    ///< Reservas que obtuvieron páginas grandes explícitas (MAP_HUGETLB).
+
+/**
+ * @brief Reserva bytes (redondeado a 2 MB) alineados a 2 MB, con páginas grandes si se puede.
+ * @throws bad_alloc si mmap falla.
+ */
+void *huge_page_allocate(size_t bytes)
+{
+    size_t length = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    void *pointer = mmap(nullptr, length, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+    if (pointer != MAP_FAILED)
+    {
+        hugetlb_allocations++;
+        huge_page_mapped_bytes += length;
+        return pointer;
+    }
+
+    // se pide 2 MB de más y se recorta, así el inicio queda alineado y el kernel puede usar páginas grandes
+    pointer = mmap(nullptr, length + HUGE_PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (pointer == MAP_FAILED)
+        throw bad_alloc();
+    uintptr_t start = (uintptr_t)pointer;
+    uintptr_t aligned = (start + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    if (aligned > start)
+        munmap(pointer, aligned - start);
+    munmap((void *)(aligned + length), start + HUGE_PAGE_SIZE - aligned);
+    madvise((void *)aligned, length, MADV_HUGEPAGE);
+    huge_page_mapped_bytes += length;
+    return (void *)aligned;
+}
+
+/**
+ * @brief Libera memoria de huge_page_allocate(bytes).
+ */
+void huge_page_free(void *pointer, size_t bytes)
+{
+    size_t length = (bytes + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+    // munmap sirve igual para las dos formas de reservar
+    munmap(pointer, length);
+    huge_page_mapped_bytes -= length;
+}
+
+/**
+ * @brief Allocator para vector que usa huge_page_allocate con los arreglos de al menos HUGE_PAGE_SIZE bytes
+ * si huge_pages_enabled estaba activo al crearlo (los arreglos más chicos no ganan nada y desperdiciarían memoria).
+ * El modo se copia con el allocator, así un vector siempre libera su memoria con el mismo modo con que la pidió.
+ */
+template <typename T>
+struct HugePageAllocator
+{
+    using value_type = T;
+    using propagate_on_container_copy_assignment = true_type;
+    using propagate_on_container_move_assignment = true_type;
+    using propagate_on_container_swap = true_type;
+
+    bool huge; ///< Si los arreglos grandes usan páginas grandes.
+
+    HugePageAllocator() : huge(huge_pages_enabled) {}
+    explicit HugePageAllocator(bool huge) : huge(huge) {}
+    template <typename U>
+    HugePageAllocator(const HugePageAllocator<U> &other) : huge(other.huge) {}
+
+    T *allocate(size_t n)
+    {
+        size_t bytes = n * sizeof(T);
+        if (huge && bytes >= HUGE_PAGE_SIZE)
+            return (T *)huge_page_allocate(bytes);
+        return (T *)::operator new(bytes, align_val_t(alignof(T)));
+    }
+
+    void deallocate(T *pointer, size_t n)
+    {
+        size_t bytes = n * sizeof(T);
+        if (huge && bytes >= HUGE_PAGE_SIZE)
+            huge_page_free(pointer, bytes);
+        else
+            ::operator delete(pointer, align_val_t(alignof(T)));
+    }
+};
+
+template <typename T, typename U>
+bool operator==(const HugePageAllocator<T> &a, const HugePageAllocator<U> &b)
+{
+    return a.huge == b.huge;
+}
+
+template <typename T, typename U>
+bool operator!=(const HugePageAllocator<T> &a, const HugePageAllocator<U> &b)
+{
+    return a.huge != b.huge;
+}
+
+/**
+ * @brief Vector de los arreglos de espacios de las tablas (y del almacén de UserIndex).
+ */
+template <typename T>
+using HugePageVector = vector<T, HugePageAllocator<T>>;
+
+/**
+ * @brief Modo de las páginas grandes transparentes del sistema: "always", "madvise", "never" o "" si no se pudo leer.
+ */
+string transparent_huge_pages_mode()
+{
+    ifstream file("/sys/kernel/mm/transparent_hugepage/enabled");
+    string line;
+    getline(file, line);
+    size_t left = line.find('['), right = line.find(']');
+    if (left == string::npos || right == string::npos)
+        return "";
+    return line.substr(left + 1, right - left - 1);
+}
+
+/**
+ * @brief Bytes del proceso que están realmente en páginas grandes (transparentes y explícitas), según
+ * /proc/self/smaps_rollup. 0 si el archivo no existe.
+ */
+size_t huge_page_resident_bytes()
+{
+    ifstream file("/proc/self/smaps_rollup");
+    string line;
+    size_t total = 0;
+    while (getline(file, line))
+    {
+        if (line.rfind("AnonHugePages:", 0) == 0 || line.rfind("Private_Hugetlb:", 0) == 0 ||
+            line.rfind("Shared_Hugetlb:", 0) == 0)
+        {
+            stringstream ss(line.substr(line.find(':') + 1));
+            size_t kb = 0;
+            ss >> kb;
+            total += kb * 1024;
+        }
+    }
+    return total;
+}
+
+#endif
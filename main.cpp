@@ -13,8 +13,27 @@
 
 using namespace std;
 
-int main()
+int main(int argc, char *argv[])
 {
+  // Modo de ejecución, sin argumentos se corren los experimentos originales
+  string mode = argc > 1 ? argv[1] : "";
+
+  /*
+  Modo escalamiento: usuarios generados desde 10^4 hasta el máximo pedido (por defecto 10^7),
+  el tamaño de la tabla depende del factor de carga. Uso: ./a.out scaling [max_usuarios]
+  */
+  if (mode == "scaling")
+  {
+    size_t max_users = argc > 2 ? stoull(argv[2]) : 10000000;
+    vector<size_t> sizes;
+    for (size_t n = 10000; n <= max_users; n *= 10)
+    {
+      sizes.push_back(n);
+    }
+    scaling_test(sizes, {0.25, 0.5, 0.75, 0.9}, "tests/test_escalamiento");
+    return 0;
+  }
+
   /*
   Primero guardamos los datos en los CSV dentro de vectores, exite uno para usuarios que no estaran en la base
   de datos y otros los cuales si se encontraran. Los que no se encontraran fueron generados con un
@@ -27,6 +46,209 @@ int main()
   vector<User> real_users = readCSV("universities_followers_without_duplicates.csv");
   vector<User> fake_users = readCSV("fake_data.csv");
 
+  /*
+  Modo hilos: cada tabla se construye una vez y se consulta desde 1..N hilos (por defecto los núcleos
+  disponibles). Uso: ./a.out threads [max_hilos]
+  */
+  if (mode == "threads")
+  {
+    int max_threads = argc > 2 ? stoi(argv[2]) : max(1u, thread::hardware_concurrency());
+    threads_test(max_threads, real_users, real_users, fake_users, 21089, "tests/test_hilos");
+    return 0;
+  }
+
+  // Modo indice: compara dos tablas cerradas separadas contra un UserIndex. Uso: ./a.out userindex
+  if (mode == "userindex")
+  {
+    user_index_test(10, real_users, 21089, "tests/test_user_index");
+    return 0;
+  }
+
+  // Modo fechas: consultas por rango de fecha de creación, con los usuarios reales y 10^6 generados. Uso: ./a.out dates
+  if (mode == "dates")
+  {
+    vector<User> generated = generate_users(1000000);
+    created_at_test(real_users, 10000, "tests/test_rangos_fecha");
+    created_at_test(generated, 10000, "tests/test_rangos_fecha");
+    return 0;
+  }
+
+  // Modo universidades: agregados incrementales por universidad contra recorrer los usuarios. Uso: ./a.out universities
+  if (mode == "universities")
+  {
+    university_stats_test(real_users, 100, "tests/test_universidades");
+    return 0;
+  }
+
+  // Modo bloom: busquedas con y sin filtro de Bloom delante de cada tabla. Uso: ./a.out bloom
+  if (mode == "bloom")
+  {
+    bloom_test(20, real_users, fake_users, 21089, "tests/test_bloom");
+    return 0;
+  }
+
+  // Modo churn: busquedas a lo largo de rondas de eliminaciones e inserciones. Uso: ./a.out churn
+  if (mode == "churn")
+  {
+    churn_test(100003, 50, "tests/test_churn");
+    return 0;
+  }
+
+  // Modo pool: encadenamiento con vector<vector<User *>> contra NodePoolHashTable. Uso: ./a.out pool
+  if (mode == "pool")
+  {
+    node_pool_test(20, real_users, fake_users, 21089, "tests/test_node_pool");
+    vector<User> generated = generate_users(1000000);
+    vector<User> missing = generate_missing_users(100000);
+    node_pool_test(1, generated, missing, next_prime(1000000), "tests/test_node_pool");
+    return 0;
+  }
+
+  // Modo perfecto: tabla de solo lectura con hash perfecto mínimo contra las tablas existentes. Uso: ./a.out perfect
+  if (mode == "perfect")
+  {
+    perfect_hash_test(real_users, fake_users, 0.75, "tests/test_hash_perfecto");
+    vector<User> generated = generate_users(1000000);
+    vector<User> missing = generate_missing_users(100000);
+    perfect_hash_test(generated, missing, 0.75, "tests/test_hash_perfecto");
+    return 0;
+  }
+
+  // Modo bulk: construir las tablas con insert() uno por uno contra bulk_load() en paralelo, con los usuarios reales
+  // y n usuarios generados (por defecto 2 * 10^6). Uso: ./a.out bulk [n]
+  if (mode == "bulk")
+  {
+    size_t n = argc > 2 ? stoul(argv[2]) : 2000000;
+    bulk_load_test(20, real_users, 0.75, "tests/test_bulk_load");
+    vector<User> generated = generate_users(n);
+    bulk_load_test(3, generated, 0.75, "tests/test_bulk_load");
+    return 0;
+  }
+
+  // Modo emplace: insertar copiando, moviendo o construyendo en la tabla. Para contar las reservas de memoria
+  // compilar con -DCOUNT_ALLOCATIONS. Uso: ./a.out emplace
+  if (mode == "emplace")
+  {
+    emplace_test(20, real_users, next_prime(real_users.size() / 0.75), "tests/test_emplace");
+    return 0;
+  }
+
+  // Modo prefijos: indice de prefijos sobre userName (autocompletado), con los usuarios reales y 10^6 generados.
+  // Uso: ./a.out prefix
+  if (mode == "prefix")
+  {
+    prefix_index_test(real_users, fake_users, 10000, "tests/test_prefijos");
+    vector<User> generated = generate_users(1000000);
+    vector<User> missing = generate_missing_users(100000);
+    prefix_index_test(generated, missing, 10000, "tests/test_prefijos");
+    return 0;
+  }
+
+  // Modo probe: costo de las políticas de capacidad y prueba (módulo, potencia de 2, fastmod, fastrange, primo fijo)
+  // con los usuarios reales y 10^6 generados. Uso: ./a.out probe
+  if (mode == "probe")
+  {
+    probe_policy_test(real_users, fake_users, "tests/test_politicas_prueba");
+    vector<User> generated = generate_users(1000000);
+    vector<User> missing = generate_missing_users(100000);
+    probe_policy_test(generated, missing, "tests/test_politicas_prueba");
+    return 0;
+  }
+
+  // Modo wal: operaciones por segundo registrando cada insert, update y remove en el write-ahead log con distintos
+  // tamaños de grupo de commit, y replay del log. Uso: ./a.out wal
+  if (mode == "wal")
+  {
+    wal_test(real_users, "tests", "tests/test_wal");
+    return 0;
+  }
+
+  // Modo páginas grandes: busquedas con los arreglos de las tablas en páginas de 4 KB contra páginas de 2 MB, con
+  // 10^6 y max_usuarios (por defecto 4 * 10^6) usuarios generados. Uso: ./a.out hugepages [max_usuarios]
+  if (mode == "hugepages")
+  {
+    size_t max_users = argc > 2 ? stoull(argv[2]) : 4000000;
+    huge_pages_test({1000000, max_users}, "tests/test_paginas_grandes");
+    return 0;
+  }
+
+  // Modo trazado: costo de insert, search y remove con el trazado de trace.h, comparar corriendo el programa
+  // compilado sin trazado y con -DENABLE_TRACING. Uso: ./a.out trace
+  if (mode == "trace")
+  {
+    vector<User> generated = generate_users(1000000);
+    vector<User> missing = generate_missing_users(100000);
+    trace_test(generated, missing, 5, "tests/test_trazado", "tests/trace.json");
+    return 0;
+  }
+
+  // Modo hashes: velocidad (claves/s y GB/s) y calidad (avalanche, chi-cuadrado, largo de las pruebas) de las
+  // funciones de hash con los usuarios reales y falsos. Uso: ./a.out hashes
+  if (mode == "hashes")
+  {
+    hash_throughput_test(real_users, fake_users, 5, "tests/test_hash_rendimiento");
+    hash_quality_test(real_users, fake_users, "tests/test_hash_calidad");
+    return 0;
+  }
+
+  // Modo adaptativa: AdaptiveHashTableUserId contra las estrategias de prueba fijas con los usuarios reales, falsos,
+  // n generados con ids snowflake seguidos y una deriva de ids al azar a ids seguidos. Uso: ./a.out adaptive [n]
+  if (mode == "adaptive")
+  {
+    size_t n = argc > 2 ? stoul(argv[2]) : 1000000;
+    adaptive_test(real_users, fake_users, n, 5, "tests/test_adaptativa");
+    return 0;
+  }
+
+  // Modo sin duplicados: cargar universities_followers.csv eliminando los userName repetidos con delete_duplicates.py
+  // y después C++, contra hacerlo mientras se lee con try_emplace/insert_or_assign. Uso: ./a.out dedup
+  if (mode == "dedup")
+  {
+    dedup_load_test("universities_followers.csv", "universities_followers_without_duplicates.csv", 5,
+                    "tests/test_sin_duplicados");
+    return 0;
+  }
+
+  // Modo disco: DiskHashTableUserId (hashing extensible en disco) con n usuarios generados (por defecto 10^6) y un
+  // buffer pool del tamaño de todos los datos, del 10% y del 1%, leyendo con O_DIRECT. Uso: ./a.out disk [n]
+  if (mode == "disk")
+  {
+    size_t n = argc > 2 ? stoul(argv[2]) : 1000000;
+    disk_hash_test(n, 100000, "tests", true, "tests/test_disco");
+    return 0;
+  }
+
+  // Modo join: inner, semi y anti join por userId y userName con hash_join (particiones radix del tamaño de la
+  // cache) contra construir una tabla y buscar una por una, con los usuarios reales contra los falsos, los
+  // seguidores de dos universidades y n usuarios generados (por defecto 10^6). Uso: ./a.out join [n]
+  if (mode == "join")
+  {
+    size_t n = argc > 2 ? stoul(argv[2]) : 1000000;
+    join_test(real_users, fake_users, "universities_followers.csv", n, 3, "tests/test_join");
+    return 0;
+  }
+
+  // Modo cardinalidad: error de HyperLogLog al estimar usuarios distintos (en total y por universidad) y tiempo de
+  // cargar datos con duplicados en una tabla con tamaño para todas las filas, creciendo, estimado con HyperLogLog
+  // o exacto, con el CSV con duplicados y n filas generadas (por defecto 10^6). Uso: ./a.out cardinality [n]
+  if (mode == "cardinality")
+  {
+    size_t n = argc > 2 ? stoul(argv[2]) : 1000000;
+    cardinality_test("universities_followers.csv", n, "tests/test_cardinalidad");
+    presize_test("universities_followers.csv", n, 3, "tests/test_tamano_inicial");
+    return 0;
+  }
+
+  // Modo concurrente: tabla sin locks (CAS por espacio y épocas para liberar los eliminados) contra la tabla cerrada
+  // con un mutex y sin lock, con ingesta y cargas mixtas de insert, search y remove sobre 10^6 usuarios generados
+  // desde 1..N hilos (por defecto los núcleos de la máquina). Uso: ./a.out concurrent [max_hilos]
+  if (mode == "concurrent")
+  {
+    int max_threads = argc > 2 ? stoi(argv[2]) : max(1u, thread::hardware_concurrency());
+    concurrent_test(1000000, 1000000, max_threads, 3, "tests/test_sin_locks");
+    return 0;
+  }
+
   // Tamaño de la tabla, fue elegido ya que es un número primo el cual es cercano al factor de carga muy alto, esto para comparar colisiones
   const int table_size = 21089;
 
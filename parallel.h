@@ -0,0 +1,159 @@
+#ifndef PARALLEL
+#define PARALLEL
+
+#include <vector>
+#include <thread>
+#include <atomic>
+#include <cstdint>
+
+using namespace std;
+
+/**
+ * @brief Cantidad de hilos a usar cuando se pide 0 (o menos): los que tenga la máquina.
+ */
+int resolve_threads(int n_threads)
+{
+    if (n_threads > 0)
+        return n_threads;
+    int hardware = thread::hardware_concurrency();
+    return hardware > 0 ? hardware : 1;
+}
+
+/**
+ * @brief Divide [0, n) en n_threads rangos contiguos y llama f(begin, end, t) en un hilo por rango.
+ * Con un solo hilo se llama directo, sin crear hilos.
+ */
+template <typename F>
+void parallel_for(size_t n, int n_threads, F f)
+{
+    n_threads = resolve_threads(n_threads);
+    if (n_threads == 1)
+    {
+        f((size_t)0, n, 0);
+        return;
+    }
+    vector<thread> threads;
+    for (int t = 0; t < n_threads; t++)
+    {
+        threads.emplace_back([&, t]()
+                             { f(n * t / n_threads, n * (t + 1) / n_threads, t); });
+    }
+    for (thread &th : threads)
+        th.join();
+}
+
+/**
+ * @brief Llama f(p, t) para cada partición p en [0, n_partitions), los hilos toman la siguiente partición libre
+ * de un contador atómico, así una partición grande no deja a los demás hilos esperando.
+ */
+template <typename F>
+void parallel_partitions(int n_partitions, int n_threads, F f)
+{
+    n_threads = resolve_threads(n_threads);
+    atomic<int> next(0);
+    auto worker = [&](int t)
+    {
+        for (int p = next++; p < n_partitions; p = next++)
+            f(p, t);
+    };
+    if (n_threads == 1)
+    {
+        worker(0);
+        return;
+    }
+    vector<thread> threads;
+    for (int t = 0; t < n_threads; t++)
+        threads.emplace_back(worker, t);
+    for (thread &th : threads)
+        th.join();
+}
+
+/**
+ * @brief Resultado de radix_partition: order tiene los elementos agrupados por partición, los de la
+ * partición p están en order[offsets[p]] .. order[offsets[p + 1] - 1], en su orden original.
+ */
+struct Partitions
+{
+    vector<uint32_t> order;
+    vector<size_t> offsets;
+};
+
+/**
+ * @brief Reparte los elementos [0, n) en n_partitions particiones en paralelo (partición radix de dos pasadas):
+ * cada hilo cuenta cuántos de sus elementos van a cada partición, con la suma acumulada por (partición, hilo)
+ * cada hilo sabe dónde escribir, y en la segunda pasada cada hilo copia sus elementos sin sincronizarse.
+ *
+ * @param n: cantidad de elementos.
+ * @param n_partitions: cantidad de particiones.
+ * @param n_threads: cantidad de hilos, 0 para usar todos los de la máquina.
+ * @param partition_of: función que recibe un elemento y devuelve su partición en [0, n_partitions).
+ */
+template <typename PartitionOf>
+Partitions radix_partition(size_t n, int n_partitions, int n_threads, PartitionOf partition_of)
+{
+    n_threads = resolve_threads(n_threads);
+    Partitions result;
+    result.order.resize(n);
+    result.offsets.assign(n_partitions + 1, 0);
+
+    vector<uint32_t> partition(n);
+    vector<vector<size_t>> histogram(n_threads, vector<size_t>(n_partitions, 0));
+    parallel_for(n, n_threads, [&](size_t begin, size_t end, int t)
+                 {
+                     for (size_t i = begin; i < end; i++)
+                     {
+                         partition[i] = partition_of(i);
+                         histogram[t][partition[i]]++;
+                     } });
+
+    // histogram[t][p] pasa a ser la primera posición donde el hilo t escribe la partición p
+    size_t total = 0;
+    for (int p = 0; p < n_partitions; p++)
+    {
+        result.offsets[p] = total;
+        for (int t = 0; t < n_threads; t++)
+        {
+            size_t count = histogram[t][p];
+            histogram[t][p] = total;
+            total += count;
+        }
+    }
+    result.offsets[n_partitions] = total;
+
+    parallel_for(n, n_threads, [&](size_t begin, size_t end, int t)
+                 {
+                     for (size_t i = begin; i < end; i++)
+                         result.order[histogram[t][partition[i]]++] = i; });
+    return result;
+}
+
+/**
+ * @brief Cantidad de particiones para un bulk load: una potencia de 2 con al menos 8 particiones por hilo
+ * (para repartir bien la carga), pero sin pasar de una partición cada 64 espacios de la tabla.
+ */
+int bulk_partitions(int n_threads, size_t table_size)
+{
+    int partitions = 1;
+    while (partitions < 8 * resolve_threads(n_threads) && (size_t)partitions * 2 * 64 <= table_size)
+        partitions *= 2;
+    return partitions;
+}
+
+/**
+ * @brief Partición de un espacio de la tabla: los bits altos de la posición, así cada partición es un rango
+ * contiguo de la tabla y dos particiones nunca escriben el mismo espacio.
+ */
+inline uint32_t slot_partition(size_t slot, size_t table_size, int n_partitions)
+{
+    return (uint32_t)((unsigned long long)slot * n_partitions / table_size);
+}
+
+/**
+ * @brief Primer espacio de la tabla que pertenece a la partición p (el último es partition_begin(p + 1) - 1).
+ */
+inline size_t partition_begin(int p, size_t table_size, int n_partitions)
+{
+    return ((unsigned long long)p * table_size + n_partitions - 1) / n_partitions;
+}
+
+#endif
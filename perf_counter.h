@@ -0,0 +1,95 @@
+#ifndef PERF_COUNTER
+#define PERF_COUNTER
+
+#include <cstdint>
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace std;
+
+/**
+ * @brief Contador de hardware de Linux (perf_event_open) para el hilo actual, por ejemplo fallos de la dTLB.
+ *
+ * Muchas máquinas virtuales y contenedores no dejan usar los contadores (o kernel.perf_event_paranoid no lo
+ * permite): en ese caso available() es false y stop() devuelve -1, así los tests siguen funcionando sin ellos.
+ */
+class PerfCounter
+{
+public:
+    /**
+     * @brief Abre el contador, detenido y en 0.
+     * @param type Tipo de evento (PERF_TYPE_HARDWARE, PERF_TYPE_HW_CACHE, ...).
+     * @param config Evento dentro del tipo, ver dtlb_read_misses().
+     */
+    PerfCounter(uint32_t type, uint64_t config)
+    {
+        perf_event_attr attr;
+        memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = type;
+        attr.config = config;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd = syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    PerfCounter(const PerfCounter &) = delete;
+    PerfCounter &operator=(const PerfCounter &) = delete;
+
+    ~PerfCounter()
+    {
+        if (fd >= 0)
+            close(fd);
+    }
+
+    /**
+     * @brief Fallos de la dTLB en lecturas.
+     */
+    static PerfCounter dtlb_read_misses()
+    {
+        return PerfCounter(PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                                   (PERF_COUNT_HW_CACHE_RESULT_MISS << 16));
+    }
+
+    /**
+     * @brief Si el sistema dejó abrir el contador.
+     */
+    bool available() const
+    {
+        return fd >= 0;
+    }
+
+    /**
+     * @brief Pone el contador en 0 y empieza a contar.
+     */
+    void start()
+    {
+        if (fd < 0)
+            return;
+        ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+    }
+
+    /**
+     * @brief Deja de contar y devuelve lo contado desde start(), -1 si el contador no está disponible.
+     */
+    long long stop()
+    {
+        if (fd < 0)
+            return -1;
+        ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        long long count = 0;
+        if (read(fd, &count, sizeof(count)) != sizeof(count))
+            return -1;
+        return count;
+    }
+
+private:
+    int fd = -1; ///< Descriptor del contador, -1 si no se pudo abrir.
+};
+
+#endif
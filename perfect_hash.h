@@ -0,0 +1,228 @@
+#ifndef PERFECT_HASH
+#define PERFECT_HASH
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include "functions.h"
+#include "hash_functions.h"
+#include "hash_tables.h"
+
+using namespace std;
+
+/**
+ * @brief Función de hash perfecta mínima (estilo BBHash) sobre un conjunto fijo de hashes de 64 bits.
+ *
+ * Asigna a cada una de las n claves de la construcción un número distinto en [0, n). Se construye por niveles:
+ * en cada nivel las claves que quedan se reparten en un arreglo de gamma * (claves restantes) bits; las que caen
+ * solas en su bit se quedan en ese nivel (bit en 1) y las que chocan pasan al siguiente nivel. El número de una
+ * clave es la cantidad de bits en 1 antes del suyo (rank), que se calcula con conteos acumulados cada 512 bits.
+ * Con gamma = 1 se usan cerca de 3 bits por clave.
+ *
+ * @note Para una clave que no estaba en la construcción devuelve un número cualquiera (o NOT_FOUND), por lo que
+ * siempre hay que verificar la clave.
+ */
+class MinimalPerfectHash
+{
+public:
+    static constexpr uint32_t NOT_FOUND = 0xffffffff; ///< La clave seguro no estaba en la construcción.
+    static constexpr int MAX_LEVELS = 32;             ///< Las claves que quedan después de este nivel van a fallback.
+
+    size_t n_keys = 0;              ///< Cantidad de claves.
+    vector<uint64_t> bits;          ///< Bits de todos los niveles, uno después del otro.
+    vector<uint32_t> ranks;         ///< Bits en 1 antes de cada bloque de 512 bits.
+    vector<size_t> level_offset;    ///< Primer bit de cada nivel.
+    vector<size_t> level_size;      ///< Bits de cada nivel (múltiplo de 64).
+    unordered_map<uint64_t, uint32_t> fallback; ///< Claves que no quedaron en ningún nivel.
+
+    /**
+     * @brief Construye la función para un conjunto de hashes distintos.
+     * @param hashes Hashes de 64 bits de las claves (UserKey<Key>::hash), no deben repetirse.
+     * @param gamma Bits por clave en cada nivel, más grande construye más rápido pero usa más memoria.
+     */
+    void build(vector<uint64_t> hashes, double gamma = 1.0)
+    {
+        n_keys = hashes.size();
+        bits.clear();
+        level_offset.clear();
+        level_size.clear();
+        fallback.clear();
+
+        for (int level = 0; level < MAX_LEVELS && !hashes.empty(); level++)
+        {
+            size_t size = ((size_t)(gamma * hashes.size()) / 64 + 1) * 64;
+            vector<uint64_t> seen(size / 64, 0), collision(size / 64, 0);
+            for (uint64_t hash : hashes)
+            {
+                size_t pos = position(hash, level, size);
+                uint64_t mask = 1ULL << (pos % 64);
+                if (seen[pos / 64] & mask)
+                    collision[pos / 64] |= mask;
+                seen[pos / 64] |= mask;
+            }
+
+            // se quedan las que cayeron solas, el resto pasa al siguiente nivel
+            vector<uint64_t> next;
+            for (uint64_t hash : hashes)
+            {
+                size_t pos = position(hash, level, size);
+                if (collision[pos / 64] & (1ULL << (pos % 64)))
+                    next.push_back(hash);
+            }
+            level_offset.push_back(bits.size() * 64);
+            level_size.push_back(size);
+            for (size_t w = 0; w < seen.size(); w++)
+            {
+                bits.push_back(seen[w] & ~collision[w]);
+            }
+            hashes.swap(next);
+        }
+
+        // rank por bloques de 8 palabras (512 bits)
+        ranks.assign(bits.size() / 8 + 1, 0);
+        uint32_t total = 0;
+        for (size_t w = 0; w < bits.size(); w++)
+        {
+            if (w % 8 == 0)
+                ranks[w / 8] = total;
+            total += __builtin_popcountll(bits[w]);
+        }
+        for (uint64_t hash : hashes)
+        {
+            fallback[hash] = total++;
+        }
+    }
+
+    /**
+     * @brief Número de la clave en [0, n_keys).
+     * @param hash Hash de 64 bits de la clave.
+     */
+    uint32_t lookup(uint64_t hash) const
+    {
+        for (size_t level = 0; level < level_size.size(); level++)
+        {
+            size_t pos = level_offset[level] + position(hash, level, level_size[level]);
+            if (bits[pos / 64] & (1ULL << (pos % 64)))
+                return rank(pos);
+        }
+        auto it = fallback.find(hash);
+        return it == fallback.end() ? NOT_FOUND : it->second;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por la función en bytes.
+     */
+    size_t get_memory_usage() const
+    {
+        size_t count = 0;
+        count += bits.size() * sizeof(uint64_t);
+        count += ranks.size() * sizeof(uint32_t);
+        count += (level_offset.size() + level_size.size()) * sizeof(size_t);
+        // cada entrada del fallback es un nodo (siguiente, clave, valor, hash) más su bucket
+        count += fallback.size() * (sizeof(void *) * 2 + sizeof(pair<uint64_t, uint32_t>) + sizeof(size_t));
+        return count;
+    }
+
+private:
+    /// Posición de la clave dentro de un nivel, cada nivel usa una mezcla distinta del hash.
+    static size_t position(uint64_t hash, size_t level, size_t size)
+    {
+        uint64_t mixed = mix64(hash + (level + 1) * 0x9e3779b97f4a7c15ULL);
+        return (size_t)(((unsigned __int128)mixed * size) >> 64);
+    }
+
+    /// Bits en 1 antes de pos.
+    uint32_t rank(size_t pos) const
+    {
+        size_t word = pos / 64;
+        uint32_t count = ranks[word / 8];
+        for (size_t w = word & ~(size_t)7; w < word; w++)
+        {
+            count += __builtin_popcountll(bits[w]);
+        }
+        return count + __builtin_popcountll(bits[word] & ((1ULL << (pos % 64)) - 1));
+    }
+};
+
+/**
+ * @brief Tabla de solo lectura construida una vez sobre un conjunto de usuarios, usando una MinimalPerfectHash.
+ *
+ * Los usuarios se guardan ordenados por el número que les asigna la función, por lo que una busqueda es
+ * calcular ese número (un acceso a los bits del primer nivel en la mayoría de los casos), leer el usuario
+ * y verificar la clave. El único espacio extra por sobre los usuarios es el de la función (~3 bits por clave).
+ *
+ * @tparam Key unsigned long long para usar userId de clave, string para usar userName.
+ */
+template <typename Key>
+class PerfectHashTable
+{
+public:
+    int size = 0;            ///< Cantidad de usuarios en la tabla.
+    MinimalPerfectHash mph;  ///< Función de hash perfecta mínima sobre las claves.
+    vector<User> records;    ///< Usuarios, records[i] es el usuario cuya clave tiene número i.
+
+    /**
+     * @brief Construye la tabla. Si dos usuarios tienen la misma clave (o el mismo hash de 64 bits) se queda el primero.
+     * @param users Usuarios a guardar, se copian.
+     * @param gamma Bits por clave en cada nivel de la función.
+     */
+    PerfectHashTable(const vector<User> &users, double gamma = 1.0)
+    {
+        unordered_map<uint64_t, size_t> first;
+        first.reserve(users.size());
+        vector<uint64_t> hashes;
+        vector<size_t> chosen;
+        for (size_t i = 0; i < users.size(); i++)
+        {
+            uint64_t hash = UserKey<Key>::hash(UserKey<Key>::get(users[i]));
+            if (first.emplace(hash, i).second)
+            {
+                hashes.push_back(hash);
+                chosen.push_back(i);
+            }
+        }
+
+        mph.build(hashes, gamma);
+        size = chosen.size();
+        records.resize(size);
+        for (size_t j = 0; j < chosen.size(); j++)
+        {
+            records[mph.lookup(hashes[j])] = users[chosen[j]];
+        }
+    }
+
+    /**
+     * @brief Busca un usuario por su clave.
+     * @return Puntero al usuario, nullptr si no se encontró.
+     */
+    User *search(const Key &key)
+    {
+        TRACE_OPERATION("PerfectHashTable::search");
+        uint32_t index = mph.lookup(TRACED("hash", UserKey<Key>::hash(key)));
+        if (index >= records.size() || TRACED("compare", UserKey<Key>::get(records[index]) != key))
+            return nullptr;
+        return &records[index];
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por la estructura de datos en bytes.
+     */
+    size_t get_memory_usage()
+    {
+        size_t count = 0;
+        // considerando el tamaño promedio de un usuario en memoria de 70 bytes
+        int user_size = 70;
+
+        count += records.size() * user_size;
+        count += mph.get_memory_usage();
+        count += sizeof(size);
+
+        return count;
+    }
+};
+
+typedef PerfectHashTable<unsigned long long> PerfectHashTableUserId;
+typedef PerfectHashTable<string> PerfectHashTableUserName;
+
+#endif
@@ -0,0 +1,30 @@
+import sys
+import pandas as pd
+import matplotlib.pyplot as plt
+
+# Grafica el resultado de "./a.out scaling", una linea por tabla y un gráfico por factor de carga.
+# Las lineas verticales marcan cuando la memoria de la tabla supera el tamaño de cada cache.
+filename = sys.argv[1] if len(sys.argv) > 1 else 'tests/test_escalamiento'
+
+df = pd.read_csv(filename + '.csv')
+# el csv se abre en modo append, por lo que pueden haber encabezados repetidos
+df = df[df['Tabla'] != 'Tabla']
+df = df.apply(pd.to_numeric, errors='ignore')
+caches = pd.read_csv(filename + '_caches.csv')
+
+for load_factor, group in df.groupby('Factor de carga'):
+    fig, axes = plt.subplots(1, 2, figsize=(14, 5))
+    for column, ax in zip(['Busqueda existente(ns)', 'Busqueda inexistente(ns)'], axes):
+        for table, rows in group.groupby('Tabla'):
+            rows = rows.groupby('Memoria(bytes)', as_index=False)[column].mean()
+            ax.plot(rows['Memoria(bytes)'], rows[column], marker='o', label=table)
+        for _, cache in caches.iterrows():
+            ax.axvline(cache['Tamaño(bytes)'], color='gray', linestyle='--')
+            ax.text(cache['Tamaño(bytes)'], ax.get_ylim()[1] * 0.95, cache['Nivel'], color='gray')
+        ax.set_xscale('log')
+        ax.set_xlabel('Memoria de la tabla (bytes)')
+        ax.set_ylabel(column)
+        ax.set_title(f'Factor de carga {load_factor}')
+    axes[0].legend()
+    plt.tight_layout()
+    plt.savefig(f'images/escalamiento_{load_factor}.jpg')
@@ -0,0 +1,252 @@
+#ifndef PREFIX_INDEX
+#define PREFIX_INDEX
+
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <numeric>
+#include <cstdint>
+
+#include "functions.h"
+
+using namespace std;
+
+/**
+ * @brief Indice de prefijos sobre userName (árbol radix compacto), para consultas de autocompletado
+ * ("todos los usuarios que empiezan con santi") y busquedas exactas.
+ *
+ * Los nombres se ordenan una vez y el árbol se construye en bloque sobre el arreglo ordenado: cada nodo guarda
+ * un tramo del nombre (label, los tramos sin bifurcaciones se juntan en un solo nodo), sus hijos están contiguos
+ * en el arreglo de nodos y cada nodo sabe qué rango de sorted_rows tiene debajo. Así una consulta por prefijo
+ * baja por el árbol (a lo más un nodo por caracter) y luego solo recorre ese rango: O(largo del prefijo + k)
+ * con k los usuarios devueltos, sin recorrer el resto.
+ *
+ * Para elegir el hijo se revisan las primeras letras de los hijos (child_chars, contiguas en memoria): con pocos
+ * hijos de forma lineal y con muchos con busqueda binaria.
+ *
+ * El indice se construye una sola vez en el constructor, no soporta insert ni remove.
+ */
+class PrefixIndex
+{
+public:
+    static constexpr int LINEAR_CHILDREN = 16; ///< Con más hijos que esto se usa busqueda binaria.
+
+    /**
+     * @brief Nodo del árbol (20 bytes).
+     */
+    struct Node
+    {
+        uint32_t label;        ///< Inicio del tramo del nodo en labels.
+        uint32_t first_child;  ///< Primer hijo en nodes (los hijos son contiguos).
+        uint32_t begin;        ///< Primera posición en sorted_rows de los usuarios bajo el nodo.
+        uint32_t end;          ///< Posición siguiente a la última en sorted_rows.
+        uint8_t label_length;  ///< Largo del tramo, los tramos más largos se dividen en varios nodos.
+        uint8_t terminal;      ///< Si algún nombre termina en este nodo (es sorted_rows[begin]).
+        uint16_t n_children;   ///< Cantidad de hijos.
+    };
+
+    int size = 0;                ///< Cantidad de usuarios en el indice.
+    const vector<User> *users;   ///< Usuarios indexados, el indice guarda sus posiciones.
+    vector<uint32_t> sorted_rows; ///< Posiciones de los usuarios ordenadas por userName.
+    vector<Node> nodes;          ///< Nodos del árbol, nodes[0] es la raíz.
+    vector<unsigned char> child_chars; ///< Primera letra del tramo de cada nodo (la raíz no tiene).
+    string labels;               ///< Tramos de todos los nodos, uno después del otro.
+
+    /**
+     * @brief Construye el indice sobre un vector de usuarios. El vector no debe modificarse mientras se use el indice.
+     * @param users Usuarios a indexar.
+     */
+    PrefixIndex(const vector<User> &users) : users(&users)
+    {
+        size = users.size();
+        sorted_rows.resize(size);
+        iota(sorted_rows.begin(), sorted_rows.end(), 0);
+        sort(sorted_rows.begin(), sorted_rows.end(), [&](uint32_t a, uint32_t b)
+             { return users[a].userName < users[b].userName; });
+
+        nodes.push_back(Node());
+        child_chars.push_back(0);
+        build(0, 0, size, 0);
+    }
+
+    /**
+     * @brief Busca un usuario por su userName exacto (si hay repetidos devuelve uno de ellos).
+     * @return Puntero al usuario, nullptr si no se encontró.
+     */
+    const User *search(const string &userName)
+    {
+        size_t label_end;
+        int node = descend(userName, label_end);
+        // si userName termina a mitad del tramo del nodo, ningún nombre termina ahí
+        if (node < 0 || label_end != userName.size() || !nodes[node].terminal)
+            return nullptr;
+        return &(*users)[sorted_rows[nodes[node].begin]];
+    }
+
+    /**
+     * @brief Usuarios cuyo userName empieza con prefix, ordenados por userName.
+     * @param limit: cantidad máxima de usuarios a devolver, -1 para devolverlos todos.
+     */
+    vector<const User *> prefix(const string &prefix, int limit = -1)
+    {
+        vector<const User *> result;
+        uint32_t first, last;
+        if (!prefix_range(prefix, first, last))
+            return result;
+        if (limit >= 0 && last - first > (uint32_t)limit)
+            last = first + limit;
+        result.reserve(last - first);
+        for (uint32_t i = first; i < last; i++)
+        {
+            result.push_back(&(*users)[sorted_rows[i]]);
+        }
+        return result;
+    }
+
+    /**
+     * @brief Cantidad de usuarios cuyo userName empieza con prefix.
+     */
+    int count_prefix(const string &prefix)
+    {
+        uint32_t first, last;
+        return prefix_range(prefix, first, last) ? last - first : 0;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por el indice en bytes (sin contar los usuarios).
+     */
+    size_t get_memory_usage()
+    {
+        size_t count = 0;
+        count += sorted_rows.size() * sizeof(uint32_t);
+        count += nodes.size() * sizeof(Node);
+        count += child_chars.size();
+        count += labels.size();
+        count += sizeof(size);
+        return count;
+    }
+
+private:
+    /// Nombre del usuario en la posición i de sorted_rows.
+    const string &name(uint32_t i) const
+    {
+        return (*users)[sorted_rows[i]].userName;
+    }
+
+    /**
+     * @brief Llena el nodo con los nombres de sorted_rows[lo, hi), de los que ya se usaron depth caracteres.
+     * Como están ordenados, el prefijo común de todos es el prefijo común del primero y el último.
+     */
+    void build(uint32_t node, uint32_t lo, uint32_t hi, size_t depth)
+    {
+        size_t common = depth;
+        if (hi > lo)
+        {
+            const string &first = name(lo), &last = name(hi - 1);
+            while (common < first.size() && common < last.size() && first[common] == last[common])
+                common++;
+        }
+        // la raíz no tiene tramo y los tramos largos se cortan en nodos de a lo más 255 caracteres
+        if (node == 0)
+            common = 0;
+        common = min(common, depth + 255);
+
+        nodes[node].label = labels.size();
+        nodes[node].label_length = common - depth;
+        nodes[node].begin = lo;
+        nodes[node].end = hi;
+        if (hi > lo)
+            labels.append(name(lo), depth, common - depth);
+
+        // los nombres que terminan en el nodo quedan primero
+        uint32_t i = lo;
+        while (i < hi && name(i).size() == common)
+            i++;
+        nodes[node].terminal = i > lo;
+
+        // grupos de nombres con la misma letra siguiente, cada uno es un hijo
+        vector<pair<uint32_t, uint32_t>> groups;
+        while (i < hi)
+        {
+            unsigned char c = name(i)[common];
+            uint32_t j = i + 1;
+            while (j < hi && (unsigned char)name(j)[common] == c)
+                j++;
+            groups.push_back({i, j});
+            i = j;
+        }
+
+        uint32_t first_child = nodes.size();
+        nodes[node].first_child = first_child;
+        nodes[node].n_children = groups.size();
+        nodes.resize(nodes.size() + groups.size());
+        for (auto &group : groups)
+            child_chars.push_back(name(group.first)[common]);
+        for (size_t g = 0; g < groups.size(); g++)
+            build(first_child + g, groups[g].first, groups[g].second, common);
+    }
+
+    /**
+     * @brief Hijo de node cuyo tramo empieza con c, -1 si no hay.
+     */
+    int child(const Node &node, unsigned char c) const
+    {
+        const unsigned char *chars = child_chars.data() + node.first_child;
+        if (node.n_children <= LINEAR_CHILDREN)
+        {
+            for (int i = 0; i < node.n_children; i++)
+            {
+                if (chars[i] == c)
+                    return node.first_child + i;
+            }
+            return -1;
+        }
+        const unsigned char *it = lower_bound(chars, chars + node.n_children, c);
+        return it != chars + node.n_children && *it == c ? node.first_child + (it - chars) : -1;
+    }
+
+    /**
+     * @brief Baja por el árbol siguiendo key mientras coincida.
+     * @param label_end Largo del camino desde la raíz hasta el final del tramo del nodo devuelto.
+     * @return Nodo cuyo tramo contiene el final de key, -1 si key se separa del árbol antes de terminar.
+     */
+    int descend(const string &key, size_t &label_end)
+    {
+        int node = 0;
+        size_t depth = 0;
+        while (true)
+        {
+            const Node &current = nodes[node];
+            const char *label = labels.data() + current.label;
+            for (size_t i = 0; i < current.label_length && depth + i < key.size(); i++)
+            {
+                if (label[i] != key[depth + i])
+                    return -1;
+            }
+            label_end = depth + current.label_length;
+            if (label_end >= key.size())
+                return node;
+            depth = label_end;
+            node = child(current, key[depth]);
+            if (node < 0)
+                return -1;
+        }
+    }
+
+    /**
+     * @brief Rango [first, last) de sorted_rows con los nombres que empiezan con prefix.
+     * @return false si ningún nombre empieza con prefix.
+     */
+    bool prefix_range(const string &prefix, uint32_t &first, uint32_t &last)
+    {
+        size_t label_end;
+        int node = descend(prefix, label_end);
+        if (node < 0 || nodes[node].begin == nodes[node].end)
+            return false;
+        first = nodes[node].begin;
+        last = nodes[node].end;
+        return true;
+    }
+};
+
+#endif
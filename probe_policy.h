@@ -0,0 +1,235 @@
+#ifndef PROBE_POLICY
+#define PROBE_POLICY
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include "functions.h"
+#include "hash_functions.h"
+#include "hash_tables.h"
+
+using namespace std;
+
+/*
+Políticas de capacidad y secuencia de prueba para ProbingHashTable. Todas tienen la misma forma:
+    capacity          tamaño real de la tabla (puede ser mayor al pedido).
+    home(hash)        primer intento para un hash de 64 bits.
+    next(pos, i)      posición del intento i (i >= 1) a partir de la del intento i - 1.
+Las funciones de hash_functions.h calculan cada intento desde cero y terminan en un % n con n primo conocido
+solo en ejecución, lo que es una división de 20 a 40 ciclos por intento.
+*/
+
+/**
+ * @brief Lo mismo que hacen las funciones de hash_functions.h: prueba lineal con % n en cada intento.
+ */
+struct ModuloPolicy
+{
+    size_t capacity;
+
+    ModuloPolicy(size_t requested) : capacity(next_prime(requested)) {}
+
+    size_t home(unsigned long long hash) const { return hash % capacity; }
+    size_t next(size_t pos, int) const { return (pos + 1) % capacity; }
+};
+
+/**
+ * @brief Capacidad potencia de 2: el módulo es un AND con una máscara. La prueba es triangular (los saltos son
+ * 1, 2, 3, ..., el intento i queda a i(i+1)/2 del primero), que en una tabla potencia de 2 pasa por todos los
+ * espacios antes de repetir uno, a diferencia de quadratic_probing sobre un primo que visita cerca de la mitad.
+ */
+struct PowerOfTwoPolicy
+{
+    size_t capacity;
+    size_t mask;
+
+    PowerOfTwoPolicy(size_t requested) : capacity(1)
+    {
+        while (capacity < requested)
+            capacity *= 2;
+        mask = capacity - 1;
+    }
+
+    size_t home(unsigned long long hash) const { return hash & mask; }
+    size_t next(size_t pos, int i) const { return (pos + i) & mask; }
+};
+
+/**
+ * @brief Capacidad prima con el módulo de Lemire (fastmod): con M = 2^64 / n + 1 calculado una vez,
+ * a % n = ((M * a mod 2^64) * n) / 2^64 para todo a de 32 bits, dos multiplicaciones en vez de una división.
+ * Después del primer intento la prueba es lineal y se vuelve a 0 con una comparación, sin módulo.
+ */
+struct FastModPolicy
+{
+    size_t capacity;
+    unsigned long long magic; ///< M = 2^64 / capacity + 1.
+
+    FastModPolicy(size_t requested) : capacity(next_prime(requested)), magic(~0ULL / capacity + 1) {}
+
+    size_t home(unsigned long long hash) const
+    {
+        // se juntan las dos mitades del hash, fastmod es exacto para números de 32 bits
+        uint32_t folded = (uint32_t)(hash ^ (hash >> 32));
+        unsigned long long low = magic * folded;
+        return (size_t)(((unsigned __int128)low * capacity) >> 64);
+    }
+    size_t next(size_t pos, int) const { return pos + 1 == capacity ? 0 : pos + 1; }
+};
+
+/**
+ * @brief Capacidad prima con fastrange de Lemire: el primer intento es (hash * n) / 2^64, una multiplicación que
+ * usa los bits altos del hash (no es igual al módulo, pero reparte igual de bien si el hash está bien mezclado).
+ */
+struct FastRangePolicy
+{
+    size_t capacity;
+
+    FastRangePolicy(size_t requested) : capacity(next_prime(requested)) {}
+
+    size_t home(unsigned long long hash) const { return (size_t)(((unsigned __int128)hash * capacity) >> 64); }
+    size_t next(size_t pos, int) const { return pos + 1 == capacity ? 0 : pos + 1; }
+};
+
+/**
+ * @brief Capacidad fija en tiempo de compilación: el compilador cambia % N por multiplicaciones y shifts.
+ * @tparam N Capacidad de la tabla, por ejemplo next_prime(26544) (next_prime es constexpr).
+ */
+template <unsigned long long N>
+struct StaticPrimePolicy
+{
+    static constexpr size_t capacity = N;
+
+    StaticPrimePolicy(size_t) {}
+
+    size_t home(unsigned long long hash) const { return hash % N; }
+    size_t next(size_t pos, int) const { return pos + 1 == N ? 0 : pos + 1; }
+};
+
+/**
+ * @brief Tabla hash cerrada cuya capacidad y secuencia de prueba las da una política (ver arriba).
+ *
+ * Cada espacio guarda la posición (32 bits) del usuario en rows, igual que NodePoolHashTable y BucketHashTable,
+ * y la secuencia se calcula de forma incremental con policy.next() en vez de llamar a una función de hash
+ * por puntero en cada intento como CloseHashTableUserId/CloseHashTableUserName.
+ *
+ * @tparam Key unsigned long long para usar userId de clave, string para usar userName.
+ * @tparam Policy ModuloPolicy, PowerOfTwoPolicy, FastModPolicy, FastRangePolicy o StaticPrimePolicy<N>.
+ *
+ * @note La tabla no copia los usuarios: guarda su posición en el vector rows, que debe vivir más que la tabla.
+ */
+template <typename Key, typename Policy>
+class ProbingHashTable
+{
+public:
+    static constexpr uint32_t EMPTY = 0xffffffff;   ///< Espacio que nunca se ha usado.
+    static constexpr uint32_t DELETED = 0xfffffffe; ///< Espacio de un usuario eliminado.
+
+    Policy policy;           ///< Capacidad y secuencia de prueba.
+    int size = 0;            ///< Cantidad de usuarios en la tabla.
+    int totalCollisions = 0; ///< Espacios ocupados que se saltaron al insertar.
+    vector<User> *rows;      ///< Usuarios a los que apuntan los espacios.
+    HugePageVector<uint32_t> slots; ///< Posición del usuario en rows, EMPTY o DELETED.
+
+    /**
+     * @brief Constructor de la tabla.
+     * @param capacity Capacidad pedida, la política puede redondearla (a un primo o a una potencia de 2).
+     * @param rows Vector con los usuarios, insert recibe posiciones de este vector.
+     */
+    ProbingHashTable(size_t capacity, vector<User> &rows)
+        : policy(capacity), rows(&rows), slots(policy.capacity, EMPTY) {}
+
+    /**
+     * @brief Inserta un usuario en el primer espacio vacío o eliminado de su secuencia de prueba.
+     * @param key Clave del usuario.
+     * @param row Posición del usuario en rows.
+     */
+    void insert(const Key &key, uint32_t row)
+    {
+        TRACE_OPERATION("ProbingHashTable::insert");
+        size_t pos = policy.home(TRACED("hash", UserKey<Key>::hash(key)));
+        for (int i = 1; i <= MAX_ATTEMPTS; i++)
+        {
+            if (slots[pos] >= DELETED)
+            {
+                slots[pos] = row;
+                size++;
+                return;
+            }
+            totalCollisions++;
+            pos = policy.next(pos, i);
+        }
+        cout << "Tabla hash está llena o se alcanzó el máximo de intentos." << endl;
+    }
+
+    /**
+     *@brief Devuelve el numero total de colisiones que hubo en la tabla.
+     */
+    int getCollision()
+    {
+        return totalCollisions;
+    }
+
+    /**
+     * @brief Busca un usuario en la tabla hash por su clave.
+     * @return Puntero al usuario dentro de rows, nullptr si no se encontró.
+     */
+    User *search(const Key &key)
+    {
+        TRACE_OPERATION("ProbingHashTable::search");
+        size_t slot = find(key);
+        return slot == policy.capacity ? nullptr : &(*rows)[slots[slot]];
+    }
+
+    /**
+     * @brief Elimina un usuario de la tabla por su clave, si no existe no hace nada.
+     */
+    void remove(const Key &key)
+    {
+        TRACE_OPERATION("ProbingHashTable::remove");
+        size_t slot = find(key);
+        if (slot != policy.capacity)
+        {
+            slots[slot] = DELETED;
+            size--;
+        }
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por la estructura de datos en bytes.
+     */
+    size_t get_memory_usage()
+    {
+        size_t count = 0;
+        // considerando el tamaño promedio de un usuario en memoria de 70 bytes
+        int user_size = 70;
+
+        count += slots.size() * sizeof(uint32_t);
+        count += size * user_size;
+        // espacio usado por el resto de variables
+        count += sizeof(policy);
+        count += sizeof(size);
+
+        return count;
+    }
+
+private:
+    /**
+     * @brief Espacio donde está key, policy.capacity si no está.
+     */
+    size_t find(const Key &key)
+    {
+        size_t pos = policy.home(TRACED("hash", UserKey<Key>::hash(key)));
+        for (int i = 1; i <= MAX_ATTEMPTS; i++)
+        {
+            uint32_t row = slots[pos];
+            if (row == EMPTY)
+                break;
+            if (row != DELETED && TRACED("compare", UserKey<Key>::get((*rows)[row]) == key))
+                return pos;
+            pos = policy.next(pos, i);
+        }
+        return policy.capacity;
+    }
+};
+
+#endif
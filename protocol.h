@@ -0,0 +1,341 @@
+#ifndef PROTOCOL
+#define PROTOCOL
+
+#include <string>
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "functions.h"
+
+using namespace std;
+
+/*
+Protocolo binario del servidor de busquedas (server.cpp) y su cliente (client.cpp).
+
+Cada mensaje (pedido o respuesta) es un marco: largo del cuerpo (4 bytes) y el cuerpo. Los enteros van en el
+orden de bytes de la máquina, ya que cliente y servidor corren en el mismo equipo.
+
+    pedido:    largo | operación (1) | argumentos
+    respuesta: largo | estado (1)    | resultado
+
+Operaciones y argumentos (una clave es tipo (1 byte, KEY_ID o KEY_NAME) y luego userId (8) o el nombre):
+    OP_GET   clave                   -> usuario
+    OP_MGET  cantidad (4) | claves   -> cantidad (4) | por cada clave: encontrado (1) [| usuario]
+    OP_PUT   usuario                 -> nada (reemplaza al usuario con el mismo userId si existe)
+    OP_DEL   clave                   -> nada
+
+El cliente puede mandar varios pedidos sin esperar las respuestas (pipelining): el servidor responde cada
+conexión en el mismo orden en que llegaron los pedidos, por eso los marcos no llevan un número de pedido.
+*/
+
+/**
+ * @brief Operaciones del protocolo.
+ */
+enum Op : uint8_t
+{
+    OP_GET = 1,
+    OP_MGET = 2,
+    OP_PUT = 3,
+    OP_DEL = 4,
+};
+
+/**
+ * @brief Estado de una respuesta.
+ */
+enum Status : uint8_t
+{
+    STATUS_OK = 0,        ///< La operación se hizo.
+    STATUS_NOT_FOUND = 1, ///< La clave no existe (GET y DEL).
+    STATUS_FULL = 2,      ///< No cabe el usuario en la tabla (PUT).
+    STATUS_BAD_REQUEST = 3, ///< El pedido no se pudo leer.
+};
+
+/**
+ * @brief Tipo de clave de GET, MGET y DEL.
+ */
+enum KeyType : uint8_t
+{
+    KEY_ID = 0,
+    KEY_NAME = 1,
+};
+
+constexpr uint32_t MAX_FRAME = 16 << 20; ///< Largo máximo de un cuerpo, uno más largo cierra la conexión.
+
+/**
+ * @brief Clave de una busqueda o eliminación.
+ */
+struct RequestKey
+{
+    KeyType type;
+    unsigned long long userId;
+    string userName;
+};
+
+//--- Escritura ---
+
+void put_bytes(string &out, const void *data, size_t length)
+{
+    out.append((const char *)data, length);
+}
+
+template <typename T>
+void put_value(string &out, T value)
+{
+    put_bytes(out, &value, sizeof(value));
+}
+
+void put_string(string &out, const string &value)
+{
+    put_value<uint32_t>(out, value.size());
+    out += value;
+}
+
+void put_key(string &out, const RequestKey &key)
+{
+    put_value<uint8_t>(out, key.type);
+    if (key.type == KEY_ID)
+        put_value(out, key.userId);
+    else
+        put_string(out, key.userName);
+}
+
+void put_user(string &out, const User &user)
+{
+    put_string(out, user.university);
+    put_value(out, user.userId);
+    put_string(out, user.userName);
+    put_value(out, user.numberTweets);
+    put_value(out, user.friendsCount);
+    put_value(out, user.followersCount);
+    put_string(out, user.createdAt);
+}
+
+/**
+ * @brief Empieza un marco en out, devuelve su posición para cerrarlo con end_frame().
+ */
+size_t begin_frame(string &out)
+{
+    size_t start = out.size();
+    put_value<uint32_t>(out, 0);
+    return start;
+}
+
+/**
+ * @brief Escribe el largo del marco que empezó en start.
+ */
+void end_frame(string &out, size_t start)
+{
+    uint32_t length = out.size() - start - sizeof(uint32_t);
+    memcpy(&out[start], &length, sizeof(length));
+}
+
+//--- Lectura ---
+
+/**
+ * @brief Lector de un cuerpo ya recibido completo. Cada get devuelve false (y deja ok en false) si faltan bytes,
+ * así un pedido mal formado nunca lee fuera del marco.
+ */
+struct Reader
+{
+    const char *data;
+    size_t length;
+    size_t at = 0;
+    bool ok = true;
+
+    Reader(const char *data, size_t length) : data(data), length(length) {}
+
+    bool get_bytes(void *out, size_t size)
+    {
+        if (!ok || at + size > length)
+            return ok = false;
+        memcpy(out, data + at, size);
+        at += size;
+        return true;
+    }
+
+    template <typename T>
+    bool get_value(T &value)
+    {
+        return get_bytes(&value, sizeof(value));
+    }
+
+    bool get_string(string &value)
+    {
+        uint32_t size;
+        if (!get_value(size) || at + size > length)
+            return ok = false;
+        value.assign(data + at, size);
+        at += size;
+        return true;
+    }
+
+    bool get_key(RequestKey &key)
+    {
+        uint8_t type;
+        if (!get_value(type))
+            return false;
+        key.type = (KeyType)type;
+        if (type == KEY_ID)
+            return get_value(key.userId);
+        if (type == KEY_NAME)
+            return get_string(key.userName);
+        return ok = false;
+    }
+
+    bool get_user(User &user)
+    {
+        string created;
+        bool read = get_string(user.university) && get_value(user.userId) && get_string(user.userName) &&
+                    get_value(user.numberTweets) && get_value(user.friendsCount) &&
+                    get_value(user.followersCount) && get_string(created);
+        if (read)
+        {
+            user.createdAtEpoch = parseCreatedAt(created);
+            user.createdAt = move(created);
+        }
+        return read;
+    }
+};
+
+/**
+ * @brief Si buffer[pos] empieza un marco completo, deja en body y length su cuerpo y avanza pos.
+ * @return 1 si había un marco completo, 0 si faltan bytes, -1 si el largo pasa de MAX_FRAME.
+ */
+int next_frame(const string &buffer, size_t &pos, const char *&body, uint32_t &length)
+{
+    if (pos + sizeof(uint32_t) > buffer.size())
+        return 0;
+    memcpy(&length, buffer.data() + pos, sizeof(length));
+    if (length > MAX_FRAME)
+        return -1;
+    if (pos + sizeof(uint32_t) + length > buffer.size())
+        return 0;
+    body = buffer.data() + pos + sizeof(uint32_t);
+    pos += sizeof(uint32_t) + length;
+    return 1;
+}
+
+//--- Sockets ---
+
+/**
+ * @brief Dirección de un socket: "unix:/ruta" o "tcp:puerto" (siempre en 127.0.0.1, solo conexiones locales).
+ * Rellena addr y devuelve su largo, 0 si la dirección no se entiende.
+ */
+socklen_t parse_address(const string &address, sockaddr_storage &addr)
+{
+    memset(&addr, 0, sizeof(addr));
+    if (address.rfind("unix:", 0) == 0)
+    {
+        string path = address.substr(5);
+        sockaddr_un *un = (sockaddr_un *)&addr;
+        if (path.empty() || path.size() >= sizeof(un->sun_path))
+            return 0;
+        un->sun_family = AF_UNIX;
+        memcpy(un->sun_path, path.c_str(), path.size() + 1);
+        return sizeof(sockaddr_un);
+    }
+    if (address.rfind("tcp:", 0) == 0)
+    {
+        sockaddr_in *in = (sockaddr_in *)&addr;
+        in->sin_family = AF_INET;
+        in->sin_port = htons(stoi(address.substr(4)));
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        return sizeof(sockaddr_in);
+    }
+    return 0;
+}
+
+/**
+ * @brief Deja un socket en modo no bloqueante.
+ */
+void set_nonblocking(int fd)
+{
+    fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+/**
+ * @brief Abre un socket escuchando en address (si es unix, borra el archivo anterior).
+ * @return Descriptor del socket, -1 si hubo un error.
+ */
+int listen_on(const string &address)
+{
+    sockaddr_storage addr;
+    socklen_t length = parse_address(address, addr);
+    if (length == 0)
+    {
+        cout << "Dirección no valida: " << address << " (usar unix:/ruta o tcp:puerto)" << endl;
+        return -1;
+    }
+    if (addr.ss_family == AF_UNIX)
+        unlink(((sockaddr_un *)&addr)->sun_path);
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    int one = 1;
+    if (fd >= 0)
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    if (fd < 0 || bind(fd, (sockaddr *)&addr, length) < 0 || listen(fd, 1024) < 0)
+    {
+        cout << "No se pudo escuchar en " << address << ": " << strerror(errno) << endl;
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/**
+ * @brief Se conecta (en modo bloqueante) al servidor en address.
+ * @return Descriptor del socket, -1 si hubo un error.
+ */
+int connect_to(const string &address)
+{
+    sockaddr_storage addr;
+    socklen_t length = parse_address(address, addr);
+    if (length == 0)
+        return -1;
+    int fd = socket(addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0 || connect(fd, (sockaddr *)&addr, length) < 0)
+    {
+        cout << "No se pudo conectar a " << address << ": " << strerror(errno) << endl;
+        if (fd >= 0)
+            close(fd);
+        return -1;
+    }
+    if (addr.ss_family == AF_INET)
+    {
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    }
+    return fd;
+}
+
+/**
+ * @brief Escribe todo data en un socket bloqueante.
+ * @return false si la conexión se cerró o hubo un error.
+ */
+bool write_all(int fd, const char *data, size_t length)
+{
+    while (length > 0)
+    {
+        ssize_t written = send(fd, data, length, MSG_NOSIGNAL);
+        if (written <= 0)
+        {
+            if (written < 0 && errno == EINTR)
+                continue;
+            return false;
+        }
+        data += written;
+        length -= written;
+    }
+    return true;
+}
+
+#endif
@@ -0,0 +1,312 @@
+#include <vector>
+#include <string>
+#include <thread>
+#include <atomic>
+#include <shared_mutex>
+#include <mutex>
+#include <unordered_map>
+#include <csignal>
+#include <sys/epoll.h>
+
+#include "functions.h"
+#include "hash_functions.h"
+#include "user_index.h"
+#include "protocol.h"
+
+using namespace std;
+
+/*
+Servidor de busquedas: carga los usuarios del CSV en un UserIndex (indices por userId y por userName) y responde
+GET, MGET, PUT y DEL con el protocolo de protocol.h, en un socket unix o tcp local.
+
+El hilo principal acepta las conexiones y las reparte entre los hilos de trabajo (una a cada uno, en orden).
+Cada hilo tiene su propio epoll y es el único que toca sus conexiones, así el estado de una conexión no
+necesita locks. El UserIndex se comparte con un shared_mutex: las busquedas toman el lock compartido y
+PUT/DEL el exclusivo.
+
+Compilación: g++ server.cpp -O2 -pthread -o server
+Uso: ./server [direccion] [hilos] [csv]
+    direccion: unix:/ruta o tcp:puerto (por defecto unix:/tmp/entregable2.sock).
+    hilos: hilos de trabajo, 0 para usar todos los núcleos (por defecto 0).
+    csv: usuarios a cargar (por defecto universities_followers_without_duplicates.csv).
+*/
+
+const size_t MAX_PENDING_OUTPUT = 4 << 20; ///< Con más respuestas sin enviar se deja de leer la conexión.
+const int READ_CHUNK = 64 << 10;           ///< Bytes que se leen del socket por llamada.
+
+atomic<bool> running(true);
+UserIndex *users_index;    ///< Tabla que atiende el servidor.
+shared_mutex index_mutex;  ///< Compartido para busquedas, exclusivo para PUT y DEL.
+
+/**
+ * @brief Estado de una conexión: lo recibido que todavía no forma un pedido completo y las respuestas sin enviar.
+ */
+struct Connection
+{
+    string input;
+    string output;
+    size_t sent = 0;        ///< Bytes de output ya enviados.
+    bool writing = false;   ///< Si epoll espera EPOLLOUT (hay respuestas pendientes) en vez de EPOLLIN.
+};
+
+/**
+ * @brief Busca una clave en el indice, se debe tener el lock (compartido o exclusivo).
+ */
+User *find_key(const RequestKey &key)
+{
+    return key.type == KEY_ID ? users_index->search_by_id(key.userId) : users_index->search_by_name(key.userName);
+}
+
+/**
+ * @brief Responde un pedido (el cuerpo de un marco) agregando la respuesta al final de out.
+ */
+void handle_request(const char *body, uint32_t length, string &out)
+{
+    Reader reader(body, length);
+    size_t frame = begin_frame(out);
+    size_t status_at = out.size();
+    put_value<uint8_t>(out, STATUS_BAD_REQUEST);
+    uint8_t op = 0;
+    RequestKey key;
+    Status status = STATUS_BAD_REQUEST;
+    reader.get_value(op);
+
+    if (op == OP_GET && reader.get_key(key))
+    {
+        shared_lock<shared_mutex> lock(index_mutex);
+        User *user = find_key(key);
+        status = user ? STATUS_OK : STATUS_NOT_FOUND;
+        if (user)
+            put_user(out, *user);
+    }
+    else if (op == OP_MGET)
+    {
+        uint32_t count;
+        vector<RequestKey> keys;
+        if (reader.get_value(count) && count <= length)
+        {
+            keys.resize(count);
+            for (RequestKey &k : keys)
+                reader.get_key(k);
+        }
+        if (reader.ok)
+        {
+            status = STATUS_OK;
+            put_value<uint32_t>(out, count);
+            shared_lock<shared_mutex> lock(index_mutex);
+            for (RequestKey &k : keys)
+            {
+                User *user = find_key(k);
+                put_value<uint8_t>(out, user != nullptr);
+                if (user)
+                    put_user(out, *user);
+            }
+        }
+    }
+    else if (op == OP_PUT)
+    {
+        User user;
+        if (reader.get_user(user))
+        {
+            unique_lock<shared_mutex> lock(index_mutex);
+            status = users_index->update(move(user)) >= 0 ? STATUS_OK : STATUS_FULL;
+        }
+    }
+    else if (op == OP_DEL && reader.get_key(key))
+    {
+        unique_lock<shared_mutex> lock(index_mutex);
+        User *user = find_key(key);
+        status = user ? STATUS_OK : STATUS_NOT_FOUND;
+        if (user)
+            users_index->remove(user);
+    }
+
+    out[status_at] = status;
+    end_frame(out, frame);
+}
+
+/**
+ * @brief Hilo de trabajo: atiende las conexiones que el hilo principal agregó a su epoll.
+ * @param requests Pedidos respondidos por el hilo, se suma al terminar.
+ */
+void worker(int epoll_fd, atomic<size_t> &requests)
+{
+    unordered_map<int, Connection> connections;
+    vector<epoll_event> events(256);
+    vector<char> chunk(READ_CHUNK);
+    size_t answered = 0;
+
+    auto close_connection = [&](int fd)
+    {
+        epoll_ctl(epoll_fd, EPOLL_CTL_DEL, fd, nullptr);
+        close(fd);
+        connections.erase(fd);
+    };
+
+    // envía lo que se pueda de output y elige si esperar para leer o para escribir
+    auto flush = [&](int fd, Connection &connection)
+    {
+        while (connection.sent < connection.output.size())
+        {
+            ssize_t written = send(fd, connection.output.data() + connection.sent,
+                                   connection.output.size() - connection.sent, MSG_NOSIGNAL);
+            if (written < 0)
+            {
+                if (errno == EAGAIN || errno == EWOULDBLOCK)
+                    break;
+                if (errno == EINTR)
+                    continue;
+                return false;
+            }
+            connection.sent += written;
+        }
+        if (connection.sent == connection.output.size())
+        {
+            connection.output.clear();
+            connection.sent = 0;
+        }
+        bool writing = !connection.output.empty();
+        if (writing != connection.writing)
+        {
+            epoll_event event{};
+            event.events = writing ? EPOLLOUT : EPOLLIN;
+            event.data.fd = fd;
+            epoll_ctl(epoll_fd, EPOLL_CTL_MOD, fd, &event);
+            connection.writing = writing;
+        }
+        return true;
+    };
+
+    while (running)
+    {
+        int n_events = epoll_wait(epoll_fd, events.data(), events.size(), 200);
+        for (int e = 0; e < n_events; e++)
+        {
+            int fd = events[e].data.fd;
+            Connection &connection = connections[fd];
+            if (events[e].events & (EPOLLERR | EPOLLHUP) && !(events[e].events & EPOLLIN))
+            {
+                close_connection(fd);
+                continue;
+            }
+            if (connection.writing)
+            {
+                if (!flush(fd, connection))
+                    close_connection(fd);
+                continue;
+            }
+
+            // se lee todo lo disponible y se responden todos los pedidos completos de una vez
+            bool closed = false;
+            while (connection.output.size() < MAX_PENDING_OUTPUT)
+            {
+                ssize_t received = recv(fd, chunk.data(), chunk.size(), 0);
+                if (received == 0 || (received < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR))
+                {
+                    closed = true;
+                    break;
+                }
+                if (received < 0)
+                    break;
+                connection.input.append(chunk.data(), received);
+
+                size_t pos = 0;
+                const char *body;
+                uint32_t length;
+                int result;
+                while ((result = next_frame(connection.input, pos, body, length)) == 1)
+                {
+                    handle_request(body, length, connection.output);
+                    answered++;
+                }
+                connection.input.erase(0, pos);
+                if (result < 0)
+                {
+                    closed = true;
+                    break;
+                }
+                if (received < (ssize_t)chunk.size())
+                    break;
+            }
+            // lo ya respondido se envía aunque después se cierre la conexión
+            if (!flush(fd, connection) || closed)
+                close_connection(fd);
+        }
+    }
+    for (auto &entry : connections)
+        close(entry.first);
+    close(epoll_fd);
+    requests += answered;
+}
+
+void stop(int)
+{
+    running = false;
+}
+
+int main(int argc, char *argv[])
+{
+  string address = argc > 1 ? argv[1] : "unix:/tmp/entregable2.sock";
+  int n_threads = argc > 2 ? stoi(argv[2]) : 0;
+  string csv = argc > 3 ? argv[3] : "universities_followers_without_duplicates.csv";
+  if (n_threads <= 0)
+    n_threads = max(1u, thread::hardware_concurrency());
+
+  vector<User> users = readCSV(csv);
+  // espacio de sobra para los PUT de usuarios nuevos y para que los indices queden con factor de carga bajo
+  UserIndex index(next_prime(users.size() * 4 + 1024), linear_probing, linear_probing);
+  for (User &user : users)
+    index.insert(move(user));
+  users.clear();
+  users_index = &index;
+
+  int listen_fd = listen_on(address);
+  if (listen_fd < 0)
+    return 1;
+  set_nonblocking(listen_fd);
+  signal(SIGINT, stop);
+  signal(SIGTERM, stop);
+  signal(SIGPIPE, SIG_IGN);
+
+  atomic<size_t> requests(0);
+  vector<int> epolls;
+  vector<thread> threads;
+  for (int t = 0; t < n_threads; t++)
+  {
+    epolls.push_back(epoll_create1(0));
+    threads.emplace_back(worker, epolls.back(), ref(requests));
+  }
+  cout << "Escuchando en " << address << " con " << index.size << " usuarios y " << n_threads << " hilos." << endl;
+
+  // el hilo principal solo acepta conexiones y las reparte
+  int accept_epoll = epoll_create1(0);
+  epoll_event event{};
+  event.events = EPOLLIN;
+  event.data.fd = listen_fd;
+  epoll_ctl(accept_epoll, EPOLL_CTL_ADD, listen_fd, &event);
+  size_t next_worker = 0;
+  while (running)
+  {
+    if (epoll_wait(accept_epoll, &event, 1, 200) <= 0)
+      continue;
+    int fd;
+    while ((fd = accept4(listen_fd, nullptr, nullptr, SOCK_NONBLOCK)) >= 0)
+    {
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+      epoll_event connection_event{};
+      connection_event.events = EPOLLIN;
+      connection_event.data.fd = fd;
+      epoll_ctl(epolls[next_worker++ % n_threads], EPOLL_CTL_ADD, fd, &connection_event);
+    }
+  }
+
+  for (thread &th : threads)
+    th.join();
+  close(accept_epoll);
+  close(listen_fd);
+  if (address.rfind("unix:", 0) == 0)
+    unlink(address.substr(5).c_str());
+  cout << "Pedidos respondidos: " << requests << endl;
+  return 0;
+}
@@ -6,10 +6,33 @@
 #include <numeric>
 #include <unordered_map>
 #include <variant>
+#include <random>
+#include <algorithm>
+#include <thread>
+#include <atomic>
+#include <climits>
 
 #include "hash_functions.h"
 #include "hash_tables.h"
 #include "functions.h"
+#include "data_generator.h"
+#include "user_index.h"
+#include "date_index.h"
+#include "bloom_filter.h"
+#include "perfect_hash.h"
+#include "alloc_counter.h"
+#include "prefix_index.h"
+#include "probe_policy.h"
+#include "wal.h"
+#include "huge_pages.h"
+#include "perf_counter.h"
+#include "trace.h"
+#include "hash_quality.h"
+#include "adaptive_table.h"
+#include "disk_hash.h"
+#include "hash_join.h"
+#include "hyperloglog.h"
+#include "concurrent_table.h"
 
 using namespace std;
 using namespace std::chrono;
@@ -30,6 +53,8 @@ enum HashTableType
     user_name_close,
     unordered_map_by_name,
     unordered_map_by_id,
+    user_id_bucket,
+    user_name_bucket,
 };
 
 //----------------------------------------------------------------------//
@@ -74,6 +99,24 @@ double test_insert(HashTableType type, int max_size, vector<User> &users, int n_
         }
         break;
     }
+    case user_id_bucket:
+    {
+        BucketHashTableUserId hash_table(max_size, users);
+        for (int i = 0; i < n_inserts; i++)
+        {
+            hash_table.insert(users[i].userId, i);
+        }
+        break;
+    }
+    case user_name_bucket:
+    {
+        BucketHashTableUserName hash_table(max_size, users);
+        for (int i = 0; i < n_inserts; i++)
+        {
+            hash_table.insert(users[i].userName, i);
+        }
+        break;
+    }
     case unordered_map_by_name:
     {
         unordered_map<string, User> hash_table;
@@ -104,7 +147,10 @@ double test_insert(HashTableType type, int max_size, vector<User> &users, int n_
         {
             hash_table.insert(users[i].userId, &users[i]);
         }
-        break;
+        // el tiempo se toma antes del destructor (que libera las copias), como se medía antes de que la tabla
+        // tuviera destructor, así los resultados siguen siendo comparables
+        chrono::duration<double> duration = chrono::high_resolution_clock::now() - start;
+        return duration.count();
     }
     case user_name_close:
     {
@@ -160,6 +206,8 @@ void test_inserts_by_username(int n_tests, vector<User> users, int table_size, s
             file_out << test_insert(user_name_close, table_size, users, inserts, nullptr, quadratic_probing) * CONSTANT << endl;
             file_out << "chaining," << inserts << ",";
             file_out << test_insert(user_name_open, table_size, users, inserts) * CONSTANT << endl;
+            file_out << "bucketized," << inserts << ",";
+            file_out << test_insert(user_name_bucket, table_size, users, inserts) * CONSTANT << endl;
             file_out << "STL unordered map," << inserts << ",";
             file_out << test_insert(unordered_map_by_name, table_size, users, inserts) * CONSTANT << endl;
         }
@@ -196,6 +244,8 @@ void test_inserts_by_userid(int n_tests, vector<User> users, int table_size, str
             file_out << test_insert(user_id_close, table_size, users, inserts, quadratic_probing, nullptr) * CONSTANT << endl;
             file_out << "chaining," << inserts << ",";
             file_out << test_insert(user_id_open, table_size, users, inserts) * CONSTANT << endl;
+            file_out << "bucketized," << inserts << ",";
+            file_out << test_insert(user_id_bucket, table_size, users, inserts) * CONSTANT << endl;
             file_out << "STL unordered map," << inserts << ",";
             file_out << test_insert(unordered_map_by_id, table_size, users, inserts) * CONSTANT << endl;
         }
@@ -210,6 +260,15 @@ void test_inserts_by_userid(int n_tests, vector<User> users, int table_size, str
 // En test seach no tiene mucho sentido hacer un switch que construya tablas hash, por lo que
 // En este caso solo se hara override en la función
 
+/**
+ * @brief Guarda value en una variable volatile para que el compilador no elimine las busquedas que lo calcularon.
+ */
+void do_not_optimize(size_t value)
+{
+    volatile size_t sink = value;
+    (void)sink;
+}
+
 /**
  * @brief Calcula la cantidad de tiempo que demora buscar una cantidad de User's dada por el usuario
  * @param hash_table: Tabla hash la cual ya posee datos dentro de sí
@@ -218,15 +277,17 @@ void test_inserts_by_userid(int n_tests, vector<User> users, int table_size, str
  */
 double test_search(CloseHashTableUserId &hash_table, vector<User> users_to_search, int n_searchs)
 {
+    size_t found = 0;
     auto start = chrono::high_resolution_clock::now();
 
     for (int i = 0; i < n_searchs; i++)
     {
-        hash_table.search(users_to_search[i].userId);
+        found += hash_table.search(users_to_search[i].userId) != nullptr;
     }
 
     auto end = chrono::high_resolution_clock::now();
     chrono::duration<double> duration = end - start;
+    do_not_optimize(found);
 
     return duration.count();
 }
@@ -239,15 +300,17 @@ double test_search(CloseHashTableUserId &hash_table, vector<User> users_to_searc
  */
 double test_search(OpenHashTableUserId &hash_table, vector<User> users_to_search, int n_searchs)
 {
+    size_t found = 0;
     auto start = chrono::high_resolution_clock::now();
 
     for (int i = 0; i < n_searchs; i++)
     {
-        hash_table.search(users_to_search[i].userId);
+        found += hash_table.search(users_to_search[i].userId) != nullptr;
     }
 
     auto end = chrono::high_resolution_clock::now();
     chrono::duration<double> duration = end - start;
+    do_not_optimize(found);
 
     return duration.count();
 }
@@ -260,15 +323,17 @@ double test_search(OpenHashTableUserId &hash_table, vector<User> users_to_search
  */
 double test_search(unordered_map<unsigned long long, User> &hash_table, vector<User> users_to_search, int n_searchs)
 {
+    size_t found = 0;
     auto start = chrono::high_resolution_clock::now();
 
     for (int i = 0; i < n_searchs; i++)
     {
-        hash_table.find(users_to_search[i].userId);
+        found += hash_table.find(users_to_search[i].userId) != hash_table.end();
     }
 
     auto end = chrono::high_resolution_clock::now();
     chrono::duration<double> duration = end - start;
+    do_not_optimize(found);
 
     return duration.count();
 }
@@ -281,15 +346,17 @@ double test_search(unordered_map<unsigned long long, User> &hash_table, vector<U
  */
 double test_search(CloseHashTableUserName &hash_table, vector<User> users_to_search, int n_searchs)
 {
+    size_t found = 0;
     auto start = chrono::high_resolution_clock::now();
 
     for (int i = 0; i < n_searchs; i++)
     {
-        hash_table.search(users_to_search[i].userName);
+        found += hash_table.search(users_to_search[i].userName) != nullptr;
     }
 
     auto end = chrono::high_resolution_clock::now();
     chrono::duration<double> duration = end - start;
+    do_not_optimize(found);
 
     return duration.count();
 }
@@ -302,15 +369,63 @@ double test_search(CloseHashTableUserName &hash_table, vector<User> users_to_sea
  */
 double test_search(OpenHashTableUserName &hash_table, vector<User> users_to_search, int n_searchs)
 {
+    size_t found = 0;
+    auto start = chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < n_searchs; i++)
+    {
+        found += hash_table.search(users_to_search[i].userName) != nullptr;
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    chrono::duration<double> duration = end - start;
+    do_not_optimize(found);
+
+    return duration.count();
+}
+
+/**
+ * @brief Calcula la cantidad de tiempo que demora buscar una cantidad de User's dada por el usuario
+ * @param hash_table: Tabla hash la cual ya posee datos dentro de sí
+ * @param users_to_search: Usuarios que se usaran para las busquedas
+ * @param n_searchs: Cantidad de busquedas que se haran en el test.
+ */
+double test_search(BucketHashTableUserId &hash_table, vector<User> users_to_search, int n_searchs)
+{
+    size_t found = 0;
+    auto start = chrono::high_resolution_clock::now();
+
+    for (int i = 0; i < n_searchs; i++)
+    {
+        found += hash_table.search(users_to_search[i].userId) != nullptr;
+    }
+
+    auto end = chrono::high_resolution_clock::now();
+    chrono::duration<double> duration = end - start;
+    do_not_optimize(found);
+
+    return duration.count();
+}
+
+/**
+ * @brief Calcula la cantidad de tiempo que demora buscar una cantidad de User's dada por el usuario
+ * @param hash_table: Tabla hash la cual ya posee datos dentro de sí
+ * @param users_to_search: Usuarios que se usaran para las busquedas
+ * @param n_searchs: Cantidad de busquedas que se haran en el test.
+ */
+double test_search(BucketHashTableUserName &hash_table, vector<User> users_to_search, int n_searchs)
+{
+    size_t found = 0;
     auto start = chrono::high_resolution_clock::now();
 
     for (int i = 0; i < n_searchs; i++)
     {
-        hash_table.search(users_to_search[i].userName);
+        found += hash_table.search(users_to_search[i].userName) != nullptr;
     }
 
     auto end = chrono::high_resolution_clock::now();
     chrono::duration<double> duration = end - start;
+    do_not_optimize(found);
 
     return duration.count();
 }
@@ -323,15 +438,17 @@ double test_search(OpenHashTableUserName &hash_table, vector<User> users_to_sear
  */
 double test_search(unordered_map<string, User> &hash_table, vector<User> users_to_search, int n_searchs)
 {
+    size_t found = 0;
     auto start = chrono::high_resolution_clock::now();
 
     for (int i = 0; i < n_searchs; i++)
     {
-        hash_table.find(users_to_search[i].userName);
+        found += hash_table.find(users_to_search[i].userName) != hash_table.end();
     }
 
     auto end = chrono::high_resolution_clock::now();
     chrono::duration<double> duration = end - start;
+    do_not_optimize(found);
 
     return duration.count();
 }
@@ -356,12 +473,13 @@ void test_searchs_by_username(int n_tests, vector<User> users_in_tables, vector<
     CloseHashTableUserName double_table(table_size, double_hashing);
     CloseHashTableUserName quadratic_table(table_size, quadratic_probing);
     OpenHashTableUserName chaining_table(table_size);
+    BucketHashTableUserName bucket_table(table_size, users_in_tables);
     unordered_map<string, User> STL_table(table_size);
 
     int CONSTANT = 1000; //< esto transforma a ms
 
-    // rellenemos las tablas con datos
-    for (User user : users_in_tables)
+    // rellenemos las tablas con datos, por referencia: chaining_table guarda el puntero y no una copia
+    for (User &user : users_in_tables)
     {
         linear_table.insert(user.userName, &user);
         double_table.insert(user.userName, &user);
@@ -369,6 +487,10 @@ void test_searchs_by_username(int n_tests, vector<User> users_in_tables, vector<
         chaining_table.insert(user.userName, &user);
         STL_table[user.userName] = user;
     }
+    for (size_t i = 0; i < users_in_tables.size(); i++)
+    {
+        bucket_table.insert(users_in_tables[i].userName, i);
+    }
     int n_searchs[] = {1000, 2500, 5000, 10000, 12500, 15000, 17500, 19908};
 
     ofstream file_out(file_name + ".csv", ios::app);
@@ -387,6 +509,8 @@ void test_searchs_by_username(int n_tests, vector<User> users_in_tables, vector<
             file_out << test_search(quadratic_table, users_to_search, searchs) * CONSTANT << endl;
             file_out << "chaining," << searchs << ",";
             file_out << test_search(chaining_table, users_to_search, searchs) * CONSTANT << endl;
+            file_out << "bucketized," << searchs << ",";
+            file_out << test_search(bucket_table, users_to_search, searchs) * CONSTANT << endl;
             file_out << "STL unordered map," << searchs << ",";
             file_out << test_search(STL_table, users_to_search, searchs) * CONSTANT << endl;
         }
@@ -414,12 +538,13 @@ void test_searchs_by_userid(int n_tests, vector<User> users_in_tables, vector<Us
     CloseHashTableUserId double_table(table_size, double_hashing);
     CloseHashTableUserId quadratic_table(table_size, quadratic_probing);
     OpenHashTableUserId chaining_table(table_size);
+    BucketHashTableUserId bucket_table(table_size, users_in_tables);
     unordered_map<unsigned long long, User> STL_table(table_size);
 
     int CONSTANT = 1000; //< esto transforma a ms
 
-    // rellenemos las tablas con datos
-    for (User user : users_in_tables)
+    // rellenemos las tablas con datos, por referencia: chaining_table guarda el puntero y no una copia
+    for (User &user : users_in_tables)
     {
         linear_table.insert(user.userId, &user);
         double_table.insert(user.userId, &user);
@@ -427,6 +552,10 @@ void test_searchs_by_userid(int n_tests, vector<User> users_in_tables, vector<Us
         chaining_table.insert(user.userId, &user);
         STL_table[user.userId] = user;
     }
+    for (size_t i = 0; i < users_in_tables.size(); i++)
+    {
+        bucket_table.insert(users_in_tables[i].userId, i);
+    }
     int n_searchs[] = {1000, 2500, 5000, 10000, 12500, 15000, 17500, 19908};
 
     ofstream file_out(file_name + ".csv", ios::app);
@@ -445,6 +574,8 @@ void test_searchs_by_userid(int n_tests, vector<User> users_in_tables, vector<Us
             file_out << test_search(quadratic_table, users_to_search, searchs) * CONSTANT << endl;
             file_out << "chaining," << searchs << ",";
             file_out << test_search(chaining_table, users_to_search, searchs) * CONSTANT << endl;
+            file_out << "bucketized," << searchs << ",";
+            file_out << test_search(bucket_table, users_to_search, searchs) * CONSTANT << endl;
             file_out << "STL unordered map," << searchs << ",";
             file_out << test_search(STL_table, users_to_search, searchs) * CONSTANT << endl;
         }
@@ -469,12 +600,14 @@ void memory_test(int table_size, int n_elements, vector<User> users, string file
     CloseHashTableUserId id_double(table_size, double_hashing);
     CloseHashTableUserId id_quadratic(table_size, quadratic_probing);
     OpenHashTableUserId openuserid(table_size);
+    BucketHashTableUserId bucketuserid(table_size, users);
     for (int i = 0; i < n_elements; i++)
     {
         id_linear.insert(users[i].userId, &users[i]);
         id_double.insert(users[i].userId, &users[i]);
         id_quadratic.insert(users[i].userId, &users[i]);
         openuserid.insert(users[i].userId, &users[i]);
+        bucketuserid.insert(users[i].userId, i);
     }
 
     // User Name
@@ -482,12 +615,14 @@ void memory_test(int table_size, int n_elements, vector<User> users, string file
     CloseHashTableUserName name_double(table_size, double_hashing);
     CloseHashTableUserName name_quadratic(table_size, quadratic_probing);
     OpenHashTableUserName openusername(table_size);
+    BucketHashTableUserName bucketusername(table_size, users);
     for (int i = 0; i < n_elements; i++)
     {
         name_linear.insert(users[i].userName, &users[i]);
         name_double.insert(users[i].userName, &users[i]);
         name_quadratic.insert(users[i].userName, &users[i]);
         openusername.insert(users[i].userName, &users[i]);
+        bucketusername.insert(users[i].userName, i);
     }
 
     ofstream file_out(file_name + ".csv", ios::app);
@@ -497,11 +632,13 @@ void memory_test(int table_size, int n_elements, vector<User> users, string file
     file_out << "Double by userid, " << n_elements << "," << table_size << "," << id_double.get_memory_usage() / CONSTANT << endl;
     file_out << "Quadratic by userid, " << n_elements << "," << table_size << "," << id_quadratic.get_memory_usage() / CONSTANT << endl;
     file_out << "Chaining by userid," << n_elements << "," << table_size << "," << openuserid.get_memory_usage() / CONSTANT << endl;
+    file_out << "Bucketized by userid," << n_elements << "," << table_size << "," << bucketuserid.get_memory_usage() / CONSTANT << endl;
 
     file_out << "Linear by username," << n_elements << "," << table_size << "," << name_linear.get_memory_usage() / CONSTANT << endl;
     file_out << "Double by username," << n_elements << "," << table_size << "," << name_double.get_memory_usage() / CONSTANT << endl;
     file_out << "Quadratic by username," << n_elements << "," << table_size << "," << name_quadratic.get_memory_usage() / CONSTANT << endl;
     file_out << "Chaining by username, " << n_elements << "," << table_size << "," << openusername.get_memory_usage() / CONSTANT << endl;
+    file_out << "Bucketized by username," << n_elements << "," << table_size << "," << bucketusername.get_memory_usage() / CONSTANT << endl;
 
     file_out.close();
 }
@@ -520,12 +657,14 @@ void colisions_test(int table_size, int n_elements, vector<User> users, string f
     CloseHashTableUserId id_double(table_size, double_hashing);
     CloseHashTableUserId id_quadratic(table_size, quadratic_probing);
     OpenHashTableUserId openuserid(table_size);
+    BucketHashTableUserId bucketuserid(table_size, users);
     for (int i = 0; i < n_elements; i++)
     {
         id_linear.insert(users[i].userId, &users[i]);
         id_double.insert(users[i].userId, &users[i]);
         id_quadratic.insert(users[i].userId, &users[i]);
         openuserid.insert(users[i].userId, &users[i]);
+        bucketuserid.insert(users[i].userId, i);
     }
 
     // User Name
@@ -533,12 +672,14 @@ void colisions_test(int table_size, int n_elements, vector<User> users, string f
     CloseHashTableUserName name_double(table_size, double_hashing);
     CloseHashTableUserName name_quadratic(table_size, quadratic_probing);
     OpenHashTableUserName openusername(table_size);
+    BucketHashTableUserName bucketusername(table_size, users);
     for (int i = 0; i < n_elements; i++)
     {
         name_linear.insert(users[i].userName, &users[i]);
         name_double.insert(users[i].userName, &users[i]);
         name_quadratic.insert(users[i].userName, &users[i]);
         openusername.insert(users[i].userName, &users[i]);
+        bucketusername.insert(users[i].userName, i);
     }
 
     ofstream file_out(file_name + ".csv", ios::app);
@@ -549,12 +690,2774 @@ void colisions_test(int table_size, int n_elements, vector<User> users, string f
     file_out << "Double by userid, " << n_elements << "," << table_size << "," << id_double.getCollision() << endl;
     file_out << "Quadratic by userid, " << n_elements << "," << table_size << "," << id_quadratic.getCollision() << endl;
     file_out << "Chaining by userid, " << n_elements << "," << table_size << "," << openuserid.getCollision() << endl;
+    file_out << "Bucketized by userid, " << n_elements << "," << table_size << "," << bucketuserid.getCollision() << endl;
 
     file_out << "Linear by username, " << n_elements << "," << table_size << "," << name_linear.getCollision() << endl;
     file_out << "Double by username, " << n_elements << "," << table_size << "," << name_double.getCollision() << endl;
     file_out << "Quadratic by username, " << n_elements << "," << table_size << "," << name_quadratic.getCollision() << endl;
     file_out << "Chaining by username," << n_elements << "," << table_size << "," << openusername.getCollision() << endl;
+    file_out << "Bucketized by username," << n_elements << "," << table_size << "," << bucketusername.getCollision() << endl;
+
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//-------------------------TESTS DE ESCALAMIENTO------------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Lee el tamaño de las caches de datos del procesador desde /sys, se usan para marcar en los
+ * gráficos donde la tabla deja de caber en L1, L2 y L3.
+ *
+ * @return Vector de pares (nivel, tamaño en bytes), vacío si el sistema no expone la información.
+ */
+vector<pair<int, size_t>> read_cache_sizes()
+{
+    vector<pair<int, size_t>> caches;
+    for (int index = 0; index < 8; index++)
+    {
+        string path = "/sys/devices/system/cpu/cpu0/cache/index" + to_string(index) + "/";
+        ifstream level_file(path + "level"), type_file(path + "type"), size_file(path + "size");
+        if (!level_file || !type_file || !size_file)
+            break;
+
+        int level;
+        string type, size;
+        level_file >> level;
+        type_file >> type;
+        size_file >> size;
+        if (type == "Instruction")
+            continue;
+
+        // el tamaño viene como "48K" o "2048K"
+        size_t bytes = stoull(size);
+        if (size.back() == 'K')
+            bytes *= 1024;
+        else if (size.back() == 'M')
+            bytes *= 1024 * 1024;
+        caches.push_back({level, bytes});
+    }
+    return caches;
+}
+
+/**
+ * @brief Inserta n usuarios en una tabla y mide el tiempo promedio de insercion, busqueda de usuarios
+ * existentes y busqueda de usuarios inexistentes. El resultado se escribe como una fila del csv de escalamiento.
+ *
+ * @param file_out: archivo donde se escribe la fila.
+ * @param name: nombre de la tabla que aparecera en el csv.
+ * @param n: cantidad de usuarios a insertar (se toman los primeros n de users).
+ * @param load_factor: factor de carga con el que se eligio table_size.
+ * @param table_size: tamaño de la tabla.
+ * @param users: usuarios a insertar.
+ * @param hits: indices (menores a n) de los usuarios a buscar que si estan en la tabla.
+ * @param missing: usuarios que no estan en la tabla.
+ * @param insert: función que inserta un usuario a la tabla.
+ * @param search: función que busca un usuario en la tabla, devuelve true si lo encuentra.
+ * @param memory: función que devuelve la memoria usada por la tabla en bytes.
+ */
+template <typename Insert, typename Search, typename Memory>
+void scaling_run(ofstream &file_out, const string &name, size_t n, double load_factor, size_t table_size,
+                 vector<User> &users, const vector<size_t> &hits, const vector<User> &missing,
+                 Insert insert, Search search, Memory memory)
+{
+    auto start = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < n; i++)
+    {
+        insert(users[i]);
+    }
+    auto end = chrono::high_resolution_clock::now();
+    double insert_ns = chrono::duration<double, nano>(end - start).count() / n;
+
+    size_t found = 0;
+    start = chrono::high_resolution_clock::now();
+    for (size_t i : hits)
+    {
+        found += search(users[i]);
+    }
+    end = chrono::high_resolution_clock::now();
+    double hit_ns = chrono::duration<double, nano>(end - start).count() / hits.size();
+
+    start = chrono::high_resolution_clock::now();
+    for (const User &user : missing)
+    {
+        found += search(user);
+    }
+    end = chrono::high_resolution_clock::now();
+    double miss_ns = chrono::duration<double, nano>(end - start).count() / missing.size();
+
+    file_out << name << "," << n << "," << load_factor << "," << table_size << "," << insert_ns << ","
+             << hit_ns << "," << miss_ns << "," << memory() << "," << found << endl;
+}
+
+/**
+ * @brief Mide como escalan las tablas hash cuando la cantidad de usuarios supera el tamaño de las caches.
+ * Para cada cantidad de usuarios y factor de carga el tamaño de la tabla se elige como el primer primo
+ * mayor o igual a n / factor de carga. Los usuarios son generados con generate_users().
+ *
+ * En el archivo csv se guarda: tabla, número de usuarios, factor de carga, tamaño de la tabla, tiempo por insercion(ns),
+ * tiempo por busqueda existente(ns), tiempo por busqueda inexistente(ns), memoria usada(bytes), encontrados.
+ * Los tamaños de las caches se guardan en file_name + "_caches.csv" para poder graficar las transiciones (plot_scaling.py).
+ *
+ * @param sizes: cantidades de usuarios a probar.
+ * @param load_factors: factores de carga a probar.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void scaling_test(vector<size_t> sizes, vector<double> load_factors, string file_name)
+{
+    size_t max_n = *max_element(sizes.begin(), sizes.end());
+    // no se necesitan más de un millón de busquedas para tener un promedio estable
+    size_t n_searchs = min(max_n, (size_t)1000000);
+
+    vector<User> users = generate_users(max_n, 42);
+    // los de generate_missing_users no estan en la tabla
+    vector<User> missing = generate_missing_users(n_searchs, 7);
+    for (User &user : missing)
+    {
+        user.userName += "#";
+    }
+
+    ofstream caches_out(file_name + "_caches.csv", ios::trunc);
+    caches_out << "Nivel,Tamaño(bytes)" << endl;
+    for (auto cache : read_cache_sizes())
+    {
+        caches_out << "L" << cache.first << "," << cache.second << endl;
+    }
+    caches_out.close();
+
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Número de usuarios,Factor de carga,Tamaño de la tabla,Insercion(ns),Busqueda existente(ns),"
+                "Busqueda inexistente(ns),Memoria(bytes),Encontrados"
+             << endl;
+
+    mt19937_64 rng(1);
+    for (size_t n : sizes)
+    {
+        vector<size_t> hits(min(n, n_searchs));
+        uniform_int_distribution<size_t> index_dist(0, n - 1);
+        for (size_t &i : hits)
+        {
+            i = index_dist(rng);
+        }
+        vector<User> missing_n(missing.begin(), missing.begin() + hits.size());
+
+        for (double load_factor : load_factors)
+        {
+            size_t table_size = next_prime((unsigned long long)ceil(n / load_factor));
+            cout << "Escalamiento: " << n << " usuarios, factor de carga " << load_factor << endl;
+
+            // cada tabla se construye y se destruye por separado para no sumar memoria entre ellas
+            {
+                CloseHashTableUserId table(table_size, linear_probing);
+                scaling_run(file_out, "lineal probing by userid", n, load_factor, table_size, users, hits, missing_n,
+                            [&](User &u) { table.insert(u.userId, &u); },
+                            [&](const User &u) { return table.search(u.userId) != nullptr; },
+                            [&]() { return table.get_memory_usage(); });
+            }
+            {
+                CloseHashTableUserId table(table_size, double_hashing);
+                scaling_run(file_out, "double hashing by userid", n, load_factor, table_size, users, hits, missing_n,
+                            [&](User &u) { table.insert(u.userId, &u); },
+                            [&](const User &u) { return table.search(u.userId) != nullptr; },
+                            [&]() { return table.get_memory_usage(); });
+            }
+            {
+                OpenHashTableUserId table(table_size);
+                scaling_run(file_out, "chaining by userid", n, load_factor, table_size, users, hits, missing_n,
+                            [&](User &u) { table.insert(u.userId, &u); },
+                            [&](const User &u) { return table.search(u.userId) != nullptr; },
+                            [&]() { return table.get_memory_usage(); });
+            }
+            {
+                CloseHashTableUserName table(table_size, linear_probing);
+                scaling_run(file_out, "lineal probing by username", n, load_factor, table_size, users, hits, missing_n,
+                            [&](User &u) { table.insert(u.userName, &u); },
+                            [&](const User &u) { return table.search(u.userName) != nullptr; },
+                            [&]() { return table.get_memory_usage(); });
+            }
+            {
+                OpenHashTableUserName table(table_size);
+                scaling_run(file_out, "chaining by username", n, load_factor, table_size, users, hits, missing_n,
+                            [&](User &u) { table.insert(u.userName, &u); },
+                            [&](const User &u) { return table.search(u.userName) != nullptr; },
+                            [&]() { return table.get_memory_usage(); });
+            }
+            {
+                unordered_map<unsigned long long, User *> table(table_size);
+                table.max_load_factor(1.0 / load_factor);
+                scaling_run(file_out, "STL unordered map by userid", n, load_factor, table_size, users, hits, missing_n,
+                            [&](User &u) { table[u.userId] = &u; },
+                            [&](const User &u) { return table.find(u.userId) != table.end(); },
+                            // nodo (puntero siguiente + par + hash guardado) más el arreglo de buckets
+                            [&]() { return table.size() * (sizeof(void *) * 2 + sizeof(pair<unsigned long long, User *>)) +
+                                           table.bucket_count() * sizeof(void *); });
+            }
+        }
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//---------------------TESTS DE LECTURA CON HILOS-----------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Resultado de un hilo del test de lectura. Se alinea a 64 bytes (una linea de cache) para que
+ * los hilos no compartan lineas al escribir sus resultados y el propio test no genere false sharing.
+ */
+struct alignas(64) ThreadResult
+{
+    size_t lookups = 0;   ///< Cantidad de busquedas hechas por el hilo.
+    size_t found = 0;     ///< Cantidad de usuarios encontrados.
+    double seconds = 0.0; ///< Tiempo que demoro el hilo.
+};
+
+/**
+ * @brief Ejecuta busquedas sobre una tabla ya construida desde n_threads hilos al mismo tiempo.
+ *
+ * Con shared_stream todos los hilos recorren la lista completa de usuarios (mismas claves, mismas lineas de cache),
+ * en caso contrario cada hilo recorre solo su parte de la lista (claves disjuntas).
+ *
+ * @param search: función que busca un usuario en la tabla, devuelve true si lo encuentra. Debe ser de solo lectura.
+ * @param users_to_search: usuarios que se buscaran.
+ * @param n_threads: cantidad de hilos.
+ * @param lookups_per_thread: busquedas que hace cada hilo.
+ * @param shared_stream: si los hilos comparten la lista de claves o se la reparten.
+ * @param wall_seconds: aqui se guarda el tiempo total desde que parten hasta que termina el último hilo.
+ * @return Resultado de cada hilo.
+ */
+template <typename Search>
+vector<ThreadResult> run_parallel_searchs(Search search, const vector<User> &users_to_search, int n_threads,
+                                          size_t lookups_per_thread, bool shared_stream, double &wall_seconds)
+{
+    vector<ThreadResult> results(n_threads);
+    vector<thread> threads;
+    atomic<int> ready(0);
+    atomic<bool> go(false);
+
+    for (int t = 0; t < n_threads; t++)
+    {
+        threads.emplace_back([&, t]()
+                             {
+            size_t first = 0, count = users_to_search.size();
+            if (!shared_stream)
+            {
+                first = users_to_search.size() * t / n_threads;
+                count = users_to_search.size() * (t + 1) / n_threads - first;
+            }
+
+            // todos los hilos parten al mismo tiempo
+            ready++;
+            while (!go.load(memory_order_acquire))
+                ;
+
+            size_t found = 0;
+            auto start = chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < lookups_per_thread; i++)
+            {
+                found += search(users_to_search[first + i % count]);
+            }
+            auto end = chrono::high_resolution_clock::now();
+
+            results[t].lookups = lookups_per_thread;
+            results[t].found = found;
+            results[t].seconds = chrono::duration<double>(end - start).count(); });
+    }
+
+    while (ready.load() < n_threads)
+        ;
+    auto start = chrono::high_resolution_clock::now();
+    go.store(true, memory_order_release);
+    for (thread &th : threads)
+    {
+        th.join();
+    }
+    auto end = chrono::high_resolution_clock::now();
+    wall_seconds = chrono::duration<double>(end - start).count();
+
+    return results;
+}
+
+/**
+ * @brief Corre run_parallel_searchs() para 1..max_threads hilos, con claves compartidas y disjuntas, y escribe
+ * en el csv: tabla, usuarios buscados, modo, hilos, busquedas por segundo (total), latencia promedio por hilo(ns),
+ * latencia del hilo más lento(ns).
+ */
+template <typename Search>
+void parallel_search_rows(ofstream &file_out, const string &name, const string &dataset, Search search,
+                          const vector<User> &users_to_search, int max_threads, size_t lookups_per_thread)
+{
+    for (bool shared_stream : {true, false})
+    {
+        for (int n_threads = 1; n_threads <= max_threads; n_threads++)
+        {
+            double wall_seconds;
+            vector<ThreadResult> results = run_parallel_searchs(search, users_to_search, n_threads,
+                                                                lookups_per_thread, shared_stream, wall_seconds);
+            double total_lookups = 0, mean_latency = 0, worst_latency = 0;
+            for (ThreadResult &result : results)
+            {
+                double latency = result.seconds * 1e9 / result.lookups;
+                total_lookups += result.lookups;
+                mean_latency += latency / n_threads;
+                worst_latency = max(worst_latency, latency);
+            }
+            file_out << name << "," << dataset << "," << (shared_stream ? "compartidas" : "disjuntas") << ","
+                     << n_threads << "," << total_lookups / wall_seconds << "," << mean_latency << ","
+                     << worst_latency << endl;
+        }
+    }
+}
+
+/**
+ * @brief Construye cada tabla una vez con users_in_tables y luego la consulta desde 1..max_threads hilos,
+ * buscando usuarios existentes (real_users) y no existentes (fake_users).
+ *
+ * @param max_threads: cantidad máxima de hilos.
+ * @param users_in_tables: usuarios que estaran en las tablas.
+ * @param real_users: usuarios que si estan en las tablas.
+ * @param fake_users: usuarios que no estan en las tablas.
+ * @param table_size: tamaño de las tablas.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ *
+ * @note search() de todas las tablas es de solo lectura, por lo que pueden consultarse desde varios hilos
+ * mientras nadie inserte ni elimine.
+ */
+void threads_test(int max_threads, vector<User> &users_in_tables, vector<User> &real_users,
+                  vector<User> &fake_users, int table_size, string file_name)
+{
+    size_t lookups_per_thread = 1000000;
+
+    CloseHashTableUserId id_linear(table_size, linear_probing);
+    CloseHashTableUserId id_double(table_size, double_hashing);
+    OpenHashTableUserId id_chaining(table_size);
+    CloseHashTableUserName name_linear(table_size, linear_probing);
+    CloseHashTableUserName name_double(table_size, double_hashing);
+    OpenHashTableUserName name_chaining(table_size);
+    unordered_map<unsigned long long, User *> id_STL(table_size);
+    unordered_map<string, User *> name_STL(table_size);
+    for (User &user : users_in_tables)
+    {
+        id_linear.insert(user.userId, &user);
+        id_double.insert(user.userId, &user);
+        id_chaining.insert(user.userId, &user);
+        name_linear.insert(user.userName, &user);
+        name_double.insert(user.userName, &user);
+        name_chaining.insert(user.userName, &user);
+        id_STL[user.userId] = &user;
+        name_STL[user.userName] = &user;
+    }
+
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Usuarios buscados,Claves,Hilos,Busquedas por segundo,Latencia promedio(ns),Latencia peor hilo(ns)" << endl;
+
+    vector<pair<string, vector<User> *>> datasets = {{"reales", &real_users}, {"falsos", &fake_users}};
+    for (auto &dataset : datasets)
+    {
+        const vector<User> &users = *dataset.second;
+        parallel_search_rows(file_out, "lineal probing by userid", dataset.first,
+                             [&](const User &u) { return id_linear.search(u.userId) != nullptr; }, users, max_threads, lookups_per_thread);
+        parallel_search_rows(file_out, "double hashing by userid", dataset.first,
+                             [&](const User &u) { return id_double.search(u.userId) != nullptr; }, users, max_threads, lookups_per_thread);
+        parallel_search_rows(file_out, "chaining by userid", dataset.first,
+                             [&](const User &u) { return id_chaining.search(u.userId) != nullptr; }, users, max_threads, lookups_per_thread);
+        parallel_search_rows(file_out, "STL unordered map by userid", dataset.first,
+                             [&](const User &u) { return id_STL.find(u.userId) != id_STL.end(); }, users, max_threads, lookups_per_thread);
+        parallel_search_rows(file_out, "lineal probing by username", dataset.first,
+                             [&](const User &u) { return name_linear.search(u.userName) != nullptr; }, users, max_threads, lookups_per_thread);
+        parallel_search_rows(file_out, "double hashing by username", dataset.first,
+                             [&](const User &u) { return name_double.search(u.userName) != nullptr; }, users, max_threads, lookups_per_thread);
+        parallel_search_rows(file_out, "chaining by username", dataset.first,
+                             [&](const User &u) { return name_chaining.search(u.userName) != nullptr; }, users, max_threads, lookups_per_thread);
+        parallel_search_rows(file_out, "STL unordered map by username", dataset.first,
+                             [&](const User &u) { return name_STL.find(u.userName) != name_STL.end(); }, users, max_threads, lookups_per_thread);
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//-----------------------TESTS DE INDICE DE USUARIOS--------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Compara indexar usuarios por userId y userName con dos tablas cerradas separadas (cada una con su copia
+ * de los usuarios) contra un UserIndex (una copia y dos indices). Se mide el tiempo de insertar en ambas claves
+ * y la memoria usada.
+ * En el archivo csv se guarda: estructura, número de inserciones, tiempo(ms), memoria(KB).
+ *
+ * @param n_tests: cantidad de tests a ejecutar.
+ * @param users: usuarios los cuales se insertaran.
+ * @param table_size: tamaño de las tablas e indices.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void user_index_test(int n_tests, vector<User> &users, int table_size, string file_name)
+{
+    int n_inserts[] = {1000, 2500, 5000, 10000, 12500, 15000, 17500, 19908};
+    int CONSTANT = 1000; //< esto transforma a ms y a KB
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Estructura, Número de inserciones, Tiempo(ms), Memoria(KB)" << endl;
+
+    for (int inserts : n_inserts)
+    {
+        for (int i = 0; i < n_tests; i++)
+        {
+            {
+                auto start = chrono::high_resolution_clock::now();
+                CloseHashTableUserId id_table(table_size, linear_probing);
+                CloseHashTableUserName name_table(table_size, linear_probing);
+                for (int j = 0; j < inserts; j++)
+                {
+                    id_table.insert(users[j].userId, &users[j]);
+                    name_table.insert(users[j].userName, &users[j]);
+                }
+                auto end = chrono::high_resolution_clock::now();
+                chrono::duration<double> duration = end - start;
+                file_out << "2 tablas cerradas," << inserts << "," << duration.count() * CONSTANT << ","
+                         << (id_table.get_memory_usage() + name_table.get_memory_usage()) / CONSTANT << endl;
+            }
+            {
+                auto start = chrono::high_resolution_clock::now();
+                UserIndex index(table_size, linear_probing, linear_probing);
+                for (int j = 0; j < inserts; j++)
+                {
+                    index.insert(users[j]);
+                }
+                auto end = chrono::high_resolution_clock::now();
+                chrono::duration<double> duration = end - start;
+                file_out << "UserIndex," << inserts << "," << duration.count() * CONSTANT << ","
+                         << index.get_memory_usage() / CONSTANT << endl;
+            }
+        }
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//-------------------TESTS DE RANGOS DE FECHA DE CREACIÓN---------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Compara consultas por rango de fecha de creación usando CreatedAtIndex contra recorrer el vector de usuarios,
+ * tanto comparando createdAtEpoch como transformando el string createdAt en cada consulta (lo que se hacia antes).
+ * En el archivo csv se guarda: método, número de usuarios, largo del rango(días), tiempo por consulta(us).
+ *
+ * @param users: usuarios sobre los que se hacen las consultas.
+ * @param n_queries: cantidad de consultas por cada largo de rango.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void created_at_test(vector<User> &users, int n_queries, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Método, Número de usuarios, Rango(días), Tiempo por consulta(us)" << endl;
+
+    auto start = chrono::high_resolution_clock::now();
+    CreatedAtIndex index(users);
+    auto end = chrono::high_resolution_clock::now();
+    file_out << "construccion del indice," << users.size() << ",0,"
+             << chrono::duration<double, micro>(end - start).count() << endl;
+
+    long long first = LLONG_MAX, last = LLONG_MIN;
+    for (User &user : users)
+    {
+        first = min(first, user.createdAtEpoch);
+        last = max(last, user.createdAtEpoch);
+    }
+
+    // los recorridos lineales son O(n), por lo que se hacen menos consultas
+    int n_scans = max(1, n_queries / 100);
+    mt19937_64 rng(3);
+    uniform_int_distribution<long long> from_dist(first, last);
+    long long checksum = 0;
+
+    for (int days : {1, 30, 365})
+    {
+        long long length = days * 86400LL;
+        vector<long long> from(n_queries);
+        for (long long &f : from)
+        {
+            f = from_dist(rng);
+        }
+
+        start = chrono::high_resolution_clock::now();
+        for (long long f : from)
+        {
+            checksum += index.count(f, f + length);
+        }
+        end = chrono::high_resolution_clock::now();
+        file_out << "indice count," << users.size() << "," << days << ","
+                 << chrono::duration<double, micro>(end - start).count() / n_queries << endl;
+
+        start = chrono::high_resolution_clock::now();
+        for (long long f : from)
+        {
+            for (const User *user : index.range(f, f + length))
+            {
+                checksum += user->followersCount;
+            }
+        }
+        end = chrono::high_resolution_clock::now();
+        file_out << "indice range," << users.size() << "," << days << ","
+                 << chrono::duration<double, micro>(end - start).count() / n_queries << endl;
 
+        start = chrono::high_resolution_clock::now();
+        for (int q = 0; q < n_scans; q++)
+        {
+            for (User &user : users)
+            {
+                if (user.createdAtEpoch >= from[q] && user.createdAtEpoch <= from[q] + length)
+                    checksum += user.followersCount;
+            }
+        }
+        end = chrono::high_resolution_clock::now();
+        file_out << "recorrido con epoch," << users.size() << "," << days << ","
+                 << chrono::duration<double, micro>(end - start).count() / n_scans << endl;
+
+        start = chrono::high_resolution_clock::now();
+        for (int q = 0; q < n_scans; q++)
+        {
+            for (User &user : users)
+            {
+                long long created = parseCreatedAt(user.createdAt);
+                if (created >= from[q] && created <= from[q] + length)
+                    checksum += user.followersCount;
+            }
+        }
+        end = chrono::high_resolution_clock::now();
+        file_out << "recorrido con string," << users.size() << "," << days << ","
+                 << chrono::duration<double, micro>(end - start).count() / n_scans << endl;
+    }
+    // se imprime para que el compilador no elimine las consultas
+    cout << "Checksum rangos de fechas: " << checksum << endl;
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//--------------------TESTS DE AGREGADOS POR UNIVERSIDAD----------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Compara las consultas por universidad (top 100 por followersCount y total de tweets) usando los agregados
+ * incrementales de UserIndex contra recorrer todos los usuarios, además del costo extra que tienen en insert.
+ * En el archivo csv se guarda: consulta, método, número de usuarios, tiempo por consulta(us).
+ *
+ * @param users: usuarios a indexar.
+ * @param n_queries: cantidad de veces que se repite cada consulta por universidad.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void university_stats_test(vector<User> &users, int n_queries, string file_name)
+{
+    int top_k = 100;
+    int table_size = next_prime(users.size() * 1.1);
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Consulta, Método, Número de usuarios, Tiempo(us)" << endl;
+
+    // costo de mantener los agregados en cada insert
+    for (bool track_stats : {false, true})
+    {
+        auto start = chrono::high_resolution_clock::now();
+        UserIndex index(table_size, linear_probing, linear_probing, track_stats);
+        for (User &user : users)
+        {
+            index.insert(user);
+        }
+        auto end = chrono::high_resolution_clock::now();
+        file_out << "insert (total)," << (track_stats ? "con agregados" : "sin agregados") << "," << users.size() << ","
+                 << chrono::duration<double, micro>(end - start).count() << endl;
+    }
+
+    UserIndex index(table_size, linear_probing, linear_probing, true);
+    for (User &user : users)
+    {
+        index.insert(user);
+    }
+    vector<string> universities;
+    for (auto &entry : index.stats.universities)
+    {
+        universities.push_back(entry.first);
+    }
+    int n_total = n_queries * universities.size();
+    long long checksum = 0;
+
+    auto start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < n_queries; q++)
+    {
+        for (string &university : universities)
+        {
+            for (const User *user : index.stats.top_followers(university, top_k))
+            {
+                checksum += user->userId;
+            }
+        }
+    }
+    auto end = chrono::high_resolution_clock::now();
+    file_out << "top " << top_k << " seguidores,agregados," << users.size() << ","
+             << chrono::duration<double, micro>(end - start).count() / n_total << endl;
+
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < n_queries; q++)
+    {
+        for (string &university : universities)
+        {
+            vector<const User *> candidates;
+            for (User &user : users)
+            {
+                if (user.university == university)
+                    candidates.push_back(&user);
+            }
+            int k = min(top_k, (int)candidates.size());
+            partial_sort(candidates.begin(), candidates.begin() + k, candidates.end(), [](const User *a, const User *b)
+                         { return a->followersCount > b->followersCount; });
+            for (int i = 0; i < k; i++)
+            {
+                checksum += candidates[i]->userId;
+            }
+        }
+    }
+    end = chrono::high_resolution_clock::now();
+    file_out << "top " << top_k << " seguidores,recorrido," << users.size() << ","
+             << chrono::duration<double, micro>(end - start).count() / n_total << endl;
+
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < n_queries; q++)
+    {
+        for (string &university : universities)
+        {
+            checksum += index.stats.get(university)->total_tweets;
+        }
+    }
+    end = chrono::high_resolution_clock::now();
+    file_out << "total de tweets,agregados," << users.size() << ","
+             << chrono::duration<double, micro>(end - start).count() / n_total << endl;
+
+    start = chrono::high_resolution_clock::now();
+    for (int q = 0; q < n_queries; q++)
+    {
+        for (string &university : universities)
+        {
+            long long total = 0;
+            for (User &user : users)
+            {
+                if (user.university == university)
+                    total += user.numberTweets;
+            }
+            checksum += total;
+        }
+    }
+    end = chrono::high_resolution_clock::now();
+    file_out << "total de tweets,recorrido," << users.size() << ","
+             << chrono::duration<double, micro>(end - start).count() / n_total << endl;
+
+    // se imprime para que el compilador no elimine las consultas
+    cout << "Checksum agregados por universidad: " << checksum << endl;
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//-------------------------TESTS DE FILTRO BLOOM------------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Tiempo promedio (ns) de buscar todos los usuarios de users_to_search, repitiendo n_tests veces.
+ * @param search: función que busca un usuario, devuelve true si lo encuentra.
+ */
+template <typename Search>
+double average_search_ns(Search search, const vector<User> &users_to_search, int n_tests)
+{
+    size_t found = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for (int t = 0; t < n_tests; t++)
+    {
+        for (const User &user : users_to_search)
+        {
+            found += search(user);
+        }
+    }
+    auto end = chrono::high_resolution_clock::now();
+    do_not_optimize(found);
+    return chrono::duration<double, nano>(end - start).count() / (n_tests * users_to_search.size());
+}
+
+/**
+ * @brief Escribe las filas del test de Bloom para una tabla: latencia de busquedas inexistentes y existentes sin filtro
+ * y con filtro, proporción de falsos positivos (antes y después de eliminar la mitad de los usuarios) y memoria.
+ */
+template <typename Table, typename Key>
+void bloom_rows(ofstream &file_out, const string &name, Table &table, BloomFilteredTable<Table, Key> &filtered,
+                vector<User> &real_users, vector<User> &fake_users, int n_tests)
+{
+    double miss = average_search_ns([&](const User &u) { return table.search(UserKey<Key>::get(u)) != nullptr; }, fake_users, n_tests);
+    double hit = average_search_ns([&](const User &u) { return table.search(UserKey<Key>::get(u)) != nullptr; }, real_users, n_tests);
+    file_out << name << ",sin filtro," << miss << "," << hit << ",0,0," << table.get_memory_usage() << endl;
+
+    filtered.rejected = filtered.false_positives = 0;
+    miss = average_search_ns([&](const User &u) { return filtered.search(UserKey<Key>::get(u)) != nullptr; }, fake_users, n_tests);
+    double fp_rate = filtered.false_positive_rate();
+    hit = average_search_ns([&](const User &u) { return filtered.search(UserKey<Key>::get(u)) != nullptr; }, real_users, n_tests);
+    size_t memory = filtered.get_memory_usage();
+
+    // se elimina la mitad de los usuarios y se buscan los eliminados, el filtro con contadores deberia rechazarlos
+    vector<User> removed;
+    for (size_t i = 0; i < real_users.size(); i += 2)
+    {
+        filtered.remove(UserKey<Key>::get(real_users[i]));
+        removed.push_back(real_users[i]);
+    }
+    filtered.rejected = filtered.false_positives = 0;
+    for (const User &user : removed)
+    {
+        filtered.search(UserKey<Key>::get(user));
+    }
+    file_out << name << ",con filtro," << miss << "," << hit << "," << fp_rate << "," << filtered.false_positive_rate()
+             << "," << memory << endl;
+}
+
+/**
+ * @brief Compara la latencia de busquedas de usuarios inexistentes (y existentes) con y sin un CountingBloomFilter
+ * delante de cada tabla.
+ * En el archivo csv se guarda: tabla, filtro, busqueda inexistente(ns), busqueda existente(ns), falsos positivos,
+ * falsos positivos después de eliminar, memoria(bytes).
+ *
+ * @param n_tests: cantidad de veces que se buscan todos los usuarios.
+ * @param real_users: usuarios que estaran en las tablas.
+ * @param fake_users: usuarios que no estan en las tablas.
+ * @param table_size: tamaño de las tablas.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void bloom_test(int n_tests, vector<User> &real_users, vector<User> &fake_users, int table_size, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Filtro,Busqueda inexistente(ns),Busqueda existente(ns),Falsos positivos,"
+                "Falsos positivos despues de eliminar,Memoria(bytes)"
+             << endl;
+
+    // linear_probing esta sobrecargada, por lo que hay que elegir la versión antes de pasarla al constructor genérico
+    int (*linear_probing_id)(unsigned long long, int, int) = linear_probing;
+    unsigned int (*linear_probing_name)(const string &, int, int) = linear_probing;
+
+    {
+        CloseHashTableUserId table(table_size, linear_probing);
+        BloomFilteredTable<CloseHashTableUserId, unsigned long long> filtered(real_users.size(), table_size, linear_probing_id);
+        for (User &user : real_users)
+        {
+            table.insert(user.userId, &user);
+            filtered.insert(user.userId, &user);
+        }
+        bloom_rows(file_out, "lineal probing by userid", table, filtered, real_users, fake_users, n_tests);
+    }
+    {
+        OpenHashTableUserId table(table_size);
+        BloomFilteredTable<OpenHashTableUserId, unsigned long long> filtered(real_users.size(), table_size);
+        for (User &user : real_users)
+        {
+            table.insert(user.userId, &user);
+            filtered.insert(user.userId, &user);
+        }
+        bloom_rows(file_out, "chaining by userid", table, filtered, real_users, fake_users, n_tests);
+    }
+    {
+        CloseHashTableUserName table(table_size, linear_probing);
+        BloomFilteredTable<CloseHashTableUserName, string> filtered(real_users.size(), table_size, linear_probing_name);
+        for (User &user : real_users)
+        {
+            table.insert(user.userName, &user);
+            filtered.insert(user.userName, &user);
+        }
+        bloom_rows(file_out, "lineal probing by username", table, filtered, real_users, fake_users, n_tests);
+    }
+    {
+        OpenHashTableUserName table(table_size);
+        BloomFilteredTable<OpenHashTableUserName, string> filtered(real_users.size(), table_size);
+        for (User &user : real_users)
+        {
+            table.insert(user.userName, &user);
+            filtered.insert(user.userName, &user);
+        }
+        bloom_rows(file_out, "chaining by username", table, filtered, real_users, fake_users, n_tests);
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//-----------------------TESTS DE ELIMINADOS (CHURN)--------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Simula una tabla con altas y bajas constantes: en cada ronda se elimina el 10% de los usuarios y se insertan
+ * la misma cantidad de usuarios nuevos, luego se mide el tiempo de busqueda de usuarios existentes e inexistentes.
+ * Sin compactación los eliminados se acumulan y las busquedas de inexistentes recorren secuencias cada vez más largas.
+ */
+template <typename Table, typename Key>
+void churn_rows(ofstream &file_out, const string &name, Table &table, vector<User> &pool, vector<User> &missing,
+                size_t n_live, int rounds)
+{
+    size_t batch = n_live / 10;
+    // usuarios vivos: pool[first, first + n_live), en cada ronda se eliminan los más antiguos
+    size_t first = 0;
+    for (size_t i = 0; i < n_live; i++)
+    {
+        table.insert(UserKey<Key>::get(pool[i]), &pool[i]);
+    }
+
+    for (int round = 0; round <= rounds; round++)
+    {
+        if (round > 0)
+        {
+            for (size_t i = first; i < first + batch; i++)
+            {
+                Key key = UserKey<Key>::get(pool[i]);
+                table.remove(key);
+            }
+            for (size_t i = first + n_live; i < first + n_live + batch; i++)
+            {
+                table.insert(UserKey<Key>::get(pool[i]), &pool[i]);
+            }
+            first += batch;
+        }
+
+        vector<User> live(pool.begin() + first, pool.begin() + first + batch);
+        double hit = average_search_ns([&](const User &u) { return table.search(UserKey<Key>::get(u)) != nullptr; }, live, 1);
+        double miss = average_search_ns([&](const User &u) { return table.search(UserKey<Key>::get(u)) != nullptr; }, missing, 1);
+        file_out << name << "," << (table.auto_compact ? "con compactacion" : "sin compactacion") << "," << round << ","
+                 << hit << "," << miss << "," << table.tombstone_ratio() << "," << table.compactions << endl;
+    }
+}
+
+/**
+ * @brief Mide la latencia de busqueda de las tablas cerradas a lo largo de rondas de eliminaciones e inserciones,
+ * con y sin compactación automática de eliminados.
+ * En el archivo csv se guarda: tabla, compactación, ronda, busqueda existente(ns), busqueda inexistente(ns),
+ * proporción de eliminados, compactaciones.
+ *
+ * @param table_size: tamaño de las tablas, los usuarios vivos son el 70% de este tamaño.
+ * @param rounds: cantidad de rondas de eliminación e inserción.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void churn_test(int table_size, int rounds, string file_name)
+{
+    size_t n_live = table_size * 0.7;
+    vector<User> pool = generate_users(n_live + (n_live / 10) * rounds, 11);
+    vector<User> missing = generate_missing_users(2000, 12);
+    for (User &user : missing)
+    {
+        user.userName += "#";
+    }
+
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Compactacion,Ronda,Busqueda existente(ns),Busqueda inexistente(ns),Proporcion de eliminados,Compactaciones" << endl;
+
+    for (bool auto_compact : {false, true})
+    {
+        {
+            CloseHashTableUserId table(table_size, linear_probing);
+            table.auto_compact = auto_compact;
+            churn_rows<CloseHashTableUserId, unsigned long long>(file_out, "lineal probing by userid", table, pool, missing, n_live, rounds);
+        }
+        {
+            CloseHashTableUserId table(table_size, double_hashing);
+            table.auto_compact = auto_compact;
+            churn_rows<CloseHashTableUserId, unsigned long long>(file_out, "double hashing by userid", table, pool, missing, n_live, rounds);
+        }
+        {
+            CloseHashTableUserName table(table_size, linear_probing);
+            table.auto_compact = auto_compact;
+            churn_rows<CloseHashTableUserName, string>(file_out, "lineal probing by username", table, pool, missing, n_live, rounds);
+        }
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//---------------------TESTS DE ENCADENAMIENTO CON POOL-----------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Compara las tablas de encadenamiento con vector<vector<User *>> contra NodePoolHashTable (buckets de 32 bits
+ * y un pool de nodos contiguo) en memoria y tiempo de busqueda de usuarios existentes e inexistentes.
+ * En el archivo csv se guarda: tabla, número de usuarios, tamaño de la tabla, busqueda existente(ns),
+ * busqueda inexistente(ns), memoria(KB).
+ *
+ * @param n_tests: cantidad de veces que se buscan todos los usuarios.
+ * @param real_users: usuarios que estaran en las tablas.
+ * @param fake_users: usuarios que no estan en las tablas.
+ * @param table_size: tamaño de las tablas.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void node_pool_test(int n_tests, vector<User> &real_users, vector<User> &fake_users, int table_size, string file_name)
+{
+    int CONSTANT = 1000; // Seteado en KB
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Número de usuarios,Tamaño de la tabla,Busqueda existente(ns),Busqueda inexistente(ns),Memoria(KB)" << endl;
+
+    OpenHashTableUserId id_chaining(table_size);
+    OpenHashTableUserName name_chaining(table_size);
+    NodePoolHashTableUserId id_pool(table_size, real_users);
+    NodePoolHashTableUserName name_pool(table_size, real_users);
+    for (size_t i = 0; i < real_users.size(); i++)
+    {
+        id_chaining.insert(real_users[i].userId, &real_users[i]);
+        name_chaining.insert(real_users[i].userName, &real_users[i]);
+        id_pool.insert(real_users[i].userId, i);
+        name_pool.insert(real_users[i].userName, i);
+    }
+
+    auto row = [&](const string &name, auto &table, auto search)
+    {
+        file_out << name << "," << real_users.size() << "," << table_size << ","
+                 << average_search_ns(search, real_users, n_tests) << ","
+                 << average_search_ns(search, fake_users, n_tests) << ","
+                 << table.get_memory_usage() / CONSTANT << endl;
+    };
+    row("chaining by userid", id_chaining, [&](const User &u) { return id_chaining.search(u.userId) != nullptr; });
+    row("node pool by userid", id_pool, [&](const User &u) { return id_pool.search(u.userId) != nullptr; });
+    row("chaining by username", name_chaining, [&](const User &u) { return name_chaining.search(u.userName) != nullptr; });
+    row("node pool by username", name_pool, [&](const User &u) { return name_pool.search(u.userName) != nullptr; });
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//----------------------TESTS DE HASH PERFECTO MÍNIMO-------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe una fila del test de hash perfecto: tiempo de construcción, busqueda existente e inexistente,
+ * y bytes por clave del indice (memoria de la tabla sin contar los 70 bytes de cada usuario).
+ */
+template <typename Search>
+void perfect_hash_row(ofstream &file_out, const string &name, size_t n, double build_ms, size_t memory,
+                      Search search, vector<User> &users, vector<User> &missing)
+{
+    double index_bytes = ((double)memory - 70.0 * n) / n;
+    file_out << name << "," << n << "," << build_ms << "," << average_search_ns(search, users, 1) << ","
+             << average_search_ns(search, missing, 1) << "," << index_bytes << "," << index_bytes * 8 << endl;
+}
+
+/**
+ * @brief Compara PerfectHashTable (solo lectura) contra las tablas existentes con la misma cantidad de claves.
+ * En el archivo csv se guarda: tabla, número de usuarios, construcción(ms), busqueda existente(ns),
+ * busqueda inexistente(ns), bytes por clave del indice, bits por clave del indice.
+ *
+ * @param users: usuarios a guardar (no deben repetir userId ni userName).
+ * @param missing: usuarios que no estan en las tablas.
+ * @param load_factor: factor de carga de las tablas con que se compara.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void perfect_hash_test(vector<User> &users, vector<User> &missing, double load_factor, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Número de usuarios,Construccion(ms),Busqueda existente(ns),Busqueda inexistente(ns),"
+                "Bytes por clave del indice,Bits por clave del indice"
+             << endl;
+    size_t n = users.size();
+    int table_size = next_prime(n / load_factor);
+
+    auto timed = [](auto build)
+    {
+        auto start = chrono::high_resolution_clock::now();
+        build();
+        auto end = chrono::high_resolution_clock::now();
+        return chrono::duration<double, milli>(end - start).count();
+    };
+
+    {
+        PerfectHashTableUserId *table = nullptr;
+        double ms = timed([&]() { table = new PerfectHashTableUserId(users); });
+        perfect_hash_row(file_out, "perfect hash by userid", n, ms, table->get_memory_usage(),
+                         [&](const User &u) { return table->search(u.userId) != nullptr; }, users, missing);
+        delete table;
+    }
+    {
+        PerfectHashTableUserName *table = nullptr;
+        double ms = timed([&]() { table = new PerfectHashTableUserName(users); });
+        perfect_hash_row(file_out, "perfect hash by username", n, ms, table->get_memory_usage(),
+                         [&](const User &u) { return table->search(u.userName) != nullptr; }, users, missing);
+        delete table;
+    }
+    {
+        CloseHashTableUserId table(table_size, linear_probing);
+        double ms = timed([&]() { for (User &u : users) table.insert(u.userId, &u); });
+        perfect_hash_row(file_out, "lineal probing by userid", n, ms, table.get_memory_usage(),
+                         [&](const User &u) { return table.search(u.userId) != nullptr; }, users, missing);
+    }
+    {
+        CloseHashTableUserName table(table_size, linear_probing);
+        double ms = timed([&]() { for (User &u : users) table.insert(u.userName, &u); });
+        perfect_hash_row(file_out, "lineal probing by username", n, ms, table.get_memory_usage(),
+                         [&](const User &u) { return table.search(u.userName) != nullptr; }, users, missing);
+    }
+    {
+        NodePoolHashTableUserName table(table_size, users);
+        double ms = timed([&]() { for (size_t i = 0; i < n; i++) table.insert(users[i].userName, i); });
+        perfect_hash_row(file_out, "node pool by username", n, ms, table.get_memory_usage(),
+                         [&](const User &u) { return table.search(u.userName) != nullptr; }, users, missing);
+    }
+    {
+        BucketHashTableUserName table(table_size, users);
+        double ms = timed([&]() { for (size_t i = 0; i < n; i++) table.insert(users[i].userName, i); });
+        perfect_hash_row(file_out, "bucketized by username", n, ms, table.get_memory_usage(),
+                         [&](const User &u) { return table.search(u.userName) != nullptr; }, users, missing);
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//-------------------------TESTS DE BULK LOAD---------------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Tiempo promedio en milisegundos de construir una tabla con build(), n_tests veces.
+ * build() debe crear la tabla, llenarla y destruirla.
+ */
+template <typename Build>
+double average_build_ms(Build build, int n_tests)
+{
+    double total = 0;
+    for (int i = 0; i < n_tests; i++)
+    {
+        auto start = chrono::high_resolution_clock::now();
+        build();
+        auto end = chrono::high_resolution_clock::now();
+        total += chrono::duration<double, milli>(end - start).count();
+    }
+    return total / n_tests;
+}
+
+/**
+ * @brief Escribe una fila del test de bulk load: construir con insert() uno por uno contra bulk_load() con
+ * cada cantidad de hilos.
+ *
+ * @param insert_loop: construye la tabla con insert().
+ * @param bulk_load: recibe la cantidad de hilos y construye la tabla con bulk_load().
+ */
+template <typename InsertLoop, typename BulkLoad>
+void bulk_load_rows(ofstream &file_out, const string &name, size_t n, int n_tests, const vector<int> &threads,
+                    InsertLoop insert_loop, BulkLoad bulk_load)
+{
+    double loop_ms = average_build_ms(insert_loop, n_tests);
+    for (int n_threads : threads)
+    {
+        double bulk_ms = average_build_ms([&]()
+                                          { bulk_load(n_threads); }, n_tests);
+        file_out << name << "," << n << "," << n_threads << "," << loop_ms << "," << bulk_ms << ","
+                 << loop_ms / bulk_ms << endl;
+    }
+}
+
+/**
+ * @brief Compara construir cada tabla con un ciclo de insert() contra bulk_load() con 1 hilo y con todos los hilos
+ * de la máquina. En el archivo csv se guarda: tabla, número de usuarios, hilos, ciclo de insert(ms), bulk_load(ms),
+ * aceleración.
+ *
+ * @param n_tests: cantidad de veces que se construye cada tabla.
+ * @param users: usuarios a insertar.
+ * @param load_factor: factor de carga de las tablas.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void bulk_load_test(int n_tests, vector<User> &users, double load_factor, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Número de usuarios,Hilos,Ciclo de insert(ms),bulk_load(ms),Aceleración" << endl;
+    size_t n = users.size();
+    int table_size = next_prime(n / load_factor);
+    vector<int> threads = {1};
+    if (resolve_threads(0) > 1)
+        threads.push_back(resolve_threads(0));
+
+    bulk_load_rows(file_out, "lineal probing by userid", n, n_tests, threads, [&]()
+                   { CloseHashTableUserId table(table_size, linear_probing);
+                     for (User &u : users) table.insert(u.userId, &u); },
+                   [&](int t)
+                   { CloseHashTableUserId table(table_size, linear_probing);
+                     table.bulk_load(users, t); });
+    bulk_load_rows(file_out, "lineal probing by username", n, n_tests, threads, [&]()
+                   { CloseHashTableUserName table(table_size, linear_probing);
+                     for (User &u : users) table.insert(u.userName, &u); },
+                   [&](int t)
+                   { CloseHashTableUserName table(table_size, linear_probing);
+                     table.bulk_load(users, t); });
+    bulk_load_rows(file_out, "double hashing by userid", n, n_tests, threads, [&]()
+                   { CloseHashTableUserId table(table_size, double_hashing);
+                     for (User &u : users) table.insert(u.userId, &u); },
+                   [&](int t)
+                   { CloseHashTableUserId table(table_size, double_hashing);
+                     table.bulk_load(users, t); });
+    bulk_load_rows(file_out, "hashing abierto by userid", n, n_tests, threads, [&]()
+                   { OpenHashTableUserId table(table_size);
+                     for (User &u : users) table.insert(u.userId, &u); },
+                   [&](int t)
+                   { OpenHashTableUserId table(table_size);
+                     table.bulk_load(users, t); });
+    bulk_load_rows(file_out, "hashing abierto by username", n, n_tests, threads, [&]()
+                   { OpenHashTableUserName table(table_size);
+                     for (User &u : users) table.insert(u.userName, &u); },
+                   [&](int t)
+                   { OpenHashTableUserName table(table_size);
+                     table.bulk_load(users, t); });
+    bulk_load_rows(file_out, "node pool by username", n, n_tests, threads, [&]()
+                   { NodePoolHashTableUserName table(table_size, users);
+                     for (size_t i = 0; i < n; i++) table.insert(users[i].userName, i); },
+                   [&](int t)
+                   { NodePoolHashTableUserName table(table_size, users);
+                     table.bulk_load(t); });
+    bulk_load_rows(file_out, "bucketized by username", n, n_tests, threads, [&]()
+                   { BucketHashTableUserName table(table_size, users);
+                     for (size_t i = 0; i < n; i++) table.insert(users[i].userName, i); },
+                   [&](int t)
+                   { BucketHashTableUserName table(table_size, users);
+                     table.bulk_load(t); });
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//------------------TESTS DE INSERT CON COPIA / MOVE / EMPLACE----------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe una fila del test de emplace: tiempo y reservas de memoria de insertar todos los usuarios con insert_one.
+ * Cada prueba usa una copia nueva de users (hecha fuera del tiempo medido), así insert_one puede mover sus strings.
+ *
+ * @param make_table: crea una tabla vacía con new.
+ * @param insert_one: recibe la tabla y un usuario y lo inserta.
+ */
+template <typename MakeTable, typename InsertOne>
+void emplace_row(ofstream &file_out, const string &name, const string &method, vector<User> &users, int n_tests,
+                 MakeTable make_table, InsertOne insert_one)
+{
+    double total_ms = 0;
+    size_t total_allocations = 0;
+    for (int t = 0; t < n_tests; t++)
+    {
+        vector<User> source = users;
+        auto *table = make_table();
+        size_t before = allocations();
+        auto start = chrono::high_resolution_clock::now();
+        for (User &user : source)
+            insert_one(*table, user);
+        auto end = chrono::high_resolution_clock::now();
+        total_allocations += allocations() - before;
+        total_ms += chrono::duration<double, milli>(end - start).count();
+        delete table;
+    }
+    file_out << name << "," << method << "," << users.size() << "," << total_ms / n_tests << ",";
+    if (counting_allocations())
+        file_out << (double)total_allocations / n_tests << "," << (double)total_allocations / n_tests / users.size();
+    else
+        file_out << "-,-";
+    file_out << endl;
+}
+
+/**
+ * @brief Compara las formas de insertar en las tablas que son dueñas de sus usuarios: copiar (insert(key, User *)),
+ * mover (insert(User &&)) y construir en la tabla (emplace()). En el archivo csv se guarda: tabla, método,
+ * número de usuarios, tiempo(ms), reservas de memoria y reservas por usuario (solo si se compiló con -DCOUNT_ALLOCATIONS).
+ *
+ * @param n_tests: cantidad de veces que se llena cada tabla.
+ * @param users: usuarios a insertar.
+ * @param table_size: tamaño de las tablas.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void emplace_test(int n_tests, vector<User> &users, int table_size, string file_name)
+{
+    if (!counting_allocations())
+        cout << "Compilar con -DCOUNT_ALLOCATIONS para contar las reservas de memoria." << endl;
+
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Método,Número de usuarios,Tiempo(ms),Reservas de memoria,Reservas por usuario" << endl;
+
+    auto id_table = [&]()
+    { return new CloseHashTableUserId(table_size, linear_probing); };
+    auto name_table = [&]()
+    { return new CloseHashTableUserName(table_size, linear_probing); };
+    auto index = [&]()
+    { return new UserIndex(table_size); };
+
+    emplace_row(file_out, "lineal probing by userid", "copia", users, n_tests, id_table,
+                [](CloseHashTableUserId &table, User &user) { table.insert(user.userId, &user); });
+    emplace_row(file_out, "lineal probing by userid", "move", users, n_tests, id_table,
+                [](CloseHashTableUserId &table, User &user) { table.insert(move(user)); });
+    emplace_row(file_out, "lineal probing by userid", "emplace", users, n_tests, id_table,
+                [](CloseHashTableUserId &table, User &user)
+                { table.emplace(move(user.university), user.userId, move(user.userName), user.numberTweets,
+                                user.friendsCount, user.followersCount, move(user.createdAt)); });
+
+    emplace_row(file_out, "lineal probing by username", "copia", users, n_tests, name_table,
+                [](CloseHashTableUserName &table, User &user) { table.insert(user.userName, &user); });
+    emplace_row(file_out, "lineal probing by username", "move", users, n_tests, name_table,
+                [](CloseHashTableUserName &table, User &user) { table.insert(move(user)); });
+    emplace_row(file_out, "lineal probing by username", "emplace", users, n_tests, name_table,
+                [](CloseHashTableUserName &table, User &user)
+                { table.emplace(move(user.university), user.userId, move(user.userName), user.numberTweets,
+                                user.friendsCount, user.followersCount, move(user.createdAt)); });
+
+    emplace_row(file_out, "user index", "copia", users, n_tests, index,
+                [](UserIndex &table, User &user) { table.insert(user); });
+    emplace_row(file_out, "user index", "move", users, n_tests, index,
+                [](UserIndex &table, User &user) { table.insert(move(user)); });
+    emplace_row(file_out, "user index", "emplace", users, n_tests, index,
+                [](UserIndex &table, User &user)
+                { table.emplace(move(user.university), user.userId, move(user.userName), user.numberTweets,
+                                user.friendsCount, user.followersCount, move(user.createdAt)); });
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//-----------------------TESTS DE INDICE DE PREFIJOS--------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Compara PrefixIndex contra CloseHashTableUserName (lineal probing) en busquedas exactas, y contra recorrer
+ * todos los usuarios en consultas por prefijo. En el archivo csv se guarda: estructura, consulta, número de usuarios,
+ * largo del prefijo, tiempo por consulta(ns), memoria sin contar los usuarios(bytes).
+ *
+ * @param users: usuarios a indexar.
+ * @param missing: usuarios que no estan en el indice, para las busquedas inexistentes.
+ * @param n_queries: cantidad de consultas por prefijo de cada largo.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void prefix_index_test(vector<User> &users, vector<User> &missing, int n_queries, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Estructura,Consulta,Número de usuarios,Largo del prefijo,Tiempo por consulta(ns),Memoria(bytes)" << endl;
+    size_t n = users.size();
+
+    auto start = chrono::high_resolution_clock::now();
+    PrefixIndex index(users);
+    auto end = chrono::high_resolution_clock::now();
+    size_t index_memory = index.get_memory_usage();
+    file_out << "indice de prefijos,construccion," << n << ",0,"
+             << chrono::duration<double, nano>(end - start).count() << "," << index_memory << endl;
+
+    CloseHashTableUserName table(next_prime(n / 0.75), linear_probing);
+    table.bulk_load(users);
+    // la tabla guarda copias de los usuarios, se descuentan con el mismo tamaño promedio que usa get_memory_usage()
+    size_t table_memory = table.get_memory_usage() - n * 70;
+
+    file_out << "indice de prefijos,busqueda existente," << n << ",0,"
+             << average_search_ns([&](const User &u) { return index.search(u.userName) != nullptr; }, users, 5)
+             << "," << index_memory << endl;
+    file_out << "indice de prefijos,busqueda inexistente," << n << ",0,"
+             << average_search_ns([&](const User &u) { return index.search(u.userName) != nullptr; }, missing, 5)
+             << "," << index_memory << endl;
+    file_out << "lineal probing by username,busqueda existente," << n << ",0,"
+             << average_search_ns([&](const User &u) { return table.search(u.userName) != nullptr; }, users, 5)
+             << "," << table_memory << endl;
+    file_out << "lineal probing by username,busqueda inexistente," << n << ",0,"
+             << average_search_ns([&](const User &u) { return table.search(u.userName) != nullptr; }, missing, 5)
+             << "," << table_memory << endl;
+
+    // los prefijos se sacan de nombres que existen, así todas las consultas tienen resultados
+    mt19937_64 rng(5);
+    // los recorridos son O(n), por lo que se hacen menos consultas
+    int n_scans = max(1, n_queries / 100);
+    volatile size_t sink = 0;
+    for (size_t length : {1, 2, 3, 5})
+    {
+        vector<string> prefixes(n_queries);
+        for (string &prefix : prefixes)
+        {
+            prefix = users[rng() % n].userName.substr(0, length);
+        }
+
+        start = chrono::high_resolution_clock::now();
+        for (const string &prefix : prefixes)
+        {
+            for (const User *user : index.prefix(prefix, 10))
+                sink += user->followersCount;
+        }
+        end = chrono::high_resolution_clock::now();
+        file_out << "indice de prefijos,primeros 10 con prefijo," << n << "," << length << ","
+                 << chrono::duration<double, nano>(end - start).count() / n_queries << "," << index_memory << endl;
+
+        start = chrono::high_resolution_clock::now();
+        for (const string &prefix : prefixes)
+        {
+            sink += index.count_prefix(prefix);
+        }
+        end = chrono::high_resolution_clock::now();
+        file_out << "indice de prefijos,cantidad con prefijo," << n << "," << length << ","
+                 << chrono::duration<double, nano>(end - start).count() / n_queries << "," << index_memory << endl;
+
+        start = chrono::high_resolution_clock::now();
+        for (int q = 0; q < n_scans; q++)
+        {
+            for (User &user : users)
+            {
+                if (user.userName.compare(0, prefixes[q].size(), prefixes[q]) == 0)
+                    sink += user.followersCount;
+            }
+        }
+        end = chrono::high_resolution_clock::now();
+        file_out << "recorrido,todos con prefijo," << n << "," << length << ","
+                 << chrono::duration<double, nano>(end - start).count() / n_scans << ",0" << endl;
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//----------------------TESTS DE POLITICAS DE PRUEBA--------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe una fila del test de políticas para ProbingHashTable<unsigned long long, Policy>: costo de calcular
+ * un intento, intentos promedio por busqueda existente, busquedas existentes e inexistentes, y la proporción de la
+ * tabla que visita la secuencia de prueba antes de repetirse (cobertura).
+ */
+template <typename Policy>
+void probe_policy_row(ofstream &file_out, const string &name, double load_factor, vector<User> &users,
+                      vector<User> &missing, const vector<unsigned long long> &hashes)
+{
+    size_t n = users.size();
+    ProbingHashTable<unsigned long long, Policy> table(n / load_factor, users);
+    for (size_t i = 0; i < n; i++)
+        table.insert(users[i].userId, i);
+    const Policy &policy = table.policy;
+
+    // costo de calcular el primer intento y los 7 siguientes, sin tocar la tabla
+    volatile size_t sink = 0;
+    auto start = chrono::high_resolution_clock::now();
+    for (unsigned long long hash : hashes)
+    {
+        size_t pos = policy.home(hash);
+        size_t sum = pos;
+        for (int i = 1; i < 8; i++)
+        {
+            pos = policy.next(pos, i);
+            sum += pos;
+        }
+        sink += sum;
+    }
+    auto end = chrono::high_resolution_clock::now();
+    double probe_ns = chrono::duration<double, nano>(end - start).count() / (hashes.size() * 8);
+
+    vector<char> visited(policy.capacity, 0);
+    size_t distinct = 0, pos = policy.home(0);
+    for (size_t i = 1; i <= policy.capacity; i++)
+    {
+        distinct += !visited[pos];
+        visited[pos] = 1;
+        pos = policy.next(pos, i);
+    }
+
+    file_out << name << "," << n << "," << (double)n / policy.capacity << "," << probe_ns << ","
+             << (double)(table.getCollision() + n) / n << ","
+             << average_search_ns([&](const User &u) { return table.search(u.userId) != nullptr; }, users, 5) << ","
+             << average_search_ns([&](const User &u) { return table.search(u.userId) != nullptr; }, missing, 5) << ","
+             << (double)distinct / policy.capacity << endl;
+}
+
+/**
+ * @brief Escribe la fila de StaticPrimePolicy para los usuarios reales, la capacidad se calcula en tiempo de
+ * compilación a partir del factor de carga en porcentaje.
+ */
+template <int LOAD_PERCENT>
+void static_probe_policy_row(ofstream &file_out, vector<User> &users, vector<User> &missing,
+                             const vector<unsigned long long> &hashes)
+{
+    const unsigned long long REAL_USERS = 19908;
+    probe_policy_row<StaticPrimePolicy<next_prime(REAL_USERS * 100 / LOAD_PERCENT)>>(
+        file_out, "primo fijo en compilacion", LOAD_PERCENT / 100.0, users, missing, hashes);
+}
+
+/**
+ * @brief Compara las políticas de capacidad y prueba de ProbingHashTable (por userId) entre sí y contra las
+ * funciones de hash_functions.h (lineal probing con CloseHashTableUserId). En el archivo csv se guarda: política,
+ * número de usuarios, factor de carga real, costo por intento(ns), intentos por busqueda existente, busqueda
+ * existente(ns), busqueda inexistente(ns), cobertura de la secuencia de prueba.
+ *
+ * @param users: usuarios a guardar.
+ * @param missing: usuarios que no estan en las tablas.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ *
+ * @note StaticPrimePolicy solo se prueba con los 19908 usuarios reales, ya que su capacidad es una constante.
+ */
+void probe_policy_test(vector<User> &users, vector<User> &missing, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Política,Número de usuarios,Factor de carga,Costo por intento(ns),Intentos por busqueda existente,"
+                "Busqueda existente(ns),Busqueda inexistente(ns),Cobertura"
+             << endl;
+    size_t n = users.size();
+
+    mt19937_64 rng(11);
+    vector<unsigned long long> hashes(1000000);
+    for (unsigned long long &hash : hashes)
+        hash = mix64(rng());
+
+    for (double load_factor : {0.5, 0.75, 0.9})
+    {
+        int table_size = next_prime(n / load_factor);
+
+        // referencia: las funciones por puntero de hash_functions.h, que calculan cada intento con % n
+        volatile size_t sink = 0;
+        auto start = chrono::high_resolution_clock::now();
+        for (unsigned long long hash : hashes)
+        {
+            size_t sum = 0;
+            for (int i = 0; i < 8; i++)
+                sum += linear_probing(hash, table_size, i);
+            sink += sum;
+        }
+        auto end = chrono::high_resolution_clock::now();
+        double probe_ns = chrono::duration<double, nano>(end - start).count() / (hashes.size() * 8);
+
+        vector<char> visited(table_size, 0);
+        size_t distinct = 0;
+        for (int i = 0; i < table_size; i++)
+        {
+            int pos = quadratic_probing(0ULL, table_size, i);
+            distinct += !visited[pos];
+            visited[pos] = 1;
+        }
+
+        CloseHashTableUserId table(table_size, linear_probing);
+        for (User &u : users)
+            table.insert(u.userId, &u);
+        file_out << "lineal probing (hash_functions.h)," << n << "," << (double)n / table_size << "," << probe_ns << ","
+                 << (double)(table.getCollision() + n) / n << ","
+                 << average_search_ns([&](const User &u) { return table.search(u.userId) != nullptr; }, users, 5) << ","
+                 << average_search_ns([&](const User &u) { return table.search(u.userId) != nullptr; }, missing, 5)
+                 << ",1" << endl;
+        file_out << "quadratic probing (hash_functions.h)," << n << "," << (double)n / table_size << ",,,,,"
+                 << (double)distinct / table_size << endl;
+
+        probe_policy_row<ModuloPolicy>(file_out, "modulo", load_factor, users, missing, hashes);
+        probe_policy_row<PowerOfTwoPolicy>(file_out, "potencia de 2 triangular", load_factor, users, missing, hashes);
+        probe_policy_row<FastModPolicy>(file_out, "fastmod", load_factor, users, missing, hashes);
+        probe_policy_row<FastRangePolicy>(file_out, "fastrange", load_factor, users, missing, hashes);
+    }
+
+    if (n == 19908)
+    {
+        static_probe_policy_row<50>(file_out, users, missing, hashes);
+        static_probe_policy_row<75>(file_out, users, missing, hashes);
+        static_probe_policy_row<90>(file_out, users, missing, hashes);
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//-----------------------TESTS DEL WRITE-AHEAD LOG----------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Mide cuántas operaciones por segundo se sostienen registrando cada una en el WriteAheadLog antes de
+ * aplicarla a un UserIndex, para varios tamaños de grupo y plazos de commit, y después reconstruye el indice
+ * con recover() y revisa que quede igual.
+ * Las operaciones son insertar todos los usuarios, actualizar la mitad y eliminar un cuarto; con grupos chicos
+ * se hacen solo las primeras (a lo más unos 500 fsync por configuración) para que el test no tarde minutos.
+ * A la mitad de las operaciones se hace un checkpoint(), así recover() lee el snapshot y luego el log. También
+ * se reconstruye como si el programa se hubiera caído justo antes de vaciar el log en el checkpoint (se deja
+ * el log de antes del checkpoint delante del final), para revisar que se salten los registros que ya están en
+ * el snapshot.
+ * En el archivo csv se guarda: grupo, plazo(us), operaciones, tiempo(ms), operaciones por segundo, fsyncs,
+ * tiempo de replay(ms), si el indice reconstruido es igual y si es igual con el log sin vaciar.
+ *
+ * @param users: usuarios a insertar.
+ * @param directory: carpeta donde se escriben el log y el snapshot (se borran al terminar cada configuración).
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void wal_test(vector<User> &users, string directory, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Grupo,Plazo(us),Operaciones,Tiempo(ms),Operaciones por segundo,Fsyncs,Replay(ms),Replay correcto,"
+                "Replay con log sin vaciar correcto"
+             << endl;
+    size_t n = users.size();
+    int table_size = next_prime(n / 0.75);
+    string log_path = directory + "/wal_test.log";
+    string snapshot_path = directory + "/wal_test.snapshot";
+
+    // operaciones: (tipo, usuario), las actualizaciones cambian numberTweets
+    vector<pair<WalOp, User>> operations;
+    operations.reserve(n + n / 2 + n / 4);
+    for (User &user : users)
+        operations.push_back({WAL_INSERT, user});
+    for (size_t i = 0; i < n; i += 2)
+    {
+        User updated = users[i];
+        updated.numberTweets++;
+        operations.push_back({WAL_UPDATE, updated});
+    }
+    for (size_t i = 1; i < n; i += 4)
+        operations.push_back({WAL_REMOVE, users[i]});
+
+    vector<pair<int, long long>> configs = {{1, 0}, {8, 0}, {64, 0}, {512, 0}, {1000000, 1000}, {1000000, 10000}};
+    for (auto &config : configs)
+    {
+        int group = config.first;
+        long long delay_us = config.second;
+        size_t n_operations = delay_us > 0 ? operations.size() : min(operations.size(), (size_t)group * 500);
+        remove(log_path.c_str());
+        remove(snapshot_path.c_str());
+
+        UserIndex index(table_size, linear_probing, linear_probing);
+        double elapsed_ms, replay_ms;
+        size_t fsyncs;
+        bool checkpointed = false;
+        string log_before_checkpoint; ///< Registros que el checkpoint dejó en el snapshot.
+        {
+            WriteAheadLog wal(log_path, snapshot_path, group, delay_us);
+            auto start = chrono::high_resolution_clock::now();
+            for (size_t i = 0; i < n_operations; i++)
+            {
+                WalRecord record{0, operations[i].first, operations[i].second};
+                if (record.op == WAL_INSERT)
+                    wal.log_insert(record.user);
+                else if (record.op == WAL_UPDATE)
+                    wal.log_update(record.user);
+                else
+                    wal.log_remove(record.user);
+                apply_record(index, move(record));
+                if (i == n_operations / 2)
+                {
+                    wal.commit();
+                    ifstream log_file(log_path, ios::binary);
+                    log_before_checkpoint.assign(istreambuf_iterator<char>(log_file), istreambuf_iterator<char>());
+                    checkpointed = wal.checkpoint(index.live_users());
+                }
+            }
+            wal.commit();
+            auto end = chrono::high_resolution_clock::now();
+            elapsed_ms = chrono::duration<double, milli>(end - start).count();
+            fsyncs = wal.fsyncs;
+        }
+
+        UserIndex recovered(table_size, linear_probing, linear_probing);
+        {
+            WriteAheadLog wal(log_path, snapshot_path);
+            auto start = chrono::high_resolution_clock::now();
+            wal.recover([&](WalRecord &&record) { apply_record(recovered, move(record)); });
+            auto end = chrono::high_resolution_clock::now();
+            replay_ms = chrono::duration<double, milli>(end - start).count();
+        }
+
+        auto same_as_index = [&](UserIndex &other)
+        {
+            bool same = other.size == index.size;
+            for (const User *user : index.live_users())
+            {
+                User *found = other.search_by_id(user->userId);
+                same = same && found && found->numberTweets == user->numberTweets && found->userName == user->userName;
+            }
+            return same;
+        };
+        bool same = checkpointed && same_as_index(recovered);
+
+        // caída entre el rename del snapshot y vaciar el log: el log conserva lo de antes del checkpoint
+        {
+            ifstream log_file(log_path, ios::binary);
+            string after_checkpoint((istreambuf_iterator<char>(log_file)), istreambuf_iterator<char>());
+            log_file.close();
+            ofstream crashed_log(log_path, ios::binary | ios::trunc);
+            crashed_log << log_before_checkpoint << after_checkpoint;
+        }
+        UserIndex recovered_crash(table_size, linear_probing, linear_probing);
+        {
+            WriteAheadLog wal(log_path, snapshot_path);
+            wal.recover([&](WalRecord &&record) { apply_record(recovered_crash, move(record)); });
+        }
+        bool same_crash = checkpointed && same_as_index(recovered_crash);
+
+        file_out << group << "," << delay_us << "," << n_operations << "," << elapsed_ms << ","
+                 << n_operations / (elapsed_ms / 1000) << "," << fsyncs << "," << replay_ms << "," << same << ","
+                 << same_crash << endl;
+        remove(log_path.c_str());
+        remove(snapshot_path.c_str());
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//-------------------------TESTS DE PÁGINAS GRANDES---------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe una fila de huge_pages_test: construye la tabla con build(), busca cada clave de ids y mide
+ * tiempo y fallos de la dTLB por busqueda.
+ * @param resident_before Bytes en páginas grandes antes de construir la tabla (para ver cuántos agregó).
+ */
+template <typename Build, typename Search>
+void huge_pages_row(ofstream &file_out, const string &name, bool huge, size_t n, const vector<unsigned long long> &ids,
+                    Build build, Search search)
+{
+    huge_pages_enabled = huge;
+    size_t resident_before = huge_page_resident_bytes();
+    size_t mapped_before = huge_page_mapped_bytes, hugetlb_before = hugetlb_allocations;
+    auto table = build();
+    huge_pages_enabled = false;
+    size_t resident = huge_page_resident_bytes();
+    size_t mapped = huge_page_mapped_bytes - mapped_before, hugetlb = hugetlb_allocations - hugetlb_before;
+
+    PerfCounter dtlb = PerfCounter::dtlb_read_misses();
+    volatile size_t sink = 0;
+    size_t found = 0;
+    dtlb.start();
+    auto start = chrono::high_resolution_clock::now();
+    for (unsigned long long id : ids)
+        found += search(*table, id);
+    auto end = chrono::high_resolution_clock::now();
+    long long misses = dtlb.stop();
+    sink += found;
+
+    file_out << name << "," << (huge ? "2 MB" : "4 KB") << "," << n << ","
+             << chrono::duration<double, nano>(end - start).count() / ids.size() << ",";
+    if (misses >= 0)
+        file_out << (double)misses / ids.size();
+    file_out << "," << (resident > resident_before ? (resident - resident_before) / (1 << 20) : 0) << ","
+             << mapped / (1 << 20) << "," << hugetlb << "," << (double)found / ids.size() << endl;
+}
+
+/**
+ * @brief Compara las busquedas con los arreglos de las tablas en páginas normales (4 KB) contra páginas grandes
+ * (2 MB, ver huge_pages.h) para tablas de varios millones de espacios: latencia por busqueda, fallos de la dTLB
+ * por busqueda (si el sistema deja leer los contadores de hardware), MB que quedaron en páginas grandes, MB
+ * reservados con huge_page_allocate y cuántas de esas reservas obtuvieron páginas grandes explícitas (MAP_HUGETLB).
+ * Las claves se buscan en orden aleatorio, así cada busqueda cae en una página distinta.
+ * En el archivo csv se guarda: estructura, página, número de usuarios, busqueda(ns), fallos dTLB por busqueda,
+ * MB en páginas grandes, MB reservados, reservas MAP_HUGETLB, proporción encontrada.
+ *
+ * @param sizes: cantidades de usuarios generados a probar.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void huge_pages_test(const vector<size_t> &sizes, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Estructura,Página,Número de usuarios,Busqueda(ns),Fallos dTLB por busqueda,MB en páginas grandes,"
+                "MB reservados,Reservas MAP_HUGETLB,Encontrados"
+             << endl;
+    string mode = transparent_huge_pages_mode();
+    cout << "Páginas grandes transparentes: " << (mode.empty() ? "no disponibles" : mode)
+         << ", contadores de hardware: " << (PerfCounter::dtlb_read_misses().available() ? "si" : "no") << endl;
+
+    for (size_t n : sizes)
+    {
+        vector<User> users = generate_users(n);
+        vector<unsigned long long> ids(min(n, (size_t)2000000));
+        mt19937_64 rng(5);
+        for (unsigned long long &id : ids)
+            id = users[rng() % n].userId;
+        int table_size = next_prime(n / 0.75);
+
+        for (bool huge : {false, true})
+        {
+            huge_pages_row(file_out, "CloseHashTableUserId", huge, n, ids,
+                           [&]()
+                           {
+                               unique_ptr<CloseHashTableUserId> table(new CloseHashTableUserId(table_size, linear_probing));
+                               for (User &user : users)
+                                   table->insert(user.userId, &user);
+                               return table;
+                           },
+                           [](CloseHashTableUserId &table, unsigned long long id) { return table.search(id) != nullptr; });
+            huge_pages_row(file_out, "UserIndex", huge, n, ids,
+                           [&]()
+                           {
+                               unique_ptr<UserIndex> index(new UserIndex(table_size, linear_probing, linear_probing));
+                               for (User &user : users)
+                                   index->insert(user);
+                               return index;
+                           },
+                           [](UserIndex &index, unsigned long long id) { return index.search_by_id(id) != nullptr; });
+            huge_pages_row(file_out, "NodePoolHashTable", huge, n, ids,
+                           [&]()
+                           {
+                               auto table = make_unique<NodePoolHashTableUserId>(table_size, users);
+                               table->bulk_load(1);
+                               return table;
+                           },
+                           [](NodePoolHashTableUserId &table, unsigned long long id)
+                           { return table.search(id) != nullptr; });
+            huge_pages_row(file_out, "ProbingHashTable (potencia de 2)", huge, n, ids,
+                           [&]()
+                           {
+                               auto table = make_unique<ProbingHashTable<unsigned long long, PowerOfTwoPolicy>>(table_size, users);
+                               for (size_t i = 0; i < n; i++)
+                                   table->insert(users[i].userId, i);
+                               return table;
+                           },
+                           [](ProbingHashTable<unsigned long long, PowerOfTwoPolicy> &table, unsigned long long id)
+                           { return table.search(id) != nullptr; });
+        }
+    }
+    file_out.close();
+}
+
+//----------------------------------------------------------------------//
+//------------------------TESTS DEL COSTO DEL TRAZADO-------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe una fila de trace_test: construye la tabla n_tests veces y guarda el menor tiempo por operación
+ * de insertar todos los usuarios, buscar todos (existentes e inexistentes) y eliminar la mitad.
+ * @param insert, search, remove: reciben la tabla y el usuario.
+ */
+template <typename MakeTable, typename Insert, typename Search, typename Remove>
+void trace_row(ofstream &file_out, const string &name, const string &sampling, vector<User> &users,
+               vector<User> &missing, int n_tests, MakeTable make_table, Insert insert, Search search, Remove remove)
+{
+    double best[3] = {1e18, 1e18, 1e18};
+    volatile size_t sink = 0;
+    for (int t = 0; t < n_tests; t++)
+    {
+        auto table = make_table();
+        auto start = chrono::high_resolution_clock::now();
+        for (User &user : users)
+            insert(*table, user);
+        auto after_insert = chrono::high_resolution_clock::now();
+        size_t found = 0;
+        for (User &user : users)
+            found += search(*table, user);
+        for (User &user : missing)
+            found += search(*table, user);
+        auto after_search = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < users.size(); i += 2)
+            remove(*table, users[i]);
+        auto end = chrono::high_resolution_clock::now();
+        sink += found;
+
+        best[0] = min(best[0], chrono::duration<double, nano>(after_insert - start).count() / users.size());
+        best[1] = min(best[1], chrono::duration<double, nano>(after_search - after_insert).count() /
+                                   (users.size() + missing.size()));
+        best[2] = min(best[2], chrono::duration<double, nano>(end - after_search).count() / ((users.size() + 1) / 2));
+    }
+    file_out << name << "," << (tracing_enabled() ? "si" : "no") << "," << sampling << "," << users.size() << ","
+             << best[0] << "," << best[1] << "," << best[2] << endl;
+}
+
+/**
+ * @brief Mide el costo de insert, search y remove con el trazado de trace.h. Para ver el costo hay que correrlo
+ * con el programa compilado sin trazado y con -DENABLE_TRACING y comparar las filas: sin trazado los macros no
+ * generan código, con trazado se prueba sin muestrear ninguna operación, muestreando 1 de cada 1024 y 1 de cada 64.
+ * Al final (con trazado) guarda los eventos de la última corrida en trace_file, para abrirlo en chrome://tracing
+ * o en ui.perfetto.dev.
+ * En el archivo csv se guarda: estructura, trazado compilado, muestreo, número de usuarios, insert(ns),
+ * search(ns), remove(ns).
+ *
+ * @param users: usuarios a insertar, buscar y eliminar.
+ * @param missing: usuarios que no están en las tablas, también se buscan.
+ * @param n_tests: veces que se construye cada tabla (se guarda el menor tiempo).
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ * @param trace_file: archivo JSON con los eventos.
+ */
+void trace_test(vector<User> &users, vector<User> &missing, int n_tests, string file_name, string trace_file)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Estructura,Trazado compilado,Muestreo,Número de usuarios,Insert(ns),Search(ns),Remove(ns)" << endl;
+    int table_size = next_prime(users.size() / 0.75);
+
+    vector<uint32_t> rates = {0};
+    if (tracing_enabled())
+        rates = {0, 1024, 64};
+    for (uint32_t rate : rates)
+    {
+        trace_sample_every = rate;
+        trace_clear();
+        string sampling = !tracing_enabled() ? "-" : rate == 0 ? "ninguna" : "1/" + to_string(rate);
+
+        trace_row(file_out, "CloseHashTableUserId", sampling, users, missing, n_tests,
+                  [&]() { return unique_ptr<CloseHashTableUserId>(new CloseHashTableUserId(table_size, linear_probing)); },
+                  [](CloseHashTableUserId &t, User &u) { t.insert(u.userId, &u); },
+                  [](CloseHashTableUserId &t, User &u) { return t.search(u.userId) != nullptr; },
+                  [](CloseHashTableUserId &t, User &u) { t.remove(u.userId); });
+        trace_row(file_out, "CloseHashTableUserName", sampling, users, missing, n_tests,
+                  [&]() { return unique_ptr<CloseHashTableUserName>(new CloseHashTableUserName(table_size, linear_probing)); },
+                  [](CloseHashTableUserName &t, User &u) { t.insert(u.userName, &u); },
+                  [](CloseHashTableUserName &t, User &u) { return t.search(u.userName) != nullptr; },
+                  [](CloseHashTableUserName &t, User &u) { t.remove(u.userName); });
+        trace_row(file_out, "OpenHashTableUserId", sampling, users, missing, n_tests,
+                  [&]() { return unique_ptr<OpenHashTableUserId>(new OpenHashTableUserId(table_size)); },
+                  [](OpenHashTableUserId &t, User &u) { t.insert(u.userId, &u); },
+                  [](OpenHashTableUserId &t, User &u) { return t.search(u.userId) != nullptr; },
+                  [](OpenHashTableUserId &t, User &u) { t.remove(u.userId); });
+        trace_row(file_out, "NodePoolHashTableUserId", sampling, users, missing, n_tests,
+                  [&]() { return unique_ptr<NodePoolHashTableUserId>(new NodePoolHashTableUserId(table_size, users)); },
+                  [&](NodePoolHashTableUserId &t, User &u) { t.insert(u.userId, &u - users.data()); },
+                  [](NodePoolHashTableUserId &t, User &u) { return t.search(u.userId) != nullptr; },
+                  [](NodePoolHashTableUserId &t, User &u) { t.remove(u.userId); });
+        trace_row(file_out, "BucketHashTableUserName", sampling, users, missing, n_tests,
+                  [&]() { return unique_ptr<BucketHashTableUserName>(new BucketHashTableUserName(table_size, users)); },
+                  [&](BucketHashTableUserName &t, User &u) { t.insert(u.userName, &u - users.data()); },
+                  [](BucketHashTableUserName &t, User &u) { return t.search(u.userName) != nullptr; },
+                  [](BucketHashTableUserName &t, User &u) { t.remove(u.userName); });
+        trace_row(file_out, "UserIndex", sampling, users, missing, n_tests,
+                  [&]() { return unique_ptr<UserIndex>(new UserIndex(table_size, linear_probing, linear_probing)); },
+                  [](UserIndex &t, User &u) { t.insert(u); },
+                  [](UserIndex &t, User &u) { return t.search_by_id(u.userId) != nullptr; },
+                  [](UserIndex &t, User &u) { t.remove_by_id(u.userId); });
+    }
+
+    if (tracing_enabled())
+    {
+        size_t events = trace_export_chrome(trace_file);
+        cout << "Eventos de trazado guardados en " << trace_file << ": " << events << endl;
+    }
+    file_out.close();
+}
+
+
+//----------------------------------------------------------------------//
+//---------------------TESTS DE LAS FUNCIONES DE HASH-------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief userName de cada usuario repetido o cortado hasta tener length caracteres, para medir las funciones de
+ * hash de strings con un largo fijo.
+ */
+vector<string> names_of_length(const vector<User> &users, size_t length)
+{
+    vector<string> names;
+    names.reserve(users.size());
+    for (const User &user : users)
+    {
+        string name = user.userName.empty() ? "_" : user.userName;
+        while (name.size() < length)
+            name += user.userName.empty() ? "_" : user.userName;
+        names.push_back(name.substr(0, length));
+    }
+    return names;
+}
+
+/**
+ * @brief Escribe una fila de hash_throughput_test: aplica hasher a todas las claves hasta hashear al menos 2 * 10^6
+ * claves y guarda el menor tiempo de n_tests repeticiones.
+ * @param bytes: bytes de todas las claves juntas (8 por userId, el largo de cada userName).
+ */
+template <typename Key, typename Hasher>
+void hash_throughput_row(ofstream &file_out, const string &name, const string &input, const vector<Key> &keys,
+                         size_t bytes, Hasher hasher, int n_tests)
+{
+    size_t rounds = max<size_t>(1, 2000000 / keys.size());
+    double best = 1e18;
+    volatile unsigned long long sink = 0;
+    for (int t = 0; t < n_tests; t++)
+    {
+        unsigned long long mixed = 0;
+        auto start = chrono::high_resolution_clock::now();
+        for (size_t r = 0; r < rounds; r++)
+            for (const Key &key : keys)
+                mixed ^= hasher(key);
+        auto end = chrono::high_resolution_clock::now();
+        sink ^= mixed;
+        best = min(best, chrono::duration<double>(end - start).count());
+    }
+    double hashed = (double)rounds * keys.size();
+    file_out << name << "," << input << "," << keys.size() << "," << (double)bytes / keys.size() << ","
+             << best * 1e9 / hashed << "," << hashed / best << "," << rounds * bytes / best / 1e9 << endl;
+}
+
+/**
+ * @brief Mide la velocidad de las funciones de hash de hash_functions.h: h1, h2 y mix64 con userId, y hash_string,
+ * hash_string64 y hash_string_words con userName reales y con nombres de largo fijo (8 a 128 caracteres).
+ * En el archivo csv se guarda: función, entrada, claves, bytes por clave, ns por clave, claves por segundo y GB/s.
+ *
+ * @param real_users: usuarios del dataset real.
+ * @param fake_users: usuarios del dataset falso.
+ * @param n_tests: repeticiones de cada medición (se guarda la más rápida).
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void hash_throughput_test(vector<User> &real_users, vector<User> &fake_users, int n_tests, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Función,Entrada,Claves,Bytes por clave,ns por clave,Claves por segundo,GB/s" << endl;
+
+    vector<pair<string, vector<User> *>> datasets = {{"reales", &real_users}, {"falsos", &fake_users}};
+    for (auto &dataset : datasets)
+    {
+        vector<unsigned long long> ids;
+        for (User &user : *dataset.second)
+            ids.push_back(user.userId);
+        string input = "userId " + dataset.first;
+        size_t bytes = ids.size() * sizeof(unsigned long long);
+        hash_throughput_row(file_out, "h1", input, ids, bytes, [](unsigned long long k) { return h1(k); }, n_tests);
+        hash_throughput_row(file_out, "h2", input, ids, bytes, [](unsigned long long k) { return h2(k); }, n_tests);
+        hash_throughput_row(file_out, "mix64", input, ids, bytes, [](unsigned long long k) { return mix64(k); }, n_tests);
+    }
+
+    vector<pair<string, vector<string>>> name_inputs;
+    for (auto &dataset : datasets)
+    {
+        vector<string> names;
+        for (User &user : *dataset.second)
+            names.push_back(user.userName);
+        name_inputs.push_back({"userName " + dataset.first, names});
+    }
+    for (size_t length : {8, 16, 32, 64, 128})
+        name_inputs.push_back({"userName de " + to_string(length), names_of_length(real_users, length)});
+
+    for (auto &input : name_inputs)
+    {
+        size_t bytes = 0;
+        for (const string &name : input.second)
+            bytes += name.size();
+        hash_throughput_row(file_out, "hash_string", input.first, input.second, bytes,
+                            [](const string &k) { return hash_string(k); }, n_tests);
+        hash_throughput_row(file_out, "hash_string64", input.first, input.second, bytes,
+                            [](const string &k) { return hash_string64(k); }, n_tests);
+        hash_throughput_row(file_out, "hash_string_words", input.first, input.second, bytes,
+                            [](const string &k) { return hash_string_words(k); }, n_tests);
+    }
+    file_out.close();
+}
+
+/**
+ * @brief Escribe las filas de hash_quality_test de una función y un dataset: avalanche con las primeras claves de
+ * avalanche_inputs, y uniformidad y largo de las pruebas con keys repartidas en una tabla de tamaño primo y en
+ * una de potencia de 2, ambas con factor de carga cercano a 0.75.
+ */
+template <typename Key, typename Hasher>
+void hash_quality_rows(ofstream &file_out, const string &name, const string &dataset, const vector<Key> &keys,
+                       const vector<Key> &avalanche_inputs, Hasher hasher, int output_bits)
+{
+    AvalancheResult avalanche = avalanche_bias(avalanche_inputs, hasher, output_bits);
+    vector<unsigned long long> hashes;
+    hashes.reserve(keys.size());
+    for (const Key &key : keys)
+        hashes.push_back(hasher(key));
+
+    size_t n = keys.size();
+    size_t prime = next_prime(n / 0.75);
+    size_t power = 1;
+    while (power < n / 0.75)
+        power *= 2;
+    for (bool mask : {false, true})
+    {
+        size_t m = mask ? power : prime;
+        double load_factor = (double)n / m;
+        vector<size_t> homes = home_slots(hashes, m, mask);
+        ProbeResult probes = simulate_linear_probing(homes, m);
+        ProbeResult expected = expected_linear_probing(n, m);
+        file_out << name << "," << dataset << "," << (mask ? "potencia de 2" : "primo") << "," << n << "," << m << ","
+                 << load_factor << "," << avalanche.mean_bias << "," << avalanche.worst_bias << ","
+                 << chi_square_ratio(homes, m) << "," << probes.average << "," << expected_linear_probes(load_factor)
+                 << "," << probes.longest << "," << expected.longest << "," << probes.cluster << ","
+                 << expected.cluster << endl;
+    }
+}
+
+/**
+ * @brief Calidad de las funciones de hash (ver hash_quality.h) con las claves de los datasets real y falso:
+ * sesgo de avalanche (promedio y peor par de bits), chi-cuadrado de la cantidad de claves por bucket, y largo
+ * promedio y máximo de las pruebas y cluster más largo de linear probing contra lo esperado con un hash aleatorio. Las tablas usan
+ * el módulo con un primo (como las tablas cerradas) y la máscara de una potencia de 2 (como ProbingHashTable).
+ * Para avalanche de userName se usan los nombres cortados o repetidos a 16 caracteres.
+ * En el archivo csv se guarda: función, datos, reducción, claves, espacios, factor de carga, avalanche promedio,
+ * avalanche peor, chi2/gl, intentos promedio, intentos promedio esperados, prueba más larga, prueba más larga
+ * esperada, cluster más largo y cluster más largo esperado.
+ *
+ * @param real_users: usuarios del dataset real.
+ * @param fake_users: usuarios del dataset falso.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void hash_quality_test(vector<User> &real_users, vector<User> &fake_users, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Función,Datos,Reducción,Claves,Espacios,Factor de carga,Avalanche promedio,Avalanche peor,Chi2/gl,"
+                "Intentos promedio,Intentos promedio esperados,Prueba más larga,Prueba más larga esperada,"
+                "Cluster más largo,Cluster más largo esperado"
+             << endl;
+    const size_t avalanche_keys = 2000;
+
+    vector<pair<string, vector<User> *>> datasets = {{"userId reales", &real_users}, {"userId falsos", &fake_users}};
+    for (auto &dataset : datasets)
+    {
+        vector<unsigned long long> ids;
+        for (User &user : *dataset.second)
+            ids.push_back(user.userId);
+        vector<unsigned long long> sample(ids.begin(), ids.begin() + min(avalanche_keys, ids.size()));
+        hash_quality_rows(file_out, "h1", dataset.first, ids, sample, [](unsigned long long k) { return h1(k); }, 32);
+        hash_quality_rows(file_out, "h2", dataset.first, ids, sample, [](unsigned long long k) { return h2(k); }, 32);
+        hash_quality_rows(file_out, "mix64", dataset.first, ids, sample, [](unsigned long long k) { return mix64(k); }, 64);
+    }
+
+    datasets = {{"userName reales", &real_users}, {"userName falsos", &fake_users}};
+    for (auto &dataset : datasets)
+    {
+        vector<string> names;
+        for (User &user : *dataset.second)
+            names.push_back(user.userName);
+        vector<User> first(dataset.second->begin(), dataset.second->begin() + min(avalanche_keys, names.size()));
+        vector<string> sample = names_of_length(first, 16);
+        hash_quality_rows(file_out, "hash_string", dataset.first, names, sample,
+                          [](const string &k) { return hash_string(k); }, 32);
+        hash_quality_rows(file_out, "hash_string64", dataset.first, names, sample,
+                          [](const string &k) { return hash_string64(k); }, 64);
+        hash_quality_rows(file_out, "hash_string_words", dataset.first, names, sample,
+                          [](const string &k) { return hash_string_words(k); }, 64);
+    }
+    file_out.close();
+}
+
+
+//----------------------------------------------------------------------//
+//-----------------------TESTS DE LA TABLA ADAPTATIVA-------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe una fila de adaptive_test: construye la tabla n_tests veces insertando todos los usuarios y
+ * buscando todos los usuarios y todos los inexistentes, y guarda el menor tiempo por operación.
+ * @param strategy: estrategia inicial (posición en ADAPTIVE_STRATEGIES).
+ * @param adaptive: si la tabla cambia de estrategia sola.
+ */
+void adaptive_row(ofstream &file_out, const string &name, const string &dataset, vector<User> &users,
+                  vector<User> &missing, int n_tests, size_t strategy, bool adaptive)
+{
+    int table_size = next_prime(users.size() / 0.75);
+    double best[3] = {1e18, 1e18, 1e18};
+    volatile size_t sink = 0;
+    double probes = 0;
+    string final_strategy;
+    int switches = 0;
+    for (int t = 0; t < n_tests; t++)
+    {
+        AdaptiveHashTableUserId table(table_size, users, strategy, adaptive);
+        auto start = chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < users.size(); i++)
+            table.insert(users[i].userId, i);
+        auto after_insert = chrono::high_resolution_clock::now();
+        size_t found = 0;
+        for (User &user : users)
+            found += table.search(user.userId) != nullptr;
+        auto after_search = chrono::high_resolution_clock::now();
+        for (User &user : missing)
+            found += table.search(user.userId) != nullptr;
+        auto end = chrono::high_resolution_clock::now();
+        sink += found;
+
+        best[0] = min(best[0], chrono::duration<double, nano>(after_insert - start).count() / users.size());
+        best[1] = min(best[1], chrono::duration<double, nano>(after_search - after_insert).count() / users.size());
+        best[2] = min(best[2], chrono::duration<double, nano>(end - after_search).count() / missing.size());
+        probes = table.average_probes();
+        final_strategy = table.strategy_name();
+        switches = table.switches;
+    }
+    file_out << name << "," << dataset << "," << users.size() << "," << best[0] << "," << best[1] << "," << best[2]
+             << "," << probes << "," << final_strategy << "," << switches << endl;
+}
+
+/**
+ * @brief Compara AdaptiveHashTableUserId (empieza con linear probing y cambia de estrategia si sus claves forman
+ * clusters) contra la misma tabla con cada estrategia fija, con factor de carga 0.75. Los datasets son los
+ * usuarios reales y falsos, usuarios generados con ids snowflake seguidos (adversario para linear probing con h1)
+ * y una deriva: primero la mitad de usuarios generados al azar y después la mitad con ids seguidos.
+ * En el archivo csv se guarda: tabla, datos, número de usuarios, insert(ns), search(ns), search inexistentes(ns),
+ * intentos por operación, estrategia final y cambios de estrategia.
+ *
+ * @param real_users: usuarios del dataset real.
+ * @param fake_users: usuarios del dataset falso.
+ * @param n: cantidad de usuarios generados para los datasets de ids seguidos y de deriva.
+ * @param n_tests: veces que se construye cada tabla (se guarda el menor tiempo).
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void adaptive_test(vector<User> &real_users, vector<User> &fake_users, size_t n, int n_tests, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Datos,Número de usuarios,Insert(ns),Search(ns),Search inexistentes(ns),Intentos por operación,"
+                "Estrategia final,Cambios"
+             << endl;
+
+    vector<User> sequential = generate_sequential_users(n);
+    vector<User> sequential_missing = generate_sequential_users(n / 10, 1);
+    vector<User> drift = generate_users(n / 2);
+    vector<User> drift_tail = generate_sequential_users(n - n / 2, 0, 5);
+    drift.insert(drift.end(), drift_tail.begin(), drift_tail.end());
+    vector<User> drift_missing = generate_missing_users(n / 10, 7);
+
+    vector<tuple<string, vector<User> *, vector<User> *>> datasets = {
+        {"reales", &real_users, &fake_users},
+        {"falsos", &fake_users, &real_users},
+        {"ids seguidos", &sequential, &sequential_missing},
+        {"deriva", &drift, &drift_missing}};
+    for (auto &dataset : datasets)
+    {
+        vector<User> &users = *get<1>(dataset);
+        vector<User> &missing = *get<2>(dataset);
+        for (size_t s = 0; s < ADAPTIVE_STRATEGIES.size(); s++)
+            adaptive_row(file_out, ADAPTIVE_STRATEGIES[s].name, get<0>(dataset), users, missing, n_tests, s, false);
+        adaptive_row(file_out, "adaptativa", get<0>(dataset), users, missing, n_tests, 0, true);
+    }
+    file_out.close();
+}
+
+
+//----------------------------------------------------------------------//
+//-----------------------TESTS DE CARGA SIN DUPLICADOS------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe una fila de dedup_load_test con el menor tiempo de n_tests corridas de load, que carga el CSV
+ * en una tabla nueva, y devuelve esa tabla (la de la última corrida).
+ * @param python_ms: tiempo de delete_duplicates.py que se suma a la carga, -1 si el flujo no lo usa.
+ */
+template <typename Load>
+unique_ptr<CloseHashTableUserName> dedup_load_row(ofstream &file_out, const string &name, size_t rows, int table_size,
+                                                  int n_tests, double python_ms, Load load)
+{
+    unique_ptr<CloseHashTableUserName> table;
+    double best = 1e18;
+    for (int t = 0; t < n_tests; t++)
+    {
+        table.reset(new CloseHashTableUserName(table_size, linear_probing));
+        auto start = chrono::high_resolution_clock::now();
+        load(*table);
+        auto end = chrono::high_resolution_clock::now();
+        best = min(best, chrono::duration<double, milli>(end - start).count());
+    }
+    file_out << name << "," << rows << "," << table->size << ",";
+    if (python_ms < 0)
+        file_out << "-," << best << "," << best;
+    else
+        file_out << python_ms << "," << best << "," << python_ms + best;
+    file_out << endl;
+    return table;
+}
+
+/**
+ * @brief Compara cargar un CSV con userName repetidos en CloseHashTableUserName:
+ * - python + C++: delete_duplicates.py (pandas) escribe el CSV sin duplicados y después se lee con readCSV y se
+ *   inserta con insert(User &&), como se hacía antes.
+ * - load_csv_unique con keep_first (try_emplace) y keep_last (insert_or_assign): una sola pasada por el CSV y una
+ *   sola secuencia de prueba por fila.
+ * - search + insert: la misma eliminación de duplicados con dos secuencias de prueba por fila.
+ * - insert sin eliminar duplicados, que deja usuarios repetidos en la tabla.
+ * Al final revisa que keep_first deje los mismos usuarios que el CSV de delete_duplicates.py.
+ * En el archivo csv se guarda: flujo, filas leídas, usuarios en la tabla, python(ms), carga C++(ms) y total(ms).
+ *
+ * @param raw_file: CSV con duplicados (universities_followers.csv), delete_duplicates.py debe estar en la carpeta
+ * actual y escribe su resultado en clean_file.
+ * @param clean_file: CSV que escribe delete_duplicates.py (universities_followers_without_duplicates.csv).
+ * @param n_tests: veces que se repite cada carga (se guarda el menor tiempo).
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void dedup_load_test(string raw_file, string clean_file, int n_tests, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Flujo,Filas leídas,Usuarios en la tabla,Python(ms),Carga C++(ms),Total(ms)" << endl;
+    size_t rows = for_each_csv_user(raw_file, [](User &&) {});
+    int table_size = next_prime(rows / 0.75);
+
+    // el script se corre n_tests veces y se guarda el menor tiempo, igual que las cargas
+    double python_ms = 1e18;
+    bool python_ok = true;
+    for (int t = 0; t < n_tests && python_ok; t++)
+    {
+        auto start = chrono::high_resolution_clock::now();
+        python_ok = system("python3 delete_duplicates.py") == 0;
+        auto end = chrono::high_resolution_clock::now();
+        python_ms = min(python_ms, chrono::duration<double, milli>(end - start).count());
+    }
+    if (python_ok)
+    {
+        dedup_load_row(file_out, "python + C++ insert", rows, table_size, n_tests, python_ms,
+                       [&](CloseHashTableUserName &table)
+                       {
+                           for (User &user : readCSV(clean_file))
+                               table.insert(move(user));
+                       });
+    }
+    else
+        cout << "No se pudo correr delete_duplicates.py (se necesita python3 con pandas)." << endl;
+
+    auto first = dedup_load_row(file_out, "C++ keep_first (try_emplace)", rows, table_size, n_tests, -1,
+                                [&](CloseHashTableUserName &table)
+                                { load_csv_unique(raw_file, table, keep_first); });
+    dedup_load_row(file_out, "C++ keep_last (insert_or_assign)", rows, table_size, n_tests, -1,
+                   [&](CloseHashTableUserName &table)
+                   { load_csv_unique(raw_file, table, keep_last); });
+    dedup_load_row(file_out, "C++ search + insert", rows, table_size, n_tests, -1,
+                   [&](CloseHashTableUserName &table)
+                   {
+                       for_each_csv_user(raw_file, [&](User &&user)
+                                         {
+                                             if (!table.search(user.userName))
+                                                 table.insert(move(user)); });
+                   });
+    dedup_load_row(file_out, "C++ insert con duplicados", rows, table_size, n_tests, -1,
+                   [&](CloseHashTableUserName &table)
+                   {
+                       for_each_csv_user(raw_file, [&](User &&user)
+                                         { table.insert(move(user)); });
+                   });
+
+    if (python_ok)
+    {
+        vector<User> clean = readCSV(clean_file);
+        size_t same = 0;
+        for (User &user : clean)
+        {
+            User *found = first->search(user.userName);
+            same += found && found->userId == user.userId && found->university == user.university &&
+                    found->numberTweets == user.numberTweets && found->createdAt == user.createdAt;
+        }
+        cout << "keep_first coincide con delete_duplicates.py en " << same << " de " << clean.size()
+             << " usuarios (la tabla tiene " << first->size << ")." << endl;
+    }
+    file_out.close();
+}
+
+
+//----------------------------------------------------------------------//
+//------------------------TESTS DE LA TABLA EN DISCO--------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe una fila de disk_hash_test: inserta todos los usuarios en una DiskHashTableUserId nueva con un pool
+ * de pool_pages páginas, busca n_searchs usuarios al azar y n_searchs inexistentes, y elimina n_searchs usuarios.
+ * @return Páginas que quedaron en el archivo.
+ */
+uint32_t disk_hash_row(ofstream &file_out, const string &path, size_t pool_pages, bool direct_io, vector<User> &users,
+                       vector<User> &missing, size_t n_searchs)
+{
+    DiskHashTableUserId table(path, pool_pages, true, direct_io);
+    BufferPool &pool = table.pool;
+    mt19937_64 rng(3);
+    volatile size_t sink = 0;
+
+    auto start = chrono::high_resolution_clock::now();
+    for (User &user : users)
+        table.insert(user.userId, &user);
+    table.flush();
+    auto after_insert = chrono::high_resolution_clock::now();
+    size_t insert_writes = pool.writes, reads_before = pool.reads, hits_before = pool.hits, misses_before = pool.misses;
+
+    size_t found = 0;
+    for (size_t i = 0; i < n_searchs; i++)
+        found += table.search(users[rng() % users.size()].userId) != nullptr;
+    auto after_search = chrono::high_resolution_clock::now();
+    for (size_t i = 0; i < n_searchs; i++)
+        found += table.search(missing[i % missing.size()].userId) != nullptr;
+    auto after_missing = chrono::high_resolution_clock::now();
+    size_t search_reads = pool.reads - reads_before;
+    size_t search_hits = pool.hits - hits_before, search_misses = pool.misses - misses_before;
+    for (size_t i = 0; i < n_searchs; i++)
+        table.remove(users[rng() % users.size()].userId);
+    table.flush();
+    auto end = chrono::high_resolution_clock::now();
+    sink += found;
+
+    auto us_per = [](chrono::high_resolution_clock::time_point a, chrono::high_resolution_clock::time_point b, size_t n)
+    { return chrono::duration<double, micro>(b - a).count() / n; };
+    file_out << pool_pages << "," << pool_pages * DISK_PAGE_SIZE / 1e6 << "," << table.disk_bytes() / 1e6 << ","
+             << users.size() << "," << (pool.direct_io ? "si" : "no") << "," << us_per(start, after_insert, users.size())
+             << "," << us_per(after_insert, after_search, n_searchs) << ","
+             << us_per(after_search, after_missing, n_searchs) << "," << us_per(after_missing, end, n_searchs) << ","
+             << (double)insert_writes / users.size() << "," << (double)search_reads / (2 * n_searchs) << ","
+             << 100.0 * search_hits / (search_hits + search_misses) << "," << table.splits << ","
+             << table.global_depth << endl;
+    return table.page_count;
+}
+
+/**
+ * @brief Mide DiskHashTableUserId (disk_hash.h) con el buffer pool del tamaño de todos los datos, de un 10% y de un
+ * 1%: tiempo por operación, escrituras por insert, lecturas del archivo por busqueda y porcentaje de busquedas que
+ * encontraron la página en el pool. Con direct_io las páginas se leen con O_DIRECT, sin pasar por el cache del
+ * sistema operativo.
+ * En el archivo csv se guarda: páginas del pool, pool(MB), datos(MB), número de usuarios, O_DIRECT, insert(us),
+ * search(us), search inexistentes(us), remove(us), escrituras por insert, lecturas por busqueda, aciertos del
+ * pool(%), divisiones de páginas y profundidad global.
+ *
+ * @param n: cantidad de usuarios generados.
+ * @param n_searchs: busquedas de usuarios existentes (y de inexistentes, y eliminaciones).
+ * @param directory: carpeta donde se crea el archivo de la tabla (se borra al terminar).
+ * @param direct_io: si se intenta usar O_DIRECT.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void disk_hash_test(size_t n, size_t n_searchs, string directory, bool direct_io, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Páginas del pool,Pool(MB),Datos(MB),Número de usuarios,O_DIRECT,Insert(us),Search(us),"
+                "Search inexistentes(us),Remove(us),Escrituras por insert,Lecturas por busqueda,Aciertos del pool(%),"
+                "Divisiones,Profundidad global"
+             << endl;
+    vector<User> users = generate_users(n);
+    vector<User> missing = generate_missing_users(n_searchs, 7);
+    string path = directory + "/disk_hash.db";
+
+    // primero con un pool donde caben todas las páginas, así se sabe cuantas son
+    size_t pages = n * 100 / DISK_PAGE_SIZE + 16;
+    pages = disk_hash_row(file_out, path, pages * 2, direct_io, users, missing, n_searchs);
+    disk_hash_row(file_out, path, max<size_t>(pages / 10, 3), direct_io, users, missing, n_searchs);
+    disk_hash_row(file_out, path, max<size_t>(pages / 100, 3), direct_io, users, missing, n_searchs);
+    unlink(path.c_str());
+    unlink((path + ".dir").c_str());
+    file_out.close();
+}
+
+
+//----------------------------------------------------------------------//
+//-----------------------------TESTS DE JOIN----------------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe las filas de join_test de un par de datasets y un tipo de clave: para cada tipo de join, el
+ * método actual (construir una tabla cerrada con build y buscar las claves de probe una por una) contra
+ * hash_join sin particiones, particionado con 1 hilo y particionado con n_threads hilos. Guarda el menor tiempo
+ * de n_tests corridas.
+ */
+template <typename Key>
+void join_rows(ofstream &file_out, const string &dataset, const string &key_name, const vector<User> &build,
+               const vector<User> &probe, size_t partition_bytes, int n_threads, int n_tests)
+{
+    typedef typename conditional<is_same<Key, string>::value, CloseHashTableUserName, CloseHashTableUserId>::type Table;
+    const vector<pair<JoinType, string>> types = {{inner_join, "inner"}, {semi_join, "semi"}, {anti_join, "anti"}};
+    volatile size_t sink = 0;
+
+    for (auto &type : types)
+    {
+        auto write_row = [&](const string &method, int threads, int partitions, size_t results, double ms)
+        {
+            file_out << dataset << "," << key_name << "," << type.second << "," << method << "," << threads << ","
+                     << partitions << "," << build.size() << "," << probe.size() << "," << results << "," << ms << ","
+                     << (build.size() + probe.size()) / ms / 1e3 << endl;
+        };
+
+        double best = 1e18;
+        size_t results = 0;
+        for (int t = 0; t < n_tests; t++)
+        {
+            auto start = chrono::high_resolution_clock::now();
+            Table table(next_prime(build.size() / 0.75), linear_probing);
+            for (const User &user : build)
+                table.insert(UserKey<Key>::get(user), (User *)&user);
+            results = 0;
+            for (const User &user : probe)
+            {
+                bool found = table.search(UserKey<Key>::get(user)) != nullptr;
+                results += type.first == anti_join ? !found : found;
+            }
+            auto end = chrono::high_resolution_clock::now();
+            best = min(best, chrono::duration<double, milli>(end - start).count());
+        }
+        write_row("tabla + search", 1, 1, results, best);
+
+        vector<tuple<string, int, size_t>> variants = {
+            {"hash join sin particiones", 1, 0}, {"hash join radix", 1, partition_bytes}};
+        if (n_threads > 1)
+            variants.push_back({"hash join radix", n_threads, partition_bytes});
+        for (auto &variant : variants)
+        {
+            best = 1e18;
+            JoinResult result;
+            for (int t = 0; t < n_tests; t++)
+            {
+                auto start = chrono::high_resolution_clock::now();
+                result = hash_join<Key>(build, probe, type.first, get<1>(variant), get<2>(variant));
+                auto end = chrono::high_resolution_clock::now();
+                best = min(best, chrono::duration<double, milli>(end - start).count());
+            }
+            sink += result.size();
+            write_row(get<0>(variant), get<1>(variant), result.partitions, result.size(), best);
+        }
+    }
+}
+
+/**
+ * @brief Compara hash_join (hash_join.h) con construir una tabla y buscar una por una, para inner, semi y anti join
+ * por userId y por userName:
+ * - usuarios reales (build) contra falsos (probe).
+ * - seguidores de las dos universidades con más seguidores en el CSV con duplicados (un mismo userName sigue a
+ *   varias universidades).
+ * - n usuarios generados contra n usuarios donde la mitad está en el primer grupo (en otro orden).
+ * Las particiones se eligen para que la tabla de cada una quepa en la cache L2 (256 KB si no se puede leer).
+ * En el archivo csv se guarda: datos, clave, join, método, hilos, particiones, filas build, filas probe,
+ * resultados, tiempo(ms) y millones de filas por segundo.
+ *
+ * @param real_users: usuarios del dataset real.
+ * @param fake_users: usuarios del dataset falso.
+ * @param raw_file: CSV con duplicados (universities_followers.csv).
+ * @param n: cantidad de usuarios generados.
+ * @param n_tests: veces que se repite cada join (se guarda el menor tiempo).
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void join_test(vector<User> &real_users, vector<User> &fake_users, string raw_file, size_t n, int n_tests,
+               string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Datos,Clave,Join,Método,Hilos,Particiones,Filas build,Filas probe,Resultados,Tiempo(ms),"
+                "Millones de filas por segundo"
+             << endl;
+    size_t partition_bytes = 256 << 10;
+    for (auto cache : read_cache_sizes())
+    {
+        if (cache.first == 2)
+            partition_bytes = cache.second;
+    }
+    int n_threads = resolve_threads(0);
+
+    vector<pair<string, pair<vector<User>, vector<User>>>> datasets;
+    datasets.push_back({"reales contra falsos", {real_users, fake_users}});
+
+    vector<User> raw = readCSV(raw_file);
+    unordered_map<string, size_t> followers;
+    for (User &user : raw)
+        followers[user.university]++;
+    vector<pair<size_t, string>> ranking;
+    for (auto &entry : followers)
+        ranking.push_back({entry.second, entry.first});
+    sort(ranking.rbegin(), ranking.rend());
+    if (ranking.size() >= 2)
+    {
+        vector<User> a, b;
+        for (User &user : raw)
+        {
+            if (user.university == ranking[0].second)
+                a.push_back(user);
+            else if (user.university == ranking[1].second)
+                b.push_back(user);
+        }
+        datasets.push_back({ranking[0].second + " contra " + ranking[1].second, {b, a}});
+    }
+
+    vector<User> build = generate_users(n);
+    vector<User> probe = generate_missing_users(n - n / 2, 7);
+    mt19937_64 rng(11);
+    for (size_t i = 0; i < n / 2; i++)
+        probe.push_back(build[rng() % build.size()]);
+    shuffle(probe.begin(), probe.end(), rng);
+    datasets.push_back({"generados", {move(build), move(probe)}});
+
+    for (auto &dataset : datasets)
+    {
+        join_rows<unsigned long long>(file_out, dataset.first, "userId", dataset.second.first, dataset.second.second,
+                                      partition_bytes, n_threads, n_tests);
+        join_rows<string>(file_out, dataset.first, "userName", dataset.second.first, dataset.second.second,
+                          partition_bytes, n_threads, n_tests);
+    }
+    file_out.close();
+}
+
+
+//----------------------------------------------------------------------//
+//-------------------------TESTS DE CARDINALIDAD------------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Cantidad exacta de claves distintas de users.
+ */
+template <typename Key>
+size_t distinct_keys(const vector<User> &users)
+{
+    unordered_set<Key> keys;
+    for (const User &user : users)
+        keys.insert(UserKey<Key>::get(user));
+    return keys.size();
+}
+
+/**
+ * @brief n filas con duplicados para los tests de cardinalidad: n / 2 usuarios generados y n - n / 2 repeticiones
+ * de usuarios al azar entre ellos, desordenados.
+ */
+vector<User> generate_users_with_duplicates(size_t n)
+{
+    vector<User> users = generate_users(n / 2);
+    mt19937_64 rng(13);
+    size_t distinct = users.size();
+    for (size_t i = distinct; i < n; i++)
+        users.push_back(users[rng() % distinct]);
+    shuffle(users.begin(), users.end(), rng);
+    return users;
+}
+
+/**
+ * @brief Error de HyperLogLog (hyperloglog.h) al estimar los userId y userName distintos, y los userName distintos
+ * de cada universidad, para varias precisiones. Se usa el CSV con duplicados (la estimación se hace leyendo el
+ * archivo con estimate_csv_cardinality, el tiempo incluye leerlo) y n filas generadas con la mitad repetidas.
+ * En el archivo csv se guarda: datos, clave, precisión, memoria(bytes), reales, estimados, error(%), error
+ * esperado(%) y tiempo(ms). Para las universidades reales y estimados son la suma de todas, el error es el
+ * promedio de los errores de cada universidad y se agrega una fila con el peor.
+ *
+ * @param raw_file: CSV con duplicados (universities_followers.csv).
+ * @param n: filas generadas.
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void cardinality_test(string raw_file, size_t n, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Datos,Clave,Precisión,Memoria(bytes),Reales,Estimados,Error(%),Error esperado(%),Tiempo(ms)" << endl;
+    vector<User> raw = readCSV(raw_file);
+    vector<User> generated = generate_users_with_duplicates(n);
+
+    // valores exactos de cada universidad del CSV
+    unordered_map<string, unordered_set<string>> university_names;
+    for (User &user : raw)
+        university_names[user.university].insert(user.userName);
+
+    auto write_row = [&](const string &dataset, const string &key, int precision, size_t memory, double real,
+                         double estimated, double error, double expected, double ms)
+    {
+        file_out << dataset << "," << key << "," << precision << "," << memory << "," << real << "," << estimated
+                 << "," << error * 100 << "," << expected * 100 << "," << ms << endl;
+    };
+    auto relative_error = [](double estimated, double real)
+    { return fabs(estimated - real) / real; };
+
+    for (int precision : {10, 12, 14, 16})
+    {
+        int university_precision = precision - 4;
+        auto start = chrono::high_resolution_clock::now();
+        CsvCardinality csv = estimate_csv_cardinality(raw_file, precision, university_precision);
+        auto end = chrono::high_resolution_clock::now();
+        double ms = chrono::duration<double, milli>(end - start).count();
+
+        double real_ids = distinct_keys<unsigned long long>(raw), real_names = distinct_keys<string>(raw);
+        write_row("CSV con duplicados", "userId", precision, csv.user_ids.get_memory_usage(), real_ids,
+                  csv.user_ids.estimate(), relative_error(csv.user_ids.estimate(), real_ids),
+                  csv.user_ids.standard_error(), ms);
+        write_row("CSV con duplicados", "userName", precision, csv.user_names.get_memory_usage(), real_names,
+                  csv.user_names.estimate(), relative_error(csv.user_names.estimate(), real_names),
+                  csv.user_names.standard_error(), ms);
+
+        double real_sum = 0, estimated_sum = 0, mean_error = 0, worst_error = 0;
+        size_t memory = 0;
+        for (auto &university : csv.universities)
+        {
+            double real = university_names[university.first].size(), estimated = university.second.estimate();
+            real_sum += real;
+            estimated_sum += estimated;
+            mean_error += relative_error(estimated, real) / csv.universities.size();
+            worst_error = max(worst_error, relative_error(estimated, real));
+            memory += university.second.get_memory_usage();
+        }
+        double expected = HyperLogLog(university_precision).standard_error();
+        write_row("CSV con duplicados", "userName por universidad (promedio)", university_precision, memory, real_sum,
+                  estimated_sum, mean_error, expected, ms);
+        write_row("CSV con duplicados", "userName por universidad (peor)", university_precision, memory, real_sum,
+                  estimated_sum, worst_error, expected, ms);
+
+        HyperLogLog ids(precision), names(precision);
+        start = chrono::high_resolution_clock::now();
+        for (const User &user : generated)
+        {
+            ids.add(UserKey<unsigned long long>::hash(user.userId));
+            names.add(mix64(UserKey<string>::hash(user.userName)));
+        }
+        end = chrono::high_resolution_clock::now();
+        ms = chrono::duration<double, milli>(end - start).count();
+        real_ids = distinct_keys<unsigned long long>(generated);
+        real_names = distinct_keys<string>(generated);
+        write_row("generados", "userId", precision, ids.get_memory_usage(), real_ids, ids.estimate(),
+                  relative_error(ids.estimate(), real_ids), ids.standard_error(), ms);
+        write_row("generados", "userName", precision, names.get_memory_usage(), real_names, names.estimate(),
+                  relative_error(names.estimate(), real_names), names.standard_error(), ms);
+    }
+    file_out.close();
+}
+
+/**
+ * @brief Escribe las filas de presize_test de un dataset y un tipo de clave. Carga users sin duplicados
+ * (try_emplace, se queda el primero) en una tabla cerrada con linear probing de cuatro formas:
+ * - filas: tamaño para todas las filas (lo que se sabe sin leer los datos antes), sobra espacio si hay duplicados.
+ * - crecer: empieza con 1009 espacios y se duplica (rehash) cada vez que pasa el factor de carga 0.75.
+ * - HyperLogLog: una pasada con el sketch (precisión 14) para estimar las claves distintas, y una tabla de ese
+ *   tamaño para factor de carga 0.75. El tiempo incluye la pasada.
+ * - exacto: tamaño con la cantidad real de claves distintas (no se puede saber antes de cargar, es la referencia).
+ */
+template <typename Key>
+void presize_rows(ofstream &file_out, const string &dataset, const string &key_name, const vector<User> &users,
+                  int n_tests)
+{
+    typedef typename conditional<is_same<Key, string>::value, CloseHashTableUserName, CloseHashTableUserId>::type Table;
+    size_t distinct = distinct_keys<Key>(users);
+    const vector<string> strategies = {"filas", "crecer", "HyperLogLog", "exacto"};
+
+    for (const string &strategy : strategies)
+    {
+        double best = 1e18;
+        int initial_size = 0, final_size = 0, rehashes = 0, stored = 0;
+        double collisions = 0;
+        for (int t = 0; t < n_tests; t++)
+        {
+            auto start = chrono::high_resolution_clock::now();
+            if (strategy == "filas")
+                initial_size = table_size_for(users.size());
+            else if (strategy == "crecer")
+                initial_size = 1009;
+            else if (strategy == "exacto")
+                initial_size = table_size_for(distinct);
+            else
+            {
+                HyperLogLog sketch(14);
+                for (const User &user : users)
+                    sketch.add(mix64(UserKey<Key>::hash(UserKey<Key>::get(user))));
+                initial_size = table_size_for(sketch.estimate());
+            }
+
+            Table table(initial_size, linear_probing);
+            rehashes = 0;
+            for (const User &user : users)
+            {
+                if (strategy == "crecer" && table.size + 1 > 0.75 * table.max_size)
+                {
+                    table.rehash(next_prime(2 * table.max_size));
+                    rehashes++;
+                }
+                table.try_emplace(UserKey<Key>::get(user), user);
+            }
+            auto end = chrono::high_resolution_clock::now();
+            best = min(best, chrono::duration<double, milli>(end - start).count());
+            final_size = table.max_size;
+            stored = table.size;
+            collisions = (double)table.totalCollisions / table.size;
+        }
+        file_out << dataset << "," << key_name << "," << strategy << "," << users.size() << "," << distinct << ","
+                 << stored << "," << initial_size << "," << final_size << "," << (double)stored / final_size << ","
+                 << rehashes << "," << collisions << "," << (size_t)final_size * sizeof(User *) << "," << best
+                 << endl;
+    }
+}
+
+/**
+ * @brief Compara el tiempo de cargar datos con duplicados en una tabla cerrada según cómo se elige su tamaño:
+ * para todas las filas, creciendo, con la estimación de HyperLogLog o con el valor exacto (ver presize_rows).
+ * Se usa el CSV con duplicados y n filas generadas con la mitad repetidas, por userId y por userName.
+ * En el archivo csv se guarda: datos, clave, estrategia, filas, distintos, guardados, tamaño inicial, tamaño
+ * final, factor de carga final, rehashes, colisiones promedio, memoria de la tabla(bytes) y tiempo(ms).
+ *
+ * @param raw_file: CSV con duplicados (universities_followers.csv).
+ * @param n: filas generadas.
+ * @param n_tests: veces que se repite cada carga (se guarda el menor tiempo).
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void presize_test(string raw_file, size_t n, int n_tests, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Datos,Clave,Estrategia,Filas,Distintos,Guardados,Tamaño inicial,Tamaño final,Factor de carga,"
+                "Rehashes,Colisiones promedio,Memoria tabla(bytes),Tiempo(ms)"
+             << endl;
+    vector<User> raw = readCSV(raw_file);
+    vector<User> generated = generate_users_with_duplicates(n);
+    presize_rows<unsigned long long>(file_out, "CSV con duplicados", "userId", raw, n_tests);
+    presize_rows<string>(file_out, "CSV con duplicados", "userName", raw, n_tests);
+    presize_rows<unsigned long long>(file_out, "generados", "userId", generated, n_tests);
+    presize_rows<string>(file_out, "generados", "userName", generated, n_tests);
+    file_out.close();
+}
+
+
+//----------------------------------------------------------------------//
+//-----------------------TESTS DE TABLA SIN LOCKS-----------------------//
+//----------------------------------------------------------------------//
+
+/**
+ * @brief Escribe las filas de concurrent_test de una tabla: para cada cantidad de hilos crea la tabla con
+ * make_table() y mide la ingesta (los hilos insertan partes distintas de users) y las dos cargas mixtas (se
+ * precarga la mitad de users y cada hilo hace ops_per_thread operaciones sobre usuarios al azar).
+ *
+ * @param insert, search, remove: (tabla, usuario) -> si la operación encontró o cambió algo.
+ */
+template <typename MakeTable, typename Insert, typename Search, typename Remove>
+void concurrent_rows(ofstream &file_out, const string &name, const vector<User> &users, const vector<int> &threads,
+                     size_t ops_per_thread, int n_tests, MakeTable make_table, Insert insert, Search search,
+                     Remove remove)
+{
+    // porcentajes de insert y search de cada carga, el resto son remove
+    const vector<tuple<string, int, int>> loads = {
+        {"ingesta", 100, 0}, {"50% insert 50% search", 50, 50}, {"40% insert 40% search 20% remove", 40, 40}};
+    volatile size_t sink = 0;
+
+    for (auto &load : loads)
+    {
+        bool ingest = get<0>(load) == "ingesta";
+        for (int n_threads : threads)
+        {
+            size_t n_ops = ingest ? users.size() : ops_per_thread * n_threads;
+            double best = 1e18;
+            size_t found = 0;
+            for (int t = 0; t < n_tests; t++)
+            {
+                auto table = make_table();
+                if (!ingest)
+                {
+                    for (size_t i = 0; i < users.size() / 2; i++)
+                        insert(*table, users[i]);
+                }
+                atomic<size_t> hits(0);
+                auto start = chrono::high_resolution_clock::now();
+                parallel_for(n_ops, n_threads, [&](size_t begin, size_t end, int thread_id)
+                             {
+                                 size_t local_hits = 0;
+                                 mt19937_64 rng(thread_id + 1);
+                                 for (size_t i = begin; i < end; i++)
+                                 {
+                                     if (ingest)
+                                     {
+                                         local_hits += insert(*table, users[i]);
+                                         continue;
+                                     }
+                                     const User &user = users[rng() % users.size()];
+                                     int op = rng() % 100;
+                                     if (op < get<1>(load))
+                                         local_hits += insert(*table, user);
+                                     else if (op < get<1>(load) + get<2>(load))
+                                         local_hits += search(*table, user);
+                                     else
+                                         local_hits += remove(*table, user);
+                                 }
+                                 hits += local_hits; });
+                auto end = chrono::high_resolution_clock::now();
+                best = min(best, chrono::duration<double, milli>(end - start).count());
+
+                // despues de la ingesta todos los usuarios deben estar
+                found = 0;
+                for (const User &user : users)
+                    found += search(*table, user);
+                sink += hits;
+            }
+            file_out << name << "," << get<0>(load) << "," << n_threads << "," << n_ops << "," << found << ","
+                     << best << "," << n_ops / best / 1e3 << endl;
+        }
+    }
+}
+
+/**
+ * @brief Compara LockFreeHashTableUserId (concurrent_table.h) con una CloseHashTableUserId protegida con un mutex
+ * (LockedHashTableUserId) en 1..max_threads hilos, y con la CloseHashTableUserId sin lock en un hilo. Cargas:
+ * - ingesta: los hilos insertan n usuarios generados, cada uno una parte.
+ * - 50% insert 50% search y 40% insert 40% search 20% remove, sobre usuarios al azar de los n, con la mitad
+ *   precargada.
+ * Las tablas tienen 2n espacios y usan linear probing; una clave se guarda una sola vez.
+ * En el archivo csv se guarda: tabla, carga, hilos, operaciones, usuarios encontrados al final, tiempo(ms) y
+ * millones de operaciones por segundo.
+ *
+ * @param n: cantidad de usuarios generados.
+ * @param ops_per_thread: operaciones de cada hilo en las cargas mixtas.
+ * @param max_threads: cantidad máxima de hilos (se prueban 1, 2, 4, ... y max_threads).
+ * @param n_tests: veces que se repite cada medición (se guarda el menor tiempo).
+ * @param file_name: nombre del archivo saliente, este se pone sin la extension.
+ */
+void concurrent_test(size_t n, size_t ops_per_thread, int max_threads, int n_tests, string file_name)
+{
+    ofstream file_out(file_name + ".csv", ios::app);
+    file_out << "Tabla,Carga,Hilos,Operaciones,Usuarios al final,Tiempo(ms),Millones de operaciones por segundo" << endl;
+    vector<User> users = generate_users(n);
+    int table_size = next_prime(2 * n);
+    vector<int> threads;
+    for (int t = 1; t < max_threads; t *= 2)
+        threads.push_back(t);
+    threads.push_back(max_threads);
+
+    concurrent_rows(
+        file_out, "CloseHashTableUserId sin lock", users, {1}, ops_per_thread, n_tests,
+        [&]() { return unique_ptr<CloseHashTableUserId>(new CloseHashTableUserId(table_size, linear_probing)); },
+        [](CloseHashTableUserId &table, const User &user) { return table.try_emplace(user.userId, user).second; },
+        [](CloseHashTableUserId &table, const User &user) { return table.search(user.userId) != nullptr; },
+        [](CloseHashTableUserId &table, const User &user)
+        {
+            int before = table.size;
+            unsigned long long key = user.userId;
+            table.remove(key);
+            return table.size < before;
+        });
+    concurrent_rows(
+        file_out, "CloseHashTableUserId con mutex", users, threads, ops_per_thread, n_tests,
+        [&]() { return unique_ptr<LockedHashTableUserId>(new LockedHashTableUserId(table_size)); },
+        [](LockedHashTableUserId &table, const User &user) { return table.insert(user.userId, &user); },
+        [](LockedHashTableUserId &table, const User &user) { return table.contains(user.userId); },
+        [](LockedHashTableUserId &table, const User &user) { return table.remove(user.userId); });
+    concurrent_rows(
+        file_out, "LockFreeHashTableUserId", users, threads, ops_per_thread, n_tests,
+        [&]() { return unique_ptr<LockFreeHashTableUserId>(new LockFreeHashTableUserId(table_size)); },
+        [](LockFreeHashTableUserId &table, const User &user) { return table.insert(user.userId, &user); },
+        [](LockFreeHashTableUserId &table, const User &user) { return table.contains(user.userId); },
+        [](LockFreeHashTableUserId &table, const User &user) { return table.remove(user.userId); });
     file_out.close();
 }
 
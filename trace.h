@@ -0,0 +1,248 @@
+#ifndef TRACE
+#define TRACE
+
+#include <vector>
+#include <string>
+#include <fstream>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+using namespace std;
+
+/*
+Trazado de las operaciones de las tablas (insert, search, remove) y de sus partes (hash, prueba, comparación,
+compactación), para ver en qué se fue el tiempo de una operación lenta. Se exporta al formato JSON de Chrome
+(chrome://tracing o https://ui.perfetto.dev).
+
+Solo se activa compilando con -DENABLE_TRACING: sin eso TRACE_OPERATION y TRACE_SPAN no generan código.
+Con trazado se registra una de cada trace_sample_every operaciones (muestreo): en las demás el costo es
+restar un contador del hilo, y dentro de ellas los TRACE_SPAN solo revisan una variable del hilo.
+
+Cada hilo escribe en su propio buffer circular (el más antiguo se sobrescribe), sin locks: el único lock es al
+registrar el buffer la primera vez que el hilo traza algo.
+*/
+
+/**
+ * @brief Un intervalo registrado.
+ */
+struct TraceEvent
+{
+    const char *name;  ///< Nombre del intervalo (literal, no se copia).
+    uint64_t start_ns; ///< Inicio, en ns desde que empezó el programa.
+    uint32_t duration_ns;
+    uint32_t depth;    ///< Profundidad dentro de la operación (0 = la operación).
+};
+
+/**
+ * @brief Buffer circular de un hilo. Solo su hilo escribe; trace_export_chrome() lo lee desde otro hilo.
+ */
+struct TraceBuffer
+{
+    static constexpr size_t CAPACITY = 1 << 16; ///< Eventos guardados por hilo (potencia de 2).
+
+    vector<TraceEvent> events = vector<TraceEvent>(CAPACITY);
+    atomic<uint64_t> head{0}; ///< Eventos escritos desde el inicio, el siguiente va en head % CAPACITY.
+    uint32_t thread_id;       ///< Número del hilo en el JSON.
+
+    void push(const TraceEvent &event)
+    {
+        uint64_t position = head.load(memory_order_relaxed);
+        events[position & (CAPACITY - 1)] = event;
+        head.store(position + 1, memory_order_release);
+    }
+};
+
+atomic<uint32_t> trace_sample_every(1024); ///< Se traza una de cada estas operaciones, 0 para no trazar ninguna.
+mutex trace_registry_mutex;                ///< Protege trace_buffers (solo al registrar y exportar).
+vector<shared_ptr<TraceBuffer>> trace_buffers; ///< Buffers de todos los hilos (siguen aunque el hilo termine).
+
+thread_local uint32_t trace_countdown = 1; ///< Operaciones que faltan para la siguiente muestra.
+thread_local uint32_t trace_depth = 0;     ///< Intervalos abiertos de la operación muestreada, 0 si no hay.
+thread_local TraceBuffer *trace_buffer = nullptr;
+
+/**
+ * @brief Tiempo actual en ns desde el inicio del programa.
+ */
+inline uint64_t trace_now_ns()
+{
+    static const chrono::steady_clock::time_point origin = chrono::steady_clock::now();
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now() - origin).count();
+}
+
+/**
+ * @brief Buffer del hilo actual, se crea y registra la primera vez.
+ */
+TraceBuffer *trace_thread_buffer()
+{
+    if (!trace_buffer)
+    {
+        auto buffer = make_shared<TraceBuffer>();
+        lock_guard<mutex> lock(trace_registry_mutex);
+        buffer->thread_id = trace_buffers.size() + 1;
+        trace_buffers.push_back(buffer);
+        trace_buffer = buffer.get();
+    }
+    return trace_buffer;
+}
+
+/**
+ * @brief Intervalo que se registra al destruirse (RAII). Se usa con TRACE_OPERATION y TRACE_SPAN.
+ */
+class TraceSpan
+{
+public:
+    /**
+     * @param name Nombre del intervalo, debe ser un literal.
+     * @param operation Si es el inicio de una operación: decide si se muestrea. Si ya hay una operación
+     * muestreada abierta en el hilo (por ejemplo compact() dentro de remove()) se registra como un intervalo más.
+     */
+    TraceSpan(const char *name, bool operation)
+    {
+        // el caso común (no se muestrea) queda en línea y toca una sola variable del hilo, el resto va en begin()
+        if (__builtin_expect(operation ? --trace_countdown != 0 : trace_depth == 0, 1))
+            return;
+        begin(name);
+    }
+
+    TraceSpan(const TraceSpan &) = delete;
+    TraceSpan &operator=(const TraceSpan &) = delete;
+
+    ~TraceSpan()
+    {
+        if (__builtin_expect(name != nullptr, 0))
+            end();
+    }
+
+private:
+    // depth y start_ns solo se asignan si el intervalo se registra, así el caso común escribe un solo campo
+    const char *name = nullptr; ///< nullptr si el intervalo no se registra.
+    uint32_t depth;
+    uint64_t start_ns;
+
+    /**
+     * @brief Vuelve a contar hasta la siguiente muestra, con 0 se vuelve a revisar cada 1024 operaciones
+     * por si se activa después.
+     */
+    static void reset_countdown()
+    {
+        uint32_t every = trace_sample_every.load(memory_order_relaxed);
+        trace_countdown = every ? every : 1024;
+    }
+
+    __attribute__((noinline)) void begin(const char *span_name)
+    {
+        if (trace_depth == 0 && trace_sample_every.load(memory_order_relaxed) == 0)
+        {
+            reset_countdown();
+            return;
+        }
+        // mientras la operación muestreada esté abierta, las operaciones anidadas también pasan por begin()
+        trace_countdown = 1;
+        name = span_name;
+        depth = trace_depth++;
+        start_ns = trace_now_ns();
+    }
+
+    __attribute__((noinline)) void end()
+    {
+        uint64_t end_ns = trace_now_ns();
+        if (--trace_depth == 0)
+            reset_countdown();
+        trace_thread_buffer()->push({name, start_ns, (uint32_t)(end_ns - start_ns), depth});
+    }
+};
+
+#ifdef ENABLE_TRACING
+#define TRACE_CONCAT_(a, b) a##b
+#define TRACE_CONCAT(a, b) TRACE_CONCAT_(a, b)
+/// Marca el inicio de una operación (insert, search, remove), dura hasta el final del bloque.
+#define TRACE_OPERATION(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name, true)
+/// Marca una parte de la operación (hash, prueba, ...), dura hasta el final del bloque.
+#define TRACE_SPAN(name) TraceSpan TRACE_CONCAT(trace_span_, __LINE__)(name, false)
+/// Evalúa expr dentro de un intervalo, para trazar una parte de una expresión (un hash, una comparación).
+/// Fuera de una operación muestreada evalúa expr directo, sin crear el intervalo.
+#define TRACED(name, expr) \
+    (__builtin_expect(trace_depth == 0, 1) ? (expr) : ([&]() { TraceSpan span(name, false); return expr; }()))
+#else
+#define TRACE_OPERATION(name)
+#define TRACE_SPAN(name)
+#define TRACED(name, expr) (expr)
+#endif
+
+/**
+ * @brief Si el programa se compiló con trazado.
+ */
+bool tracing_enabled()
+{
+#ifdef ENABLE_TRACING
+    return true;
+#else
+    return false;
+#endif
+}
+
+/**
+ * @brief Cantidad de eventos guardados ahora en los buffers (a lo más CAPACITY por hilo).
+ */
+size_t trace_event_count()
+{
+    lock_guard<mutex> lock(trace_registry_mutex);
+    size_t count = 0;
+    for (auto &buffer : trace_buffers)
+        count += min<uint64_t>(buffer->head.load(memory_order_acquire), TraceBuffer::CAPACITY);
+    return count;
+}
+
+/**
+ * @brief Borra los eventos de todos los buffers. Llamar cuando ningún hilo esté trazando.
+ */
+void trace_clear()
+{
+    lock_guard<mutex> lock(trace_registry_mutex);
+    for (auto &buffer : trace_buffers)
+        buffer->head.store(0, memory_order_release);
+}
+
+/**
+ * @brief Escribe los eventos de todos los hilos en formato JSON de Chrome (eventos completos, "ph": "X").
+ *
+ * Se puede llamar mientras otros hilos trazan: se copia cada buffer y se descartan los eventos que el hilo
+ * pudo haber sobrescrito durante la copia.
+ * @return Cantidad de eventos escritos.
+ */
+size_t trace_export_chrome(const string &file_name)
+{
+    ofstream file_out(file_name);
+    file_out << fixed << setprecision(3);
+    file_out << "{\"displayTimeUnit\":\"ns\",\"traceEvents\":[";
+    size_t written = 0;
+    lock_guard<mutex> lock(trace_registry_mutex);
+    for (auto &buffer : trace_buffers)
+    {
+        uint64_t head = buffer->head.load(memory_order_acquire);
+        uint64_t first = head > TraceBuffer::CAPACITY ? head - TraceBuffer::CAPACITY : 0;
+        vector<TraceEvent> copy;
+        for (uint64_t i = first; i < head; i++)
+            copy.push_back(buffer->events[i & (TraceBuffer::CAPACITY - 1)]);
+        uint64_t after = buffer->head.load(memory_order_acquire);
+        // el evento i se sobrescribe al escribir el i + CAPACITY, que empieza cuando head llega a i + CAPACITY
+        uint64_t valid = after >= TraceBuffer::CAPACITY ? after - TraceBuffer::CAPACITY + 1 : 0;
+
+        for (uint64_t i = max(first, valid); i < head; i++)
+        {
+            const TraceEvent &event = copy[i - first];
+            file_out << (written ? ",\n" : "\n") << "{\"name\":\"" << event.name << "\",\"ph\":\"X\",\"pid\":1,\"tid\":"
+                     << buffer->thread_id << ",\"ts\":" << event.start_ns / 1000.0
+                     << ",\"dur\":" << event.duration_ns / 1000.0 << ",\"args\":{\"depth\":" << event.depth << "}}";
+            written++;
+        }
+    }
+    file_out << "\n]}" << endl;
+    return written;
+}
+
+#endif
@@ -0,0 +1,105 @@
+#ifndef UNIVERSITY_STATS
+#define UNIVERSITY_STATS
+
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "functions.h"
+
+using namespace std;
+
+/**
+ * @brief Estadisticas de los seguidores de una universidad, se actualizan con cada insert y remove.
+ */
+struct UniversityAggregate
+{
+    int count = 0;                   ///< Cantidad de seguidores.
+    long long total_tweets = 0;      ///< Suma de numberTweets.
+    long long total_friends = 0;     ///< Suma de friendsCount.
+    long long total_followers = 0;   ///< Suma de followersCount.
+    set<pair<int, const User *>> by_followers; ///< Seguidores ordenados por followersCount (y puntero para desempatar).
+
+    /**
+     * @brief Máximo followersCount entre los seguidores, 0 si no hay seguidores.
+     */
+    int max_followers() const
+    {
+        return by_followers.empty() ? 0 : by_followers.rbegin()->first;
+    }
+};
+
+/**
+ * @brief Agregados por universidad mantenidos de forma incremental.
+ *
+ * Cada vez que se agrega o elimina un usuario se actualizan la cantidad, las sumas y el conjunto ordenado por
+ * followersCount de su universidad, así las consultas no recorren todos los usuarios: los totales son O(1)
+ * y el top K de seguidores es O(K) (se recorre el conjunto desde el mayor).
+ *
+ * @note Se guardan punteros a los usuarios, por lo que se debe llamar remove() antes de destruir o modificar un usuario.
+ */
+class UniversityStats
+{
+public:
+    unordered_map<string, UniversityAggregate> universities; ///< Agregados por nombre de universidad.
+
+    /**
+     * @brief Agrega un usuario a los agregados de su universidad.
+     */
+    void add(const User *user)
+    {
+        UniversityAggregate &aggregate = universities[user->university];
+        aggregate.count++;
+        aggregate.total_tweets += user->numberTweets;
+        aggregate.total_friends += user->friendsCount;
+        aggregate.total_followers += user->followersCount;
+        aggregate.by_followers.insert({user->followersCount, user});
+    }
+
+    /**
+     * @brief Quita un usuario de los agregados de su universidad, si no estaba no hace nada.
+     */
+    void remove(const User *user)
+    {
+        auto it = universities.find(user->university);
+        if (it == universities.end() || it->second.by_followers.erase({user->followersCount, user}) == 0)
+            return;
+
+        UniversityAggregate &aggregate = it->second;
+        aggregate.count--;
+        aggregate.total_tweets -= user->numberTweets;
+        aggregate.total_friends -= user->friendsCount;
+        aggregate.total_followers -= user->followersCount;
+        if (aggregate.count == 0)
+            universities.erase(it);
+    }
+
+    /**
+     * @brief Devuelve los agregados de una universidad, nullptr si no tiene seguidores.
+     */
+    const UniversityAggregate *get(const string &university) const
+    {
+        auto it = universities.find(university);
+        return it == universities.end() ? nullptr : &it->second;
+    }
+
+    /**
+     * @brief Los k seguidores de una universidad con más followersCount, de mayor a menor.
+     */
+    vector<const User *> top_followers(const string &university, int k) const
+    {
+        vector<const User *> result;
+        const UniversityAggregate *aggregate = get(university);
+        if (!aggregate)
+            return result;
+
+        for (auto it = aggregate->by_followers.rbegin(); it != aggregate->by_followers.rend() && (int)result.size() < k; it++)
+        {
+            result.push_back(it->second);
+        }
+        return result;
+    }
+};
+
+#endif
@@ -0,0 +1,457 @@
+#ifndef USER_INDEX
+#define USER_INDEX
+
+#include <vector>
+#include <string>
+#include <iostream>
+
+#include "functions.h"
+#include "hash_functions.h"
+#include "hash_tables.h"
+#include "university_stats.h"
+
+using namespace std;
+
+// Valores especiales de los indices, las posiciones validas de rows son >= 0
+const int EMPTY_ROW = -1;   ///< Espacio del indice que nunca se ha usado.
+const int DELETED_ROW = -2; ///< Espacio del indice que tuvo un usuario que fue eliminado.
+
+/**
+ * @brief Indice de usuarios con un solo almacén de registros y dos tablas hash cerradas (por userId y por userName).
+ *
+ * A diferencia de tener un CloseHashTableUserId y un CloseHashTableUserName por separado, cada usuario se guarda
+ * una sola vez en rows y ambos indices guardan la posición (fila) del usuario, no una copia.
+ * insert() y remove_by_*() mantienen los dos indices consistentes en una sola llamada.
+ */
+class UserIndex
+{
+public:
+    int max_size;                                             ///< Tamaño de los indices (y capacidad de rows).
+    int size = 0;                                             ///< Cantidad de usuarios en el indice.
+    int totalCollisions = 0;                                  ///< Colisiones de ambos indices.
+    int tombstones = 0;                                       ///< Espacios DELETED_ROW de ambos indices.
+    int compactions = 0;                                      ///< Veces que se han compactado los indices.
+    bool auto_compact = true;                                 ///< Si se compacta solo al superar MAX_TOMBSTONE_RATIO.
+    int (*id_hashing_method)(unsigned long long, int, int);   ///< Función de hash del indice primario.
+    unsigned int (*name_hashing_method)(const string &, int, int); ///< Función de hash del indice secundario.
+    HugePageVector<User> rows;                                ///< Almacén de registros, cada usuario se guarda una vez.
+    vector<int> free_rows;                                    ///< Filas liberadas por remove, se reutilizan al insertar.
+    HugePageVector<int> id_index;                             ///< Indice primario: fila del usuario por userId.
+    HugePageVector<int> name_index;                           ///< Indice secundario: fila del usuario por userName.
+    bool track_stats;                                         ///< Si se mantienen los agregados por universidad.
+    UniversityStats stats;                                    ///< Agregados por universidad (solo si track_stats).
+
+    /**
+     * @brief Constructor del indice.
+     * @param size Tamaño de los indices, como máximo se pueden guardar size usuarios.
+     * @param id_hashing_method Función de hash para el indice por userId.
+     * @param name_hashing_method Función de hash para el indice por userName.
+     * @param track_stats Si se mantienen los agregados por universidad en stats con cada insert y remove.
+     *
+     * @note rows reserva size posiciones, por lo que los punteros que devuelven las busquedas no se
+     * invalidan al insertar.
+     */
+    UserIndex(int size, int (*id_hashing_method)(unsigned long long, int, int) = linear_probing,
+              unsigned int (*name_hashing_method)(const string &, int, int) = linear_probing,
+              bool track_stats = false)
+        : max_size(size), id_hashing_method(id_hashing_method), name_hashing_method(name_hashing_method),
+          id_index(size, EMPTY_ROW), name_index(size, EMPTY_ROW), track_stats(track_stats)
+    {
+        rows.reserve(size);
+    }
+
+    /**
+     * @brief Inserta una copia del usuario en el almacén y en ambos indices.
+     * @param user Usuario a insertar, se copia una sola vez (insert(User &&) y emplace() no lo copian).
+     * @return Fila donde quedo el usuario, -1 si alguno de los indices esta lleno.
+     */
+    int insert(const User &user)
+    {
+        return insert(User(user));
+    }
+
+    /**
+     * @brief Inserta un usuario moviéndolo al almacén, sus strings no se copian.
+     * @param user Usuario a insertar, queda vacío después de la llamada (si se insertó).
+     * @return Fila donde quedo el usuario, -1 si alguno de los indices esta lleno.
+     */
+    int insert(User &&user)
+    {
+        TRACE_OPERATION("UserIndex::insert");
+        int collisions = 0;
+        int id_slot = find_free_slot(user.userId, collisions);
+        int name_slot = find_free_slot(user.userName, collisions);
+        if (id_slot < 0 || name_slot < 0 || (free_rows.empty() && (int)rows.size() == max_size))
+        {
+            cout << "Indice está lleno o se alcanzó el máximo de intentos." << endl;
+            return -1;
+        }
+        int row;
+        if (!free_rows.empty())
+        {
+            row = free_rows.back();
+            free_rows.pop_back();
+            rows[row] = move(user);
+        }
+        else
+        {
+            row = rows.size();
+            rows.push_back(move(user));
+        }
+        link_row(row, id_slot, name_slot, collisions);
+        return row;
+    }
+
+    /**
+     * @brief Construye el usuario directamente al final del almacén con los parametros del constructor de User,
+     * sin un User temporal. Si algún indice está lleno se saca del almacén. Si el almacén ya llegó a max_size
+     * filas se construye un temporal y se mueve a una fila libre (como insert(User &&)).
+     * @return Fila donde quedo el usuario, -1 si alguno de los indices esta lleno.
+     */
+    template <typename... Args>
+    int emplace(Args &&...args)
+    {
+        if ((int)rows.size() == max_size)
+            return insert(User(forward<Args>(args)...));
+
+        TRACE_OPERATION("UserIndex::emplace");
+        rows.emplace_back(forward<Args>(args)...);
+        int row = rows.size() - 1;
+        int collisions = 0;
+        int id_slot = find_free_slot(rows[row].userId, collisions);
+        int name_slot = find_free_slot(rows[row].userName, collisions);
+        if (id_slot < 0 || name_slot < 0)
+        {
+            rows.pop_back();
+            cout << "Indice está lleno o se alcanzó el máximo de intentos." << endl;
+            return -1;
+        }
+        link_row(row, id_slot, name_slot, collisions);
+        return row;
+    }
+
+    /**
+     * @brief Reemplaza al usuario con el mismo userId en su misma fila, o lo inserta si no está. Si cambia el
+     * userName se mueve su entrada en el indice secundario.
+     * @param user Usuario nuevo, queda vacío después de la llamada (si se guardó).
+     * @return Fila del usuario, -1 si el indice está lleno (el usuario anterior queda como estaba).
+     */
+    int update(User &&user)
+    {
+        TRACE_OPERATION("UserIndex::update");
+        int id_slot = find_slot(user.userId);
+        if (id_slot < 0)
+            return insert(move(user));
+
+        int row = id_index[id_slot];
+        User &old = rows[row];
+        if (old.userName != user.userName)
+        {
+            int collisions = 0;
+            int name_slot = find_free_slot(user.userName, collisions);
+            if (name_slot < 0)
+            {
+                cout << "Indice está lleno o se alcanzó el máximo de intentos." << endl;
+                return -1;
+            }
+            totalCollisions += collisions;
+            int old_name_slot = find_row(name_index, name_hashing_method, old.userName, row);
+            if (old_name_slot >= 0)
+            {
+                name_index[old_name_slot] = DELETED_ROW;
+                tombstones++;
+            }
+            tombstones -= name_index[name_slot] == DELETED_ROW;
+            name_index[name_slot] = row;
+        }
+        if (track_stats)
+            stats.remove(&old);
+        old = move(user);
+        if (track_stats)
+            stats.add(&old);
+        return row;
+    }
+
+    /**
+     * @brief Busca un usuario por su userId.
+     * @return Puntero al usuario dentro del almacén, nullptr si no se encuentra.
+     */
+    User *search_by_id(unsigned long long userId)
+    {
+        TRACE_OPERATION("UserIndex::search_by_id");
+        int slot = find_slot(userId);
+        return slot < 0 ? nullptr : &rows[id_index[slot]];
+    }
+
+    /**
+     * @brief Busca un usuario por su userName.
+     * @return Puntero al usuario dentro del almacén, nullptr si no se encuentra.
+     */
+    User *search_by_name(const string &userName)
+    {
+        TRACE_OPERATION("UserIndex::search_by_name");
+        int slot = find_slot(userName);
+        return slot < 0 ? nullptr : &rows[name_index[slot]];
+    }
+
+    /**
+     * @brief Elimina un usuario por su userId, también lo elimina del indice por userName.
+     * Si no existe no hace nada.
+     */
+    void remove_by_id(unsigned long long userId)
+    {
+        TRACE_OPERATION("UserIndex::remove_by_id");
+        int slot = find_slot(userId);
+        if (slot >= 0)
+            remove_row(id_index[slot]);
+    }
+
+    /**
+     * @brief Elimina un usuario por su userName, también lo elimina del indice por userId.
+     * Si no existe no hace nada.
+     */
+    void remove_by_name(const string &userName)
+    {
+        TRACE_OPERATION("UserIndex::remove_by_name");
+        int slot = find_slot(userName);
+        if (slot >= 0)
+            remove_row(name_index[slot]);
+    }
+
+    /**
+     * @brief Elimina exactamente ese usuario de ambos indices, aunque otro usuario tenga su mismo userId o userName.
+     * @param user Puntero que devolvió una busqueda de este indice.
+     */
+    void remove(const User *user)
+    {
+        TRACE_OPERATION("UserIndex::remove");
+        remove_row(user - &rows[0]);
+    }
+
+    /**
+     * @brief Compacta los indices: reinserta la fila de cada usuario en indices nuevos sin eliminados, así las
+     * secuencias de prueba vuelven a terminar en espacios vacíos. El almacén no cambia, los punteros a usuarios
+     * siguen siendo válidos.
+     * @return false si algún usuario no cabe en MAX_ATTEMPTS intentos, los indices quedan como estaban y remove
+     * deja de compactar solo hasta el siguiente compact() exitoso.
+     */
+    bool compact()
+    {
+        TRACE_SPAN("UserIndex::compact");
+        HugePageVector<int> old_id_index(max_size, EMPTY_ROW, id_index.get_allocator());
+        HugePageVector<int> old_name_index(max_size, EMPTY_ROW, name_index.get_allocator());
+        old_id_index.swap(id_index);
+        old_name_index.swap(name_index);
+        int collisions = 0;
+        // cada usuario guardado está una sola vez en el indice primario
+        for (int row : old_id_index)
+        {
+            if (row < 0)
+                continue;
+            int id_slot = find_free_slot(rows[row].userId, collisions);
+            int name_slot = find_free_slot(rows[row].userName, collisions);
+            if (id_slot < 0 || name_slot < 0)
+            {
+                id_index.swap(old_id_index);
+                name_index.swap(old_name_index);
+                cout << "No se pudo compactar el indice: un usuario no cabe en MAX_ATTEMPTS intentos." << endl;
+                // cada remove volvería a recorrer todo el indice para fallar igual
+                compact_failed = true;
+                return false;
+            }
+            id_index[id_slot] = row;
+            name_index[name_slot] = row;
+        }
+        tombstones = 0;
+        compact_failed = false;
+        compactions++;
+        return true;
+    }
+
+    /**
+     * @brief Usuarios guardados (las filas que no están libres), por ejemplo para escribir un snapshot.
+     */
+    vector<const User *> live_users() const
+    {
+        vector<char> is_free(rows.size(), 0);
+        for (int row : free_rows)
+            is_free[row] = 1;
+        vector<const User *> result;
+        result.reserve(size);
+        for (size_t row = 0; row < rows.size(); row++)
+        {
+            if (!is_free[row])
+                result.push_back(&rows[row]);
+        }
+        return result;
+    }
+
+    /**
+     *@brief Devuelve el numero total de colisiones que hubo al insertar en ambos indices.
+     */
+    int getCollision()
+    {
+        return totalCollisions;
+    }
+
+    /**
+     * @brief Devuelve la cantidad de espacio usado por la estructura de datos en bytes.
+     */
+    size_t get_memory_usage()
+    {
+        size_t count = 0;
+        // considerando el tamaño promedio de un usuario en memoria de 70 bytes, igual que en las tablas hash
+        int user_size = 70;
+
+        count += rows.size() * user_size;
+        count += free_rows.capacity() * sizeof(int);
+        count += id_index.size() * sizeof(int);
+        count += name_index.size() * sizeof(int);
+        // cada usuario en stats es un nodo del set: 3 punteros, el color y el par (int, puntero)
+        if (track_stats)
+            count += size * (4 * sizeof(void *) + sizeof(pair<int, const User *>));
+        // espacio usado por el resto de variables
+        count += sizeof(max_size);
+        count += sizeof(size);
+
+        return count;
+    }
+
+private:
+    bool compact_failed = false; ///< El último compact() falló, remove no vuelve a intentarlo hasta otro exitoso.
+
+    /**
+     * @brief Apunta los espacios libres id_slot y name_slot a una fila ya guardada en rows.
+     * @param collisions Colisiones de la busqueda de los espacios.
+     */
+    void link_row(int row, int id_slot, int name_slot, int collisions)
+    {
+        totalCollisions += collisions;
+        tombstones -= (id_index[id_slot] == DELETED_ROW) + (name_index[name_slot] == DELETED_ROW);
+        id_index[id_slot] = row;
+        name_index[name_slot] = row;
+        if (track_stats)
+            stats.add(&rows[row]);
+        size++;
+    }
+
+    /**
+     * @brief Busca el primer espacio libre (vacío o eliminado) para userId en el indice primario.
+     * @param collisions Se le suman las colisiones hasta encontrar el espacio (el llamador las cuenta si inserta).
+     * @return Posición en id_index, -1 si no se encontro.
+     */
+    int find_free_slot(unsigned long long userId, int &collisions)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int slot = TRACED("hash", id_hashing_method(userId, max_size, i));
+            if (id_index[slot] < 0)
+            {
+                collisions += i;
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Busca el primer espacio libre (vacío o eliminado) para userName en el indice secundario.
+     * @param collisions Se le suman las colisiones hasta encontrar el espacio (el llamador las cuenta si inserta).
+     * @return Posición en name_index, -1 si no se encontro.
+     */
+    int find_free_slot(const string &userName, int &collisions)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int slot = TRACED("hash", name_hashing_method(userName, max_size, i));
+            if (name_index[slot] < 0)
+            {
+                collisions += i;
+                return slot;
+            }
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Busca la posición de userId en el indice primario.
+     * @return Posición en id_index, -1 si no esta.
+     */
+    int find_slot(unsigned long long userId)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int slot = TRACED("hash", id_hashing_method(userId, max_size, i));
+            int row = id_index[slot];
+            if (row == EMPTY_ROW)
+                return -1;
+            if (row != DELETED_ROW && TRACED("compare", rows[row].userId == userId))
+                return slot;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Busca la posición de userName en el indice secundario.
+     * @return Posición en name_index, -1 si no esta.
+     */
+    int find_slot(const string &userName)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int slot = TRACED("hash", name_hashing_method(userName, max_size, i));
+            int row = name_index[slot];
+            if (row == EMPTY_ROW)
+                return -1;
+            if (row != DELETED_ROW && TRACED("compare", rows[row].userName == userName))
+                return slot;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Busca la posición del indice que apunta exactamente a row, siguiendo la secuencia de prueba de key.
+     * Se usa al eliminar, ya que podrian haber claves repetidas apuntando a filas distintas.
+     */
+    template <typename Key, typename Method>
+    int find_row(HugePageVector<int> &index, Method hashing_method, const Key &key, int row)
+    {
+        for (int i = 0; i < MAX_ATTEMPTS; i++)
+        {
+            int slot = TRACED("hash", hashing_method(key, max_size, i));
+            if (index[slot] == EMPTY_ROW)
+                return -1;
+            if (index[slot] == row)
+                return slot;
+        }
+        return -1;
+    }
+
+    /**
+     * @brief Elimina una fila de ambos indices y la deja disponible para reutilizarla.
+     */
+    void remove_row(int row)
+    {
+        User &user = rows[row];
+        int id_slot = find_row(id_index, id_hashing_method, user.userId, row);
+        int name_slot = find_row(name_index, name_hashing_method, user.userName, row);
+        if (id_slot >= 0)
+            id_index[id_slot] = DELETED_ROW;
+        if (name_slot >= 0)
+            name_index[name_slot] = DELETED_ROW;
+        tombstones += (id_slot >= 0) + (name_slot >= 0);
+
+        if (track_stats)
+            stats.remove(&user);
+
+        // se libera la memoria de los strings, la fila queda para el próximo insert
+        user = User();
+        free_rows.push_back(row);
+        size--;
+        // los dos indices tienen max_size espacios cada uno
+        if (auto_compact && !compact_failed && tombstones > MAX_TOMBSTONE_RATIO * 2 * max_size)
+            compact();
+    }
+};
+
+#endif
@@ -0,0 +1,532 @@
+#ifndef WAL
+#define WAL
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "functions.h"
+#include "hash_tables.h"
+#include "user_index.h"
+
+using namespace std;
+
+/**
+ * @brief Operaciones que se guardan en el log.
+ */
+enum WalOp : uint8_t
+{
+    WAL_INSERT = 1, ///< Insertar un usuario completo.
+    WAL_UPDATE = 2, ///< Reemplazar el usuario con el mismo userId.
+    WAL_REMOVE = 3, ///< Eliminar un usuario, solo se guardan userId y userName.
+    WAL_CHECKPOINT = 4, ///< Primer registro del snapshot, su lsn es el último que cubre el snapshot.
+};
+
+/**
+ * @brief Un registro leído del log o del snapshot.
+ */
+struct WalRecord
+{
+    unsigned long long lsn; ///< Número de secuencia del registro (crece de a 1).
+    WalOp op;               ///< Operación.
+    User user;              ///< Usuario de la operación (en WAL_REMOVE solo tiene userId y userName).
+};
+
+/**
+ * @brief CRC-32 (polinomio de IEEE, el mismo de zip y ethernet), con la tabla calculada la primera vez.
+ * @param crc CRC de los datos anteriores, para calcularlo por partes.
+ */
+uint32_t crc32(const char *data, size_t length, uint32_t crc = 0)
+{
+    static uint32_t table[256];
+    static bool ready = false;
+    if (!ready)
+    {
+        for (uint32_t i = 0; i < 256; i++)
+        {
+            uint32_t c = i;
+            for (int k = 0; k < 8; k++)
+                c = c & 1 ? 0xedb88320 ^ (c >> 1) : c >> 1;
+            table[i] = c;
+        }
+        ready = true;
+    }
+    crc = ~crc;
+    for (size_t i = 0; i < length; i++)
+        crc = table[(crc ^ (unsigned char)data[i]) & 0xff] ^ (crc >> 8);
+    return ~crc;
+}
+
+/**
+ * @brief Log de escritura anticipada (write-ahead log) para las operaciones sobre los usuarios.
+ *
+ * Cada operación se agrega al final del log antes de aplicarla a la tabla, así después de una caída se puede
+ * reconstruir cualquier tabla con el último snapshot más el log (recover()) sin volver a leer el CSV.
+ *
+ * Formato de cada registro: largo (4 bytes), CRC-32 (4 bytes) y luego lsn (8), operación (1) y el usuario.
+ * El CRC cubre todo lo que va después de él, si el último registro quedó a medio escribir (o corrupto)
+ * recover() lo descarta y corta el log ahí.
+ *
+ * Commit en grupo: los registros se juntan en memoria y se escriben con un solo write + fsync cuando hay
+ * group_size pendientes o cuando el primero lleva más de max_delay_us esperando (lo que pase primero).
+ * Con group_size = 1 cada operación es durable al volver, con grupos más grandes se hacen menos fsync
+ * (más operaciones por segundo) a cambio de perder a lo más el último grupo si se cae el programa.
+ *
+ * @note No hay un hilo aparte: el plazo max_delay_us se revisa al agregar el siguiente registro,
+ * por lo que hay que llamar a commit() antes de esperar por otras cosas (el destructor también lo llama).
+ */
+class WriteAheadLog
+{
+public:
+    string log_path;             ///< Archivo del log.
+    string snapshot_path;        ///< Archivo del snapshot.
+    int group_size;              ///< Registros por commit.
+    long long max_delay_us;      ///< Espera máxima de un registro antes del commit, 0 para no tener plazo.
+    unsigned long long next_lsn = 1; ///< lsn del próximo registro.
+    size_t records = 0;          ///< Registros agregados.
+    size_t fsyncs = 0;           ///< Commits hechos.
+
+    /**
+     * @brief Constructor del log, no lee nada: llamar a recover() antes de agregar registros si los archivos existen.
+     * @param log_path Archivo del log, se crea si no existe.
+     * @param snapshot_path Archivo del snapshot.
+     * @param group_size Registros por commit (1 = un fsync por operación).
+     * @param max_delay_us Espera máxima en microsegundos de un registro antes del commit, 0 para no tener plazo.
+     */
+    WriteAheadLog(const string &log_path, const string &snapshot_path, int group_size = 1, long long max_delay_us = 0)
+        : log_path(log_path), snapshot_path(snapshot_path), group_size(group_size), max_delay_us(max_delay_us)
+    {
+        fd = open(log_path.c_str(), O_WRONLY | O_APPEND | O_CREAT, 0644);
+        if (fd < 0)
+            cout << "No se pudo abrir el log " << log_path << endl;
+    }
+
+    WriteAheadLog(const WriteAheadLog &) = delete;
+    WriteAheadLog &operator=(const WriteAheadLog &) = delete;
+
+    ~WriteAheadLog()
+    {
+        commit();
+        if (fd >= 0)
+            close(fd);
+    }
+
+    /**
+     * @brief Agrega la inserción de un usuario.
+     */
+    void log_insert(const User &user)
+    {
+        append(WAL_INSERT, user);
+    }
+
+    /**
+     * @brief Agrega el reemplazo del usuario con el mismo userId por user.
+     */
+    void log_update(const User &user)
+    {
+        append(WAL_UPDATE, user);
+    }
+
+    /**
+     * @brief Agrega la eliminación de un usuario, se guardan sus dos claves para que cualquier tabla lo pueda eliminar.
+     */
+    void log_remove(const User &user)
+    {
+        User keys;
+        keys.userId = user.userId;
+        keys.userName = user.userName;
+        append(WAL_REMOVE, keys);
+    }
+
+    /**
+     * @brief Escribe los registros pendientes y espera a que estén en disco (fsync).
+     * @return false si falló la escritura o el fsync: los registros siguen pendientes y el siguiente commit()
+     * lo vuelve a intentar (sin repetir los bytes que ya se escribieron).
+     */
+    bool commit()
+    {
+        if (fd < 0)
+            return buffer.empty();
+        if (buffer.empty() && !unsynced)
+            return true;
+        size_t written = 0;
+        while (written < buffer.size())
+        {
+            ssize_t result = write(fd, buffer.data() + written, buffer.size() - written);
+            if (result < 0)
+            {
+                if (errno == EINTR)
+                    continue;
+                // lo escrito ya está en el log, si se deja en buffer el siguiente commit lo escribiría dos veces
+                buffer.erase(0, written);
+                unsynced = unsynced || written > 0;
+                cout << "Error al escribir el log " << log_path << endl;
+                return false;
+            }
+            written += result;
+        }
+        buffer.clear();
+        unsynced = true;
+        if (fdatasync(fd) != 0)
+        {
+            cout << "Error al sincronizar el log " << log_path << endl;
+            return false;
+        }
+        unsynced = false;
+        fsyncs++;
+        pending = 0;
+        return true;
+    }
+
+    /**
+     * @brief Guarda un snapshot con todos los usuarios y vacía el log.
+     *
+     * El snapshot se escribe en un archivo temporal que luego se renombra (el cambio es atómico) y guarda el
+     * último lsn que cubre, así si el programa se cae antes de vaciar el log recover() se salta esos registros.
+     * Si algo falla se borra el temporal y no se tocan ni el snapshot anterior ni el log.
+     * @return true si se guardó el snapshot y se vació el log.
+     */
+    bool checkpoint(const vector<const User *> &users)
+    {
+        if (!commit())
+            return false;
+        string data;
+        unsigned long long covered = next_lsn - 1;
+        // el marcador va aunque no haya usuarios, así un snapshot vacío también dice hasta dónde cubre
+        encode(data, covered, WAL_CHECKPOINT, User());
+        for (const User *user : users)
+            encode(data, covered, WAL_INSERT, *user);
+
+        string temporary = snapshot_path + ".tmp";
+        int snapshot = open(temporary.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+        if (snapshot < 0)
+        {
+            cout << "No se pudo escribir el snapshot " << temporary << endl;
+            return false;
+        }
+        size_t written = 0;
+        bool ok = true;
+        while (ok && written < data.size())
+        {
+            ssize_t result = write(snapshot, data.data() + written, data.size() - written);
+            if (result < 0 && errno != EINTR)
+                ok = false;
+            else if (result > 0)
+                written += result;
+        }
+        ok = ok && fsync(snapshot) == 0;
+        ok = close(snapshot) == 0 && ok;
+        ok = ok && rename(temporary.c_str(), snapshot_path.c_str()) == 0;
+        if (!ok)
+        {
+            unlink(temporary.c_str());
+            cout << "No se pudo escribir el snapshot " << snapshot_path << endl;
+            return false;
+        }
+        // el rename tiene que estar en disco antes de vaciar el log, si no una caída podría dejar el snapshot
+        // anterior con el log vacío
+        if (!sync_directory(snapshot_path))
+        {
+            cout << "No se pudo sincronizar el directorio de " << snapshot_path << endl;
+            return false;
+        }
+        if (fd >= 0 && (ftruncate(fd, 0) != 0 || fsync(fd) != 0))
+        {
+            // el snapshot ya cubre el log, recover() se salta los registros que queden
+            cout << "No se pudo vaciar el log " << log_path << endl;
+            return false;
+        }
+        return true;
+    }
+
+    /**
+     * @brief Lee el snapshot y luego el log, y llama apply(WalRecord &&) con cada registro en orden.
+     * Los registros del log que ya estaban en el snapshot se saltan, y si el final del log está incompleto
+     * o corrupto se corta ahí. Al terminar, los nuevos registros siguen la numeración del log.
+     *
+     * @param apply Aplica un registro a la tabla que se está reconstruyendo, por ejemplo
+     * [&](WalRecord &&r) { apply_record(index, move(r)); }.
+     * @return Cantidad de registros aplicados.
+     */
+    template <typename Apply>
+    size_t recover(Apply apply)
+    {
+        size_t applied = 0;
+        unsigned long long covered = 0;
+
+        string snapshot = read_file(snapshot_path);
+        size_t pos = 0;
+        WalRecord record;
+        while (decode(snapshot, pos, record))
+        {
+            covered = record.lsn;
+            if (record.op == WAL_CHECKPOINT)
+                continue;
+            apply(move(record));
+            applied++;
+        }
+        next_lsn = covered + 1;
+
+        string log = read_file(log_path);
+        pos = 0;
+        while (decode(log, pos, record))
+        {
+            next_lsn = record.lsn + 1;
+            if (record.lsn <= covered)
+                continue;
+            apply(move(record));
+            applied++;
+        }
+        // se descarta el registro a medio escribir, si no los siguientes quedarían después de basura
+        if (pos < log.size() && fd >= 0 && ftruncate(fd, pos) == 0)
+            fsync(fd);
+        return applied;
+    }
+
+private:
+    int fd = -1;        ///< Descriptor del log.
+    string buffer;      ///< Registros pendientes de commit.
+    bool unsynced = false; ///< Si hay registros escritos en el log que todavía no pasan por fdatasync.
+    int pending = 0;    ///< Cantidad de registros en buffer.
+    chrono::steady_clock::time_point first_pending; ///< Cuándo se agregó el primer registro pendiente.
+
+    /**
+     * @brief fsync del directorio que contiene path, para que un rename dentro de él quede en disco.
+     */
+    static bool sync_directory(const string &path)
+    {
+        size_t slash = path.rfind('/');
+        string directory = slash == string::npos ? "." : slash == 0 ? "/" : path.substr(0, slash);
+        int dir_fd = open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+        if (dir_fd < 0)
+            return false;
+        bool ok = fsync(dir_fd) == 0;
+        close(dir_fd);
+        return ok;
+    }
+
+    /**
+     * @brief Agrega un registro a los pendientes y hace commit si se completó el grupo o se pasó el plazo.
+     */
+    void append(WalOp op, const User &user)
+    {
+        if (pending == 0)
+            first_pending = chrono::steady_clock::now();
+        encode(buffer, next_lsn++, op, user);
+        pending++;
+        records++;
+
+        if (pending >= group_size)
+            commit();
+        else if (max_delay_us > 0 &&
+                 chrono::duration_cast<chrono::microseconds>(chrono::steady_clock::now() - first_pending).count() >= max_delay_us)
+            commit();
+    }
+
+    static void put(string &out, const void *data, size_t length)
+    {
+        out.append((const char *)data, length);
+    }
+
+    static void put_string(string &out, const string &value)
+    {
+        uint32_t length = value.size();
+        put(out, &length, sizeof(length));
+        out += value;
+    }
+
+    /**
+     * @brief Agrega al final de out el registro (largo, CRC, lsn, operación, usuario).
+     */
+    static void encode(string &out, unsigned long long lsn, WalOp op, const User &user)
+    {
+        size_t start = out.size();
+        uint32_t length = 0, crc = 0;
+        put(out, &length, sizeof(length));
+        put(out, &crc, sizeof(crc));
+        put(out, &lsn, sizeof(lsn));
+        put(out, &op, sizeof(op));
+        put_string(out, user.university);
+        put(out, &user.userId, sizeof(user.userId));
+        put_string(out, user.userName);
+        put(out, &user.numberTweets, sizeof(user.numberTweets));
+        put(out, &user.friendsCount, sizeof(user.friendsCount));
+        put(out, &user.followersCount, sizeof(user.followersCount));
+        put_string(out, user.createdAt);
+
+        size_t body = start + 2 * sizeof(uint32_t);
+        length = out.size() - body;
+        crc = crc32(out.data() + body, length);
+        out.replace(start, sizeof(length), (const char *)&length, sizeof(length));
+        out.replace(start + sizeof(length), sizeof(crc), (const char *)&crc, sizeof(crc));
+    }
+
+    /**
+     * @brief Lee el registro que empieza en data[pos] y avanza pos.
+     * @return false (sin avanzar) si no queda un registro completo con CRC correcto.
+     */
+    static bool decode(const string &data, size_t &pos, WalRecord &record)
+    {
+        uint32_t length, crc;
+        if (pos + 2 * sizeof(uint32_t) > data.size())
+            return false;
+        memcpy(&length, data.data() + pos, sizeof(length));
+        memcpy(&crc, data.data() + pos + sizeof(length), sizeof(crc));
+        size_t body = pos + 2 * sizeof(uint32_t);
+        if (body + length > data.size() || crc32(data.data() + body, length) != crc)
+            return false;
+
+        size_t at = body, end = body + length;
+        auto get = [&](void *out, size_t size)
+        {
+            if (at + size > end)
+                return false;
+            memcpy(out, data.data() + at, size);
+            at += size;
+            return true;
+        };
+        auto get_string = [&](string &out)
+        {
+            uint32_t size;
+            if (!get(&size, sizeof(size)) || at + size > end)
+                return false;
+            out.assign(data, at, size);
+            at += size;
+            return true;
+        };
+        string created;
+        User &user = record.user;
+        bool ok = get(&record.lsn, sizeof(record.lsn)) && get(&record.op, sizeof(record.op)) &&
+                  get_string(user.university) && get(&user.userId, sizeof(user.userId)) &&
+                  get_string(user.userName) && get(&user.numberTweets, sizeof(user.numberTweets)) &&
+                  get(&user.friendsCount, sizeof(user.friendsCount)) &&
+                  get(&user.followersCount, sizeof(user.followersCount)) && get_string(created);
+        if (!ok)
+            return false;
+        user.createdAtEpoch = parseCreatedAt(created);
+        user.createdAt = move(created);
+        pos = end;
+        return true;
+    }
+
+    static string read_file(const string &path)
+    {
+        ifstream file(path, ios::binary);
+        stringstream content;
+        content << file.rdbuf();
+        return content.str();
+    }
+};
+
+//--- Aplicar registros del log a cada tipo de tabla ---
+
+/**
+ * @brief Aplica un registro a un UserIndex (WAL_UPDATE reemplaza el usuario con el mismo userId en su fila).
+ */
+void apply_record(UserIndex &index, WalRecord &&record)
+{
+    if (record.op == WAL_INSERT)
+        index.insert(move(record.user));
+    else if (record.op == WAL_UPDATE)
+        index.update(move(record.user));
+    else
+        index.remove_by_id(record.user.userId);
+}
+
+/**
+ * @brief Aplica un registro a una tabla cerrada por userId.
+ */
+void apply_record(CloseHashTableUserId &table, WalRecord &&record)
+{
+    if (record.op != WAL_INSERT)
+        table.remove(record.user.userId);
+    if (record.op != WAL_REMOVE)
+        table.insert(move(record.user));
+}
+
+/**
+ * @brief Aplica un registro a una tabla cerrada por userName.
+ * @note WAL_UPDATE se aplica por userName, por lo que la tabla solo se mantiene correcta si el update no cambia el nombre.
+ */
+void apply_record(CloseHashTableUserName &table, WalRecord &&record)
+{
+    if (record.op != WAL_INSERT)
+        table.remove(record.user.userName);
+    if (record.op != WAL_REMOVE)
+        table.insert(move(record.user));
+}
+
+/**
+ * @brief Aplica un registro a una tabla abierta por userId. La tabla no es dueña de los usuarios, por lo que los
+ * recuperados se guardan en store (en un deque los punteros no se invalidan al agregar).
+ */
+void apply_record(OpenHashTableUserId &table, deque<User> &store, WalRecord &&record)
+{
+    if (record.op != WAL_INSERT)
+        table.remove(record.user.userId);
+    if (record.op != WAL_REMOVE)
+    {
+        store.push_back(move(record.user));
+        table.insert(store.back().userId, &store.back());
+    }
+}
+
+/**
+ * @brief Aplica un registro a una tabla abierta por userName, los usuarios se guardan en store.
+ * @note Igual que en la tabla cerrada, WAL_UPDATE solo se mantiene correcto si no cambia el nombre.
+ */
+void apply_record(OpenHashTableUserName &table, deque<User> &store, WalRecord &&record)
+{
+    if (record.op != WAL_INSERT)
+        table.remove(record.user.userName);
+    if (record.op != WAL_REMOVE)
+    {
+        store.push_back(move(record.user));
+        table.insert(store.back().userName, &store.back());
+    }
+}
+
+/**
+ * @brief Aplica un registro a una tabla que guarda posiciones de su vector rows (NodePoolHashTable y
+ * BucketHashTable): el usuario se agrega al final de rows. Las filas de los eliminados quedan en rows sin usarse.
+ */
+template <typename Key, typename Table>
+void apply_record_to_rows(Table &table, WalRecord &&record)
+{
+    if (record.op != WAL_INSERT)
+        table.remove(UserKey<Key>::get(record.user));
+    if (record.op != WAL_REMOVE)
+    {
+        table.rows->push_back(move(record.user));
+        table.insert(UserKey<Key>::get(table.rows->back()), table.rows->size() - 1);
+    }
+}
+
+/**
+ * @brief Aplica un registro a una NodePoolHashTable, el usuario se agrega a su vector rows.
+ */
+template <typename Key>
+void apply_record(NodePoolHashTable<Key> &table, WalRecord &&record)
+{
+    apply_record_to_rows<Key>(table, move(record));
+}
+
+/**
+ * @brief Aplica un registro a una BucketHashTable, el usuario se agrega a su vector rows.
+ */
+template <typename Key>
+void apply_record(BucketHashTable<Key> &table, WalRecord &&record)
+{
+    apply_record_to_rows<Key>(table, move(record));
+}
+
+#endif